@@ -0,0 +1,153 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   libminishell.h                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#ifndef LIBMINISHELL_H
+# define LIBMINISHELL_H
+
+/*
+ * Embedding API of libminishell.a
+ *
+ * A host process keeps one or more warm shells and runs command lines in
+ * them without starting a new process per line. Link with
+ * libminishell.a -lreadline.
+ *
+ *   t_shell     *sh;
+ *   t_shell_ast *ast;
+ *
+ *   sh = shell_create(environ);
+ *   ast = shell_parse(sh, "ls -l | wc -l > /tmp/count");
+ *   if (ast)
+ *       shell_execute(sh, ast);
+ *   shell_ast_free(ast);
+ *   printf("%d\n", shell_exit_status(sh));
+ *   shell_destroy(sh);
+ *
+ * An embedded shell never touches the terminal, readline or the history
+ * file, and it leaves the host's SIGINT and SIGQUIT handlers as they
+ * were once a call returns. Commands still read the host's stdin and
+ * write to its stdout and stderr, and heredoc bodies are read from
+ * stdin while a line containing them is parsed.
+ *
+ * Shells are independent of each other: each has its own environment,
+ * functions, caches, signal state, heredoc files and working directory.
+ * The process has only one working directory, so every call moves into
+ * the shell's own and moves the host back to its directory on return.
+ * Buffered builtin output is process-wide too, and is written out before
+ * every call returns. The calls are not thread-safe; call into the
+ * library from one thread at a time. Allocation and runtime counters
+ * (memstats, shellstats) are per process.
+ */
+
+typedef struct s_shell		t_shell;
+typedef struct s_shell_ast	t_shell_ast;
+
+/**
+ * Create a shell without a terminal
+ * @param envp Initial environment, NULL-terminated KEY=VALUE strings
+ * @return New shell or NULL on error
+ */
+t_shell		*shell_create(char **envp);
+
+/**
+ * Destroy a shell and everything it owns
+ * Parsed ASTs are independent of the shell and must be freed separately
+ * @param shell Shell to destroy, may be NULL
+ */
+void		shell_destroy(t_shell *shell);
+
+/**
+ * Parse a command line into an AST that can be executed many times
+ * A line with heredocs reads their bodies now; the temporary files
+ * holding them are removed by shell_ast_free
+ * @param shell Shell whose state (exit status for heredocs) is used
+ * @param line Command line
+ * @return AST, or NULL on a syntax error (exit status 2) or empty line
+ */
+t_shell_ast	*shell_parse(t_shell *shell, const char *line);
+
+/**
+ * Execute a parsed AST, expanding words against the current state
+ * @param shell Shell to run in
+ * @param ast AST from shell_parse
+ * @return Exit status of the last pipeline
+ */
+int			shell_execute(t_shell *shell, t_shell_ast *ast);
+
+/**
+ * Free an AST
+ * @param ast AST to free, may be NULL
+ */
+void		shell_ast_free(t_shell_ast *ast);
+
+/**
+ * Parse, execute and free a command line in one call
+ * @param shell Shell to run in
+ * @param line Command line
+ * @return Exit status
+ */
+int			shell_run(t_shell *shell, const char *line);
+
+/**
+ * Get the exit status of the last command
+ * @param shell Shell
+ * @return Exit status
+ */
+int			shell_exit_status(t_shell *shell);
+
+/**
+ * Check whether the shell is still accepting commands
+ * @param shell Shell
+ * @return 0 once the exit builtin ran, 1 otherwise
+ */
+int			shell_is_running(t_shell *shell);
+
+/**
+ * Get a variable of the shell's environment
+ * @param shell Shell
+ * @param name Variable name
+ * @return Value owned by the shell, valid until the variable changes,
+ *         or NULL if unset
+ */
+const char	*shell_getenv(t_shell *shell, const char *name);
+
+/**
+ * Set a variable of the shell's environment
+ * @param shell Shell
+ * @param name Variable name
+ * @param value New value
+ * @return 0 on success, -1 on error
+ */
+int			shell_setenv(t_shell *shell, const char *name, const char *value);
+
+/**
+ * Remove a variable from the shell's environment
+ * @param shell Shell
+ * @param name Variable name
+ * @return 0 on success, -1 on error
+ */
+int			shell_unsetenv(t_shell *shell, const char *name);
+
+/**
+ * Get the shell's environment as KEY=VALUE strings
+ * @param shell Shell
+ * @return NULL-terminated array to release with shell_environ_free,
+ *         or NULL on error
+ */
+char		**shell_environ(t_shell *shell);
+
+/**
+ * Free an array returned by shell_environ
+ * @param env Array to free, may be NULL
+ */
+void		shell_environ_free(char **env);
+
+#endif
@@ -29,20 +29,29 @@
 #  include <fcntl.h>
 #  include <sys/wait.h>
 #  include <sys/stat.h>
+#  include <sys/mman.h>
 #  include <sys/types.h>
+#  include <sys/resource.h>
 #  include <dirent.h>
 #  include <signal.h>
 #  include <termios.h>
+#  include <time.h>
+#  include <regex.h>
 # endif
 
 # include <readline/readline.h>
 # include <readline/history.h>
 
+# include "libminishell.h"
+
 /* Error codes */
 # define SUCCESS 0
 # define ERROR 1
 # define SYNTAX_ERROR 2
+# define CMD_NOT_EXEC 126
 # define CMD_NOT_FOUND 127
+# define TIMEOUT_EXPIRED 124
+# define TIMEOUT_FAILED 125
 
 /* Token types for lexer/parser */
 typedef enum e_token_type
@@ -54,34 +63,232 @@ typedef enum e_token_type
 	TOKEN_HEREDOC,
 	TOKEN_REDIRECT_OUT,
 	TOKEN_REDIRECT_APPEND,
+	TOKEN_SEMI,
+	TOKEN_LPAREN,
+	TOKEN_RPAREN,
 	TOKEN_EOF
 }	t_token_type;
 
+/* Word segment types */
+typedef enum e_seg_type
+{
+	SEG_LITERAL,
+	SEG_SQUOTE,
+	SEG_DQUOTE,
+	SEG_PARAM
+}	t_seg_type;
+
+/* One piece of a word as the lexer saw it
+ * text is the literal text, or the parameter name for SEG_PARAM;
+ * quoted is set for segments that appeared inside quotes
+ */
+typedef struct s_segment
+{
+	t_seg_type			type;
+	char				*text;
+	int					quoted;
+	struct s_segment	*next;
+}	t_segment;
+
+/* Shell word: segments plus the quote-removed, unexpanded text */
+typedef struct s_word
+{
+	char			*text;
+	t_segment		*segs;
+	t_segment		*last;
+	int				quoted;
+	int				has_params;
+	struct s_word	*next;
+}	t_word;
+
+/* One directory entry of a cached listing
+ * off is the name's offset into the listing pool while it is being read
+ */
+typedef struct s_dir_entry
+{
+	char			*name;
+	size_t			off;
+	unsigned char	type;
+}	t_dir_entry;
+
+/* Sorted listing of one directory, read once per command line */
+typedef struct s_dir_listing
+{
+	char					*path;
+	unsigned long			hash;
+	char					*pool;
+	size_t					pool_len;
+	t_dir_entry				*entries;
+	int						count;
+	struct s_dir_listing	*next;
+}	t_dir_listing;
+
+/* Directory listings keyed by path, cleared after each command line */
+# define GLOB_CACHE_BUCKETS 64
+
+typedef struct s_glob_cache
+{
+	t_dir_listing	*buckets[GLOB_CACHE_BUCKETS];
+	unsigned long	reads;
+	unsigned long	hits;
+}	t_glob_cache;
+
+/* Compiled =~ patterns of [[, one slot per pattern hash */
+# define REGEX_CACHE_SLOTS 32
+
+typedef struct s_regex_entry
+{
+	char	*pattern;
+	regex_t	re;
+}	t_regex_entry;
+
+typedef struct s_regex_cache
+{
+	t_regex_entry	slots[REGEX_CACHE_SLOTS];
+	unsigned long	compiles;
+	unsigned long	hits;
+}	t_regex_cache;
+
+/* Compiled glob pattern element */
+typedef enum e_glob_op
+{
+	GLOB_CHAR,
+	GLOB_ANY,
+	GLOB_STAR,
+	GLOB_CLASS
+}	t_glob_op;
+
+/* set is a 256-bit character set for GLOB_CLASS (negation applied) */
+typedef struct s_glob_tok
+{
+	t_glob_op		op;
+	unsigned char	c;
+	unsigned char	set[32];
+}	t_glob_tok;
+
+/* One path component of a pattern; literal is set when it has no magic */
+typedef struct s_glob_comp
+{
+	t_glob_tok	*toks;
+	int			count;
+	char		*literal;
+}	t_glob_comp;
+
+/* Field being built during word expansion
+ * active is set once the field must be emitted even if it stays empty;
+ * quoted glob characters (and backslashes) are stored escaped with '\\'
+ * and has_glob records an unquoted '*', '?' or '['
+ */
+typedef struct s_field_buf
+{
+	char	*data;
+	size_t	len;
+	size_t	cap;
+	int		active;
+	int		has_glob;
+	int		escaped;
+}	t_field_buf;
+
+/* NULL-terminated list of expanded fields
+ * glob is the directory cache used for pathname expansion, NULL disables it;
+ * patterns keeps every word as exactly one field in its escaped pattern
+ * form, as the operands of [[ need
+ */
+typedef struct s_fields
+{
+	char			**items;
+	int				count;
+	int				cap;
+	t_glob_cache	*glob;
+	int				patterns;
+}	t_fields;
+
+/* State of one pathname expansion; path holds the prefix being walked */
+# define GLOB_PATH_MAX 4096
+
+typedef struct s_glob_walk
+{
+	t_glob_cache	*cache;
+	t_glob_comp		*comps;
+	int				ncomp;
+	int				dir_only;
+	int				matches;
+	t_fields		*out;
+	char			path[GLOB_PATH_MAX];
+}	t_glob_walk;
+
 /* Token structure for lexical analysis */
 typedef struct s_token
 {
 	t_token_type	type;
 	char			*value;
+	t_word			*word;
 	struct s_token	*next;
 }	t_token;
 
-/* Command redirection structure */
+/* Command redirection structure
+ * word is the target as written on the command line, file is the
+ * expanded path that is (re)computed each time the command runs
+ */
 typedef struct s_redirection
 {
 	t_token_type			type;
+	t_word					*word;
 	char					*file;
 	struct s_redirection	*next;
 }	t_redirection;
 
-/* Command structure */
+/* Command node types */
+typedef enum e_cmd_type
+{
+	CMD_SIMPLE,
+	CMD_FUNCDEF
+}	t_cmd_type;
+
+/* Command structure
+ * words holds the unexpanded arguments and survives across executions,
+ * args holds the expanded argv of the current execution
+ */
 typedef struct s_command
 {
+	t_cmd_type			type;
+	t_word				*words;
 	char				**args;
 	t_redirection		*redirections;
+	char				*func_name;
+	struct s_command	*body;
 	struct s_command	*next;
 	int					pipe_out;
 }	t_command;
 
+/* Growable buffer an AST is serialized into; failed is set when it
+ * could not grow
+ */
+typedef struct s_ast_buf
+{
+	char	*data;
+	size_t	len;
+	size_t	cap;
+	int		failed;
+}	t_ast_buf;
+
+/* Cursor over a serialized AST; failed is set on short or bad input */
+typedef struct s_ast_reader
+{
+	const char	*p;
+	size_t		left;
+	int			failed;
+}	t_ast_reader;
+
+/* Supplier of heredoc body lines while a script runs from something
+ * other than stdin; next returns a tracked line or NULL at the end
+ */
+typedef struct s_line_source
+{
+	char	*(*next)(void *ctx);
+	void	*ctx;
+}	t_line_source;
+
 /* Environment variable structure */
 typedef struct s_env
 {
@@ -90,8 +297,323 @@ typedef struct s_env
 	struct s_env	*next;
 }	t_env;
 
-/* Shell state structure */
-typedef struct s_shell
+/* Shell function table entry */
+typedef struct s_func
+{
+	char			*name;
+	t_command		*body;
+	int				refs;
+	int				defunct;
+	struct s_func	*next;
+}	t_func;
+
+/* Function call frame holding positional parameters and locals */
+typedef struct s_frame
+{
+	int				argc;
+	char			**argv;
+	t_env			*locals;
+	struct s_frame	*prev;
+}	t_frame;
+
+/* Parse cache entry: a line and its parsed, unexpanded AST */
+typedef struct s_parse_entry
+{
+	unsigned long			hash;
+	char					*line;
+	t_command				*commands;
+	int						busy;
+	struct s_parse_entry	*hnext;
+	struct s_parse_entry	*prev;
+	struct s_parse_entry	*next;
+}	t_parse_entry;
+
+/* LRU cache of parsed command lines keyed by line hash */
+# define PARSE_CACHE_SIZE 64
+# define PARSE_CACHE_BUCKETS 128
+
+typedef struct s_parse_cache
+{
+	t_parse_entry	*buckets[PARSE_CACHE_BUCKETS];
+	t_parse_entry	*head;
+	t_parse_entry	*tail;
+	int				count;
+	unsigned long	hits;
+	unsigned long	misses;
+}	t_parse_cache;
+
+/* Resolved command paths keyed by name, valid for one value of $PATH */
+# define PATH_CACHE_BUCKETS 64
+
+typedef struct s_path_entry
+{
+	char				*name;
+	char				*path;
+	struct s_path_entry	*next;
+}	t_path_entry;
+
+typedef struct s_path_cache
+{
+	t_path_entry	*buckets[PATH_CACHE_BUCKETS];
+	char			*path_env;
+}	t_path_cache;
+
+/* Runtime counters reported by shellstats */
+typedef enum e_stat
+{
+	STAT_COMMANDS,
+	STAT_FORKS,
+	STAT_EXECS,
+	STAT_BUILTINS,
+	STAT_PATH_LOOKUPS,
+	STAT_PATH_HITS,
+	STAT_ENV_LOOKUPS,
+	STAT_HEREDOCS,
+	STAT_BUILTIN_BYTES,
+	STAT_WAIT_USEC,
+	STAT_ZYGOTE_LAUNCHES,
+	STAT_COUNT
+}	t_stat;
+
+/* Execution event log, one NDJSON record per pipeline
+ * Records are built per pipeline and appended to a buffer that is
+ * written out with a single write once it fills up or the shell idles
+ */
+# define EVENT_LOG_FLUSH 16384
+
+typedef struct s_event_stage
+{
+	pid_t			pid;
+	char			*path;
+	long			start;
+	long			end;
+	int				has_usage;
+	struct rusage	usage;
+}	t_event_stage;
+
+typedef struct s_event_pipe
+{
+	int				enabled;
+	int				open;
+	int				stages;
+	char			*buf;
+	size_t			len;
+	size_t			cap;
+	t_event_stage	*saved;
+}	t_event_pipe;
+
+typedef struct s_event_log
+{
+	int				fd;
+	char			*path;
+	int				synced;
+	unsigned long	generation;
+	pid_t			shell_pid;
+	char			*buf;
+	size_t			len;
+	size_t			cap;
+	t_event_stage	*stage;
+}	t_event_log;
+
+/* Deadline of a stage run through the timeout builtin
+ * active stages run in a process group of their own, which is sent
+ * signal at deadline (CLOCK_MONOTONIC microseconds, 0 for none) and
+ * SIGKILL kill_after microseconds later if it is still running
+ */
+typedef struct s_timeout
+{
+	int				active;
+	int				signal;
+	int				expired;
+	long			deadline;
+	long			kill_after;
+}	t_timeout;
+
+/* One stage of a pipeline
+ * Every stage is launched before the shell waits for any of them; pid is
+ * the child still to be reaped, or 0 once status is known; next_in is
+ * the read end of the stage's output pipe (-1 for the last stage), which
+ * the child closes so it sees EPIPE once the reader is gone
+ */
+typedef struct s_stage
+{
+	t_command		*cmd;
+	pid_t			pid;
+	int				next_in;
+	int				status;
+	t_timeout		timeout;
+	t_event_stage	event;
+}	t_stage;
+
+/* Pool of pre-forked helpers that exec external commands on request
+ * Enabled by MINISHELL_ZYGOTES=N; the pool is refilled while the prompt
+ * waits for input, so a launch only sends argv, envp and fds to a
+ * process that already exists
+ */
+# define ZYGOTE_MAX 8
+
+typedef struct s_zygote_pool
+{
+	int				size;
+	int				count;
+	int				synced;
+	unsigned long	generation;
+	pid_t			pid[ZYGOTE_MAX];
+	int				sock[ZYGOTE_MAX];
+}	t_zygote_pool;
+
+/* Buffer size of the pipes between stages, from MINISHELL_PIPE_SIZE
+ * bytes is 0 to keep the kernel default
+ */
+typedef struct s_pipe_size
+{
+	int				synced;
+	unsigned long	generation;
+	int				bytes;
+}	t_pipe_size;
+
+/* Current directory as the shell tracks it
+ * logical is $PWD as navigated (symlinks kept), physical is the resolved
+ * path filled in lazily; dev/ino identify the directory we are in so a
+ * stale logical path can be detected with one stat, and fd holds it open
+ * so an embedded shell can return to it after another shell moved away
+ */
+typedef struct s_cwd
+{
+	char			*logical;
+	char			*physical;
+	dev_t			dev;
+	ino_t			ino;
+	int				fd;
+	unsigned long	generation;
+}	t_cwd;
+
+/* Prompt template element */
+typedef enum e_prompt_op
+{
+	PROMPT_TEXT,
+	PROMPT_USER,
+	PROMPT_CWD,
+	PROMPT_CWD_BASE,
+	PROMPT_STATUS,
+	PROMPT_STATUS_MARK
+}	t_prompt_op;
+
+typedef struct s_prompt_seg
+{
+	t_prompt_op				op;
+	char					*text;
+	struct s_prompt_seg		*next;
+}	t_prompt_seg;
+
+/* Compiled prompt template and its last rendering
+ * The rendering in buf is reused while the cwd generation, the exit
+ * status and the environment generation are unchanged
+ */
+# define DEFAULT_PS1 "\\[\\e[36m\\]\\u\\[\\e[0m\\]:\\[\\e[34m\\]\\W\\[\\e[0m\\] \\S $ "
+
+typedef struct s_prompt
+{
+	char			*source;
+	t_prompt_seg	*segs;
+	char			*buf;
+	size_t			len;
+	size_t			cap;
+	int				valid;
+	unsigned long	cwd_gen;
+	unsigned long	env_gen;
+	int				status;
+	unsigned long	renders;
+	unsigned long	reuses;
+}	t_prompt;
+
+/* Posting list of a trigram: ascending ids of entries containing it */
+typedef struct s_trigram
+{
+	unsigned int		key;
+	int					*ids;
+	int					count;
+	int					cap;
+	struct s_trigram	*next;
+}	t_trigram;
+
+/* Trigram index over history entries
+ * Entries live in a ring indexed by id % cap; ids in [first, next) are
+ * live. An entry's postings are removed when its slot is reused.
+ */
+# define HIST_INDEX_BUCKETS 4096
+
+typedef struct s_hist_index
+{
+	char		**entries;
+	int			cap;
+	int			first;
+	int			next;
+	t_trigram	*buckets[HIST_INDEX_BUCKETS];
+}	t_hist_index;
+
+/* Command history persisted to HISTFILE
+ * fd is the history file opened with O_APPEND, last the newest entry
+ */
+# define HISTSIZE_DEFAULT 500
+
+typedef struct s_history
+{
+	int				fd;
+	int				size;
+	char			*last;
+	int				loaded;
+	t_hist_index	index;
+}	t_history;
+
+/* Startup profile, one entry per timed init step
+ * since is the end of the previous step, start the beginning of startup
+ */
+# define PROFILE_MAX_STEPS 16
+
+typedef struct s_profile
+{
+	int				enabled;
+	int				count;
+	const char		*names[PROFILE_MAX_STEPS];
+	long			usec[PROFILE_MAX_STEPS];
+	struct timespec	start;
+	struct timespec	since;
+}	t_profile;
+
+/* Command line options of the minishell binary */
+typedef struct s_options
+{
+	int		profile;
+	char	*command;
+	char	*serve;
+}	t_options;
+
+/* Maximum function call nesting */
+# define FUNC_MAX_DEPTH 1000
+
+/* Subsystems that shell allocations are charged to */
+typedef enum e_mem_tag
+{
+	MEM_OTHER,
+	MEM_LEXER,
+	MEM_PARSER,
+	MEM_ENV,
+	MEM_HEREDOC,
+	MEM_EXECUTOR,
+	MEM_TAGS
+}	t_mem_tag;
+
+typedef struct s_mem_stats
+{
+	size_t			live;
+	size_t			peak;
+	unsigned long	allocs;
+	unsigned long	frees;
+}	t_mem_stats;
+
+/* Shell state structure, t_shell is declared by the public API header */
+struct s_shell
 {
 	t_env		*env_list;
 	int			exit_status;
@@ -103,20 +625,90 @@ typedef struct s_shell
 	int			heredoc_active;
 	char		*heredoc_file;
 	int			signal_state;
-}	t_shell;
-
-/* Global signal variable - stores only the signal number 
- * Volatile ensures it's not optimized out by compiler
- * sig_atomic_t ensures atomic access to prevent race conditions
- */
-extern volatile sig_atomic_t g_received_signal;
+	t_func		*functions;
+	t_frame		*frames;
+	int			func_depth;
+	int			func_return;
+	int			source_depth;
+	t_line_source	*line_source;
+	t_parse_cache	parse_cache;
+	t_parse_entry	*cached_entry;
+	t_glob_cache	glob_cache;
+	t_regex_cache	regex_cache;
+	t_cwd			cwd;
+	t_prompt		prompt;
+	t_history		history;
+	t_profile		profile;
+	int				interactive;
+	t_path_cache	path_cache;
+	char			*exec_path;
+	int				exec_err;
+	t_event_log		events;
+	t_zygote_pool	zygotes;
+	t_pipe_size		pipe_size;
+	volatile sig_atomic_t	received_signal;
+	int				heredoc_count;
+	int				signal_fd;
+};
+
+/* Lexer character classes */
+# define CHAR_SPACE 0x01
+# define CHAR_OPERATOR 0x02
+# define CHAR_QUOTE 0x04
+# define CHAR_DOLLAR 0x08
+
+/* Per-class bitmasks for a 32-byte block, bit n describes byte n */
+typedef struct s_scan_block
+{
+	unsigned int	space;
+	unsigned int	oper;
+	unsigned int	quote;
+	unsigned int	dollar;
+	unsigned int	nul;
+}	t_scan_block;
+
+/* Lexer scanning */
+int			char_class(char c);
+void		classify_block(const char *p, t_scan_block *block);
+size_t		scan_until(const char *s, size_t i, size_t len, int classes);
+size_t		scan_skip(const char *s, size_t i, size_t len, int classes);
 
 /* Parser functions */
 t_token		*tokenize_input(char *input);
 void		free_tokens(t_token *tokens);
 t_command	*parse_tokens(t_token *tokens, t_shell *shell);
 void		free_commands(t_command *commands);
-int			expand_variables(t_token *tokens, t_env *env_list, int exit_status);
+t_command	*copy_commands(t_command *commands);
+t_command	*create_command(void);
+t_redirection	*create_redirection(t_token_type type, t_word *word);
+
+/* Serialized ASTs */
+void		ast_put(t_ast_buf *buf, const void *data, size_t len);
+void		ast_put_u32(t_ast_buf *buf, unsigned int value);
+void		ast_put_string(t_ast_buf *buf, const char *s);
+void		ast_put_commands(t_ast_buf *buf, t_command *commands);
+int			ast_get(t_ast_reader *in, void *dst, size_t len);
+unsigned int	ast_get_u32(t_ast_reader *in);
+char		*ast_get_string(t_ast_reader *in);
+t_command	*ast_get_commands(t_ast_reader *in);
+
+/* Words and expansion */
+t_word		*new_word(void);
+int			word_add_segment(t_word *word, t_seg_type type, char *text,
+				int len);
+t_word		*word_from_text(char *text);
+t_word		*copy_word(t_word *word);
+t_word		*copy_words(t_word *words);
+void		free_words(t_word *words);
+int			expand_command(t_command *cmd, t_shell *shell);
+int			fields_push(t_fields *fields, char *item);
+void		unescape_field(char *s);
+
+/* Pathname expansion */
+int			glob_expand(t_glob_cache *cache, char *pattern, t_fields *out);
+int			glob_match(t_glob_tok *toks, int count, const char *name);
+int			glob_pattern_match(char *pattern, char *text);
+void		glob_cache_clear(t_glob_cache *cache);
 char		*finalize_word(char *value, char *input, int start, int end);
 t_token		*handle_operator_token(const char *str, int *index);
 int			is_delimiter(char c);
@@ -124,17 +716,34 @@ int			is_whitespace(char c);
 int			handle_quoted_word(char **value, char *input, int *i);
 
 
+/* Parse cache */
+t_parse_entry	*parse_cache_lookup(t_parse_cache *cache, char *line);
+t_parse_entry	*parse_cache_insert(t_parse_cache *cache, char *line,
+					t_command *commands);
+void		parse_cache_clear(t_parse_cache *cache);
+unsigned long	hash_line(char *line);
+unsigned long	hash_bytes(const char *data, size_t len);
+int			is_cacheable_line(t_token *tokens);
+
 /* Environment functions */
 t_env		*init_env(char **envp);
 void		free_env(t_env *env_list);
+t_env		*env_dup(t_env *env_list);
 char		*get_env_value(t_env *env_list, char *key);
+unsigned long	env_generation(int bump);
 int			set_env_value(t_env *env_list, char *key, char *value);
 int			unset_env_value(t_env **env_list, char *key);
 char		**env_to_array(t_env *env_list);
 
 /* Builtin function declarations - basic commands */
 int			builtin_echo(t_command *cmd, t_shell *shell);
+int			builtin_printf(t_command *cmd, t_shell *shell);
 int			builtin_pwd(t_command *cmd, t_shell *shell);
+int			builtin_cat(t_command *cmd, t_shell *shell);
+int			cat_is_plain(char **args);
+int			builtin_read(t_command *cmd, t_shell *shell);
+int			builtin_test(t_command *cmd, t_shell *shell);
+void		regex_cache_clear(t_regex_cache *cache);
 
 /* Builtin function declarations - directory operations */
 int			builtin_cd(t_command *cmd, t_shell *shell);
@@ -147,7 +756,37 @@ int			builtin_env(t_command *cmd, t_shell *shell);
 /* Builtin function declarations - shell control */
 int			builtin_exit(t_command *cmd, t_shell *shell);
 
+/* Builtin function declarations - functions */
+int			builtin_local(t_command *cmd, t_shell *shell);
+int			builtin_return(t_command *cmd, t_shell *shell);
+int			builtin_source(t_command *cmd, t_shell *shell);
+
+/* Builtin function declarations - statistics */
+int			builtin_parsecache(t_command *cmd, t_shell *shell);
+int			builtin_memstats(t_command *cmd, t_shell *shell);
+int			builtin_shellstats(t_command *cmd, t_shell *shell);
+int			builtin_history(t_command *cmd, t_shell *shell);
+
+/* Shell functions and call frames */
+t_func		*find_function(t_shell *shell, char *name);
+int			define_function(t_shell *shell, char *name, t_command *body);
+int			unset_function(t_shell *shell, char *name);
+int			call_function(t_func *func, t_command *cmd, t_shell *shell);
+int			push_frame(t_shell *shell, char **args);
+void		pop_frame(t_shell *shell);
+void		free_functions(t_func *functions);
+int			copy_functions(t_shell *shell, t_func *functions, t_func **copy);
+char		*lookup_variable(t_shell *shell, char *name);
+int			set_local_variable(t_shell *shell, char *key, char *value);
+int			assign_variable(t_shell *shell, char *key, char *value);
+int			assign_list(t_shell *shell, char *name, char **items, int count);
+
+/* timeout builtin */
+int			timeout_prepare(t_stage *stage, t_command *cmd);
+
 /* Builtin utility functions */
+ssize_t		builtin_write(int fd, const void *buf, size_t len);
+int			builtin_flush(void);
 int			is_valid_variable_name(char *var);
 int			parse_variable_assignment(char *arg, char **key, char **value);
 int			is_numeric(char *str);
@@ -156,8 +795,10 @@ int			is_numeric(char *str);
 int			execute_commands(t_command *commands, t_shell *shell);
 int			execute_builtin(t_command *cmd, t_shell *shell);
 int			is_builtin(char *cmd);
-int			execute_single_command(t_command *cmd, t_shell *shell, 
-				int in_fd, int out_fd);
+int			runs_as_builtin(char **args);
+int			launch_stage(t_stage *stage, t_shell *shell, int in_fd,
+				int out_fd);
+int			wait_pipeline(t_shell *shell, t_stage *stages, int count);
 int			execute_child_process(t_command *cmd, t_shell *shell,
 				int in_fd, int out_fd);
 int			execute_builtin_directly(t_command *cmd, t_shell *shell, int out_fd);
@@ -169,16 +810,20 @@ int			cleanup_all_heredocs(t_command *commands);
 int			is_heredoc_file(char *filename);
 
 /* Executor path resolution */
-char		*find_command_path(char *cmd, t_env *env_list); /* Returns NULL if command not found */
+char		*find_command_path(char *cmd, char *path_env, int *err);
+char		*path_cache_resolve(t_shell *shell, char *name, int *err);
+void		path_cache_clear(t_path_cache *cache);
 
 /* Executor utility functions */
 int			save_std_fds(int saved_fds[2]);
 int			restore_std_fds(int saved_fds[2]);
 int			get_exit_status(int status);
+long		monotonic_usec(void);
+void		pipe_apply_size(t_shell *shell, int fd);
 int			free_string_array(char **arr);
+char		**dup_string_array(char **arr);
 
 /* Utility functions */
-void		*ft_malloc(size_t size);
 char		*ft_strdup(const char *s);
 char		*ft_substr(char const *s, unsigned int start, size_t len);
 int			ft_strcmp(const char *s1, const char *s2);
@@ -195,6 +840,8 @@ char		*ft_itoa(int n);
 int			ft_atoi(const char *str);
 char		*ft_strchr(const char *s, int c);
 void		*ft_memset(void *b, int c, size_t len);
+void		*ft_memcpy(void *dst, const void *src, size_t n);
+void		*ft_memchr(const void *s, int c, size_t n);
 char		*ft_strrchr(const char *s, int c);
 char		*ft_strstr(char *str, char *to_find);
 void		ft_putchar_fd(char c, int fd);
@@ -211,18 +858,29 @@ void		handle_sigint_heredoc(int sig);
 void		handle_sigquit_interactive(int sig);
 void		handle_sigquit_exec(int sig);
 int			set_signal_mode(t_shell *shell, int mode);
+void		signal_bind(t_shell *shell);
+void		signal_unbind(t_shell *shell);
 
 /* Shell initialization and management */
-t_shell		*init_shell(char **envp);
+t_shell		*init_shell(char **envp, int profile);
+int			init_interactive(t_shell *shell);
 int			verify_shell_state(t_shell *shell);
+int			run_command_string(t_shell *shell, char *input);
+void		run_noninteractive(t_shell *shell);
+int			serve_run(t_shell *shell, char *path);
+char		*read_line_fd(int fd); /* Returns NULL on EOF or error */
 int			cleanup_shell(t_shell *shell);
 int			process_input(char *input, t_shell *shell);
+int			parse_input(char *input, t_shell *shell);
+int			execute_input(t_shell *shell);
+void		rc_load(t_shell *shell);
+void		handle_parse_error(t_shell *shell, int error_type);
+int			is_whitespace_only(char *str);
 void		handle_interrupted_execution(t_shell *shell);
 void		shell_loop(t_shell *shell);
 int			restore_terminal(t_shell *shell);
 void		handle_signal_state(t_shell *shell);
 void		cleanup_interrupted_heredoc(t_shell *shell);
-int			handle_history(char *input);
 int			setup_terminal(t_shell *shell);
 int			recover_terminal_error(t_shell *shell);
 int			start_heredoc(t_shell *shell, char *file);
@@ -233,12 +891,69 @@ void		print_error(char *cmd, char *arg, char *message);
 void		syntax_error(char *token);
 
 /* Heredoc handling */
-char		*handle_heredoc(char *delimiter, t_env *env_list, int exit_status);
-char		*create_heredoc_file(void); /* Returns NULL on error */
+char		*handle_heredoc(t_shell *shell, char *delimiter, int expand);
+char		*create_heredoc_file(t_shell *shell); /* Returns NULL on error */
+char		*copy_heredoc_file(t_shell *shell, char *path);
 int			cleanup_heredoc(char *filename);
 
+/* Working directory tracking */
+int			cwd_init(t_shell *shell);
+char		*cwd_logical(t_shell *shell);
+char		*cwd_physical(t_shell *shell);
+int			cwd_validate(t_shell *shell);
+int			cwd_change(t_shell *shell, char *target, int physical);
+int			cwd_enter(t_shell *shell);
+void		cwd_free(t_shell *shell);
+
+/* History */
+void		history_init(t_shell *shell);
+int			history_add(t_shell *shell, char *line);
+void		history_close(t_shell *shell);
+int			hist_index_add(t_hist_index *index, int limit, char *line);
+int			hist_index_search(t_hist_index *index, char *pattern, int before);
+char		*hist_index_entry(t_hist_index *index, int id);
+void		hist_index_clear(t_hist_index *index);
+
 /* Prompts */
 char		*get_shell_input(t_shell *shell); /* Returns NULL on error or EOF */
+char		*prompt_render(t_shell *shell);
+void		prompt_free(t_prompt *prompt);
+
+/* Allocation accounting */
+void		*ft_malloc(size_t size);
+void		ft_free(void *ptr);
+t_mem_tag	mem_scope(t_mem_tag tag);
+void		mem_stats(t_mem_tag tag, t_mem_stats *out);
+void		mem_stats_reset(void);
+
+/* Execution event log */
+void		event_pipe_begin(t_shell *shell, t_event_pipe *pipe);
+void		event_stage_begin(t_shell *shell, t_event_pipe *pipe,
+				t_event_stage *st);
+void		event_stage_launched(t_shell *shell, t_event_pipe *pipe);
+void		event_stage_reaped(t_event_stage *st, struct rusage *usage);
+void		event_stage_end(t_event_pipe *pipe, t_command *cmd,
+				t_event_stage *st, int status);
+void		event_pipe_end(t_shell *shell, t_event_pipe *pipe, int status);
+void		event_log_flush(t_shell *shell);
+void		event_log_close(t_shell *shell);
+
+/* Zygote pool */
+void		zygote_refill(t_shell *shell);
+pid_t		zygote_launch(t_shell *shell, t_command *cmd, int in_fd,
+				int out_fd);
+void		zygote_pool_clear(t_zygote_pool *pool);
+
+/* Runtime counters */
+void		stats_add(t_stat stat, unsigned long n);
+void		stats_reset(void);
+int			stats_print(int fd, int json);
+void		stats_dump(t_shell *shell);
+
+/* Startup profiling */
+void		profile_start(t_profile *profile, int enabled);
+void		profile_step(t_profile *profile, const char *name);
+void		profile_report(t_profile *profile);
 
 /* Cleanup */
 int			cleanup_command_resources(t_shell *shell);
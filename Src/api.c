@@ -0,0 +1,273 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   api.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/* Embedding API, documented in Inc/libminishell.h */
+
+struct s_shell_ast
+{
+	t_command	*commands;
+};
+
+/* Signal dispositions and directory of the host, restored after every
+ * call
+ */
+typedef struct s_host_signals
+{
+	struct sigaction	sigint;
+	struct sigaction	sigquit;
+	int					cwd;
+}	t_host_signals;
+
+/**
+ * Enter a call: remember the host's handlers and directory, then move
+ * into the shell's directory and bind the shell
+ * @param shell Shell being called
+ * @param host Storage for the host's state
+ */
+static void	enter_shell(t_shell *shell, t_host_signals *host)
+{
+	sigaction(SIGINT, NULL, &host->sigint);
+	sigaction(SIGQUIT, NULL, &host->sigquit);
+	host->cwd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	cwd_enter(shell);
+	signal_bind(shell);
+}
+
+/**
+ * Leave a call: write out builtin output, put the host's handlers and
+ * directory back
+ * @param host State saved by enter_shell
+ */
+static void	leave_shell(t_host_signals *host)
+{
+	builtin_flush();
+	sigaction(SIGINT, &host->sigint, NULL);
+	sigaction(SIGQUIT, &host->sigquit, NULL);
+	signal_bind(NULL);
+	if (host->cwd >= 0)
+	{
+		fchdir(host->cwd);
+		close(host->cwd);
+	}
+}
+
+/**
+ * Create a shell without a terminal, unbound from signals between calls
+ * @param envp Initial environment
+ * @return New shell or NULL on failure
+ */
+t_shell	*shell_create(char **envp)
+{
+	t_shell	*shell;
+
+	shell = init_shell(envp, 0);
+	if (shell)
+		signal_bind(NULL);
+	return (shell);
+}
+
+/**
+ * Free a shell and everything it owns
+ * @param shell Shell to destroy, may be NULL
+ */
+void	shell_destroy(t_shell *shell)
+{
+	if (!shell)
+		return ;
+	signal_unbind(shell);
+	cleanup_shell(shell);
+}
+
+/**
+ * Parse a line without running it; heredoc bodies are read here
+ * @param shell Shell to parse in
+ * @param line Command line
+ * @return AST owned by the caller, or NULL on error or empty input
+ */
+t_shell_ast	*shell_parse(t_shell *shell, const char *line)
+{
+	t_shell_ast		*ast;
+	t_command		*commands;
+	t_host_signals	host;
+	t_mem_tag		previous;
+
+	if (!shell || !line || is_whitespace_only((char *)line))
+		return (NULL);
+	enter_shell(shell, &host);
+	previous = mem_scope(MEM_LEXER);
+	shell->tokens = tokenize_input((char *)line);
+	mem_scope(MEM_PARSER);
+	commands = NULL;
+	if (shell->tokens)
+		commands = parse_tokens(shell->tokens, shell);
+	mem_scope(previous);
+	if (shell->tokens && !commands)
+		handle_parse_error(shell, SYNTAX_ERROR);
+	free_tokens(shell->tokens);
+	shell->tokens = NULL;
+	leave_shell(&host);
+	ast = NULL;
+	if (commands)
+		ast = (t_shell_ast *)ft_malloc(sizeof(t_shell_ast));
+	if (!ast)
+	{
+		free_commands(commands);
+		shell->exit_status = SYNTAX_ERROR;
+		return (NULL);
+	}
+	ast->commands = commands;
+	return (ast);
+}
+
+/**
+ * Run a parsed AST; it can be run again or freed afterwards
+ * @param shell Shell to run in
+ * @param ast AST from shell_parse
+ * @return Exit status of the last command
+ */
+int	shell_execute(t_shell *shell, t_shell_ast *ast)
+{
+	t_host_signals	host;
+	t_mem_tag		previous;
+	int				status;
+
+	if (!shell || !ast)
+		return (ERROR);
+	enter_shell(shell, &host);
+	shell->commands = ast->commands;
+	shell->cached_entry = NULL;
+	previous = mem_scope(MEM_EXECUTOR);
+	status = execute_commands(ast->commands, shell);
+	mem_scope(previous);
+	// The AST stays owned by the caller
+	shell->commands = NULL;
+	glob_cache_clear(&shell->glob_cache);
+	leave_shell(&host);
+	shell->exit_status = status;
+	return (status);
+}
+
+/**
+ * Free an AST and remove its heredoc files
+ * @param ast AST to free, may be NULL
+ */
+void	shell_ast_free(t_shell_ast *ast)
+{
+	if (!ast)
+		return ;
+	cleanup_all_heredocs(ast->commands);
+	free_commands(ast->commands);
+	ft_free(ast);
+}
+
+/**
+ * Parse and run a line
+ * @param shell Shell to run in
+ * @param line Command line
+ * @return Exit status of the line
+ */
+int	shell_run(t_shell *shell, const char *line)
+{
+	t_shell_ast	*ast;
+	int			status;
+
+	if (!shell)
+		return (ERROR);
+	ast = shell_parse(shell, line);
+	if (!ast)
+		return (shell->exit_status);
+	status = shell_execute(shell, ast);
+	shell_ast_free(ast);
+	return (status);
+}
+
+/**
+ * Get the status of the last command ($?)
+ * @param shell Shell structure
+ * @return Exit status
+ */
+int	shell_exit_status(t_shell *shell)
+{
+	return (shell->exit_status);
+}
+
+/**
+ * Tell whether the shell is still running, i.e. exit was not called
+ * @param shell Shell structure
+ * @return 1 if running, 0 after exit
+ */
+int	shell_is_running(t_shell *shell)
+{
+	return (shell->running);
+}
+
+/**
+ * Get a variable of the shell's environment
+ * @param shell Shell structure
+ * @param name Variable name
+ * @return Value owned by the shell, or NULL if unset
+ */
+const char	*shell_getenv(t_shell *shell, const char *name)
+{
+	return (get_env_value(shell->env_list, (char *)name));
+}
+
+/**
+ * Set a variable in the shell's environment
+ * @param shell Shell structure
+ * @param name Variable name
+ * @param value New value
+ * @return 0 on success, -1 on an invalid name or failure
+ */
+int	shell_setenv(t_shell *shell, const char *name, const char *value)
+{
+	if (!is_valid_variable_name((char *)name) || !value)
+		return (-1);
+	if (set_env_value(shell->env_list, (char *)name, (char *)value) != SUCCESS)
+		return (-1);
+	return (0);
+}
+
+/**
+ * Remove a variable from the shell's environment
+ * @param shell Shell structure
+ * @param name Variable name
+ * @return 0 on success, -1 on failure
+ */
+int	shell_unsetenv(t_shell *shell, const char *name)
+{
+	if (unset_env_value(&shell->env_list, (char *)name) == ERROR)
+		return (-1);
+	return (0);
+}
+
+/**
+ * Export the shell's environment as NAME=value strings
+ * @param shell Shell structure
+ * @return Array to release with shell_environ_free, or NULL
+ */
+char	**shell_environ(t_shell *shell)
+{
+	return (env_to_array(shell->env_list));
+}
+
+/**
+ * Free an array returned by shell_environ
+ * @param env Array to free, may be NULL
+ */
+void	shell_environ_free(char **env)
+{
+	if (env)
+		free_string_array(env);
+}
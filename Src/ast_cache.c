@@ -0,0 +1,383 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   ast_cache.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * Flat encoding of an unexpanded AST, as kept in the rc cache:
+ *
+ *   list     u32 count, command...
+ *   command  u8 type, u8 pipe_out, u32 nwords, word..., u32 nredirs,
+ *            (u8 type, word)..., string func_name, list body
+ *   word     u32 nsegs, (u8 type, u8 quoted, string text)...
+ *   string   u32 length (AST_NULL for none), bytes
+ *
+ * Integers are in host byte order; the cache header records the
+ * byte order it was written with. A word's quote-removed text is
+ * rebuilt from its segments on load.
+ */
+
+#define AST_NULL 0xFFFFFFFFu
+
+/**
+ * Append raw bytes to a buffer
+ * @param buf Output buffer, marked failed when it cannot grow
+ * @param data Bytes to append
+ * @param len Number of bytes
+ */
+void	ast_put(t_ast_buf *buf, const void *data, size_t len)
+{
+	char	*grown;
+	size_t	cap;
+
+	if (buf->failed)
+		return ;
+	if (buf->len + len > buf->cap)
+	{
+		cap = buf->cap * 2 + len + 256;
+		grown = ft_malloc(cap);
+		if (!grown)
+		{
+			buf->failed = 1;
+			return ;
+		}
+		if (buf->len)
+			ft_memcpy(grown, buf->data, buf->len);
+		ft_free(buf->data);
+		buf->data = grown;
+		buf->cap = cap;
+	}
+	ft_memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+/**
+ * Append a 32-bit integer
+ * @param buf Output buffer
+ * @param value Value to append
+ */
+void	ast_put_u32(t_ast_buf *buf, unsigned int value)
+{
+	ast_put(buf, &value, sizeof(value));
+}
+
+/**
+ * Append a length-prefixed string
+ * @param buf Output buffer
+ * @param s String, NULL is encoded as such
+ */
+void	ast_put_string(t_ast_buf *buf, const char *s)
+{
+	size_t	len;
+
+	if (!s)
+	{
+		ast_put_u32(buf, AST_NULL);
+		return ;
+	}
+	len = ft_strlen(s);
+	ast_put_u32(buf, len);
+	ast_put(buf, s, len);
+}
+
+/**
+ * Append a word with its segments
+ * @param buf Output buffer
+ * @param word Word to encode
+ */
+static void	put_word(t_ast_buf *buf, t_word *word)
+{
+	t_segment		*seg;
+	unsigned int	count;
+	unsigned char	flags[2];
+
+	count = 0;
+	seg = word->segs;
+	while (seg && ++count)
+		seg = seg->next;
+	ast_put_u32(buf, count);
+	seg = word->segs;
+	while (seg)
+	{
+		flags[0] = seg->type;
+		flags[1] = seg->quoted;
+		ast_put(buf, flags, 2);
+		ast_put_string(buf, seg->text);
+		seg = seg->next;
+	}
+}
+
+/**
+ * Append one command: its words, redirections and function body
+ * @param buf Output buffer
+ * @param cmd Command to encode
+ */
+static void	put_command(t_ast_buf *buf, t_command *cmd)
+{
+	t_word			*word;
+	t_redirection	*redir;
+	unsigned int	count;
+	unsigned char	flags[2];
+
+	flags[0] = cmd->type;
+	flags[1] = cmd->pipe_out;
+	ast_put(buf, flags, 2);
+	count = 0;
+	word = cmd->words;
+	while (word && ++count)
+		word = word->next;
+	ast_put_u32(buf, count);
+	word = cmd->words;
+	while (word)
+	{
+		put_word(buf, word);
+		word = word->next;
+	}
+	count = 0;
+	redir = cmd->redirections;
+	while (redir && ++count)
+		redir = redir->next;
+	ast_put_u32(buf, count);
+	redir = cmd->redirections;
+	while (redir)
+	{
+		flags[0] = redir->type;
+		ast_put(buf, flags, 1);
+		put_word(buf, redir->word);
+		redir = redir->next;
+	}
+	ast_put_string(buf, cmd->func_name);
+	ast_put_commands(buf, cmd->body);
+}
+
+/**
+ * Append a command list
+ * @param buf Output buffer
+ * @param commands Commands to encode, NULL for an empty list
+ */
+void	ast_put_commands(t_ast_buf *buf, t_command *commands)
+{
+	t_command		*cmd;
+	unsigned int	count;
+
+	count = 0;
+	cmd = commands;
+	while (cmd && ++count)
+		cmd = cmd->next;
+	ast_put_u32(buf, count);
+	while (commands)
+	{
+		put_command(buf, commands);
+		commands = commands->next;
+	}
+}
+
+/**
+ * Take raw bytes from a reader
+ * @param in Reader, marked failed when it runs short
+ * @param dst Destination
+ * @param len Number of bytes
+ * @return SUCCESS or ERROR
+ */
+int	ast_get(t_ast_reader *in, void *dst, size_t len)
+{
+	if (in->failed || len > in->left)
+	{
+		in->failed = 1;
+		return (ERROR);
+	}
+	ft_memcpy(dst, in->p, len);
+	in->p += len;
+	in->left -= len;
+	return (SUCCESS);
+}
+
+/**
+ * Take a 32-bit integer
+ * @param in Reader
+ * @return The value, 0 once the reader failed
+ */
+unsigned int	ast_get_u32(t_ast_reader *in)
+{
+	unsigned int	value;
+
+	value = 0;
+	if (ast_get(in, &value, sizeof(value)) != SUCCESS)
+		return (0);
+	return (value);
+}
+
+/**
+ * Take a length-prefixed string
+ * @param in Reader
+ * @return Newly allocated string, NULL when none was encoded or on error
+ */
+char	*ast_get_string(t_ast_reader *in)
+{
+	unsigned int	len;
+	char			*s;
+
+	len = ast_get_u32(in);
+	if (in->failed || len == AST_NULL)
+		return (NULL);
+	if (len > in->left)
+	{
+		in->failed = 1;
+		return (NULL);
+	}
+	s = ft_substr(in->p, 0, len);
+	if (!s)
+		in->failed = 1;
+	in->p += len;
+	in->left -= len;
+	return (s);
+}
+
+/**
+ * Rebuild a word from its segments
+ * @param in Reader
+ * @return New word or NULL on error
+ */
+static t_word	*get_word(t_ast_reader *in)
+{
+	t_word			*word;
+	unsigned int	count;
+	unsigned char	flags[2];
+	char			*text;
+
+	word = new_word();
+	count = ast_get_u32(in);
+	while (word && count-- > 0 && !in->failed)
+	{
+		text = NULL;
+		if (ast_get(in, flags, 2) == SUCCESS && flags[0] <= SEG_PARAM)
+			text = ast_get_string(in);
+		if (!text || word_add_segment(word, flags[0], text,
+				ft_strlen(text)) != SUCCESS)
+			in->failed = 1;
+		else
+			word->last->quoted = flags[1];
+		ft_free(text);
+	}
+	if (!word || in->failed)
+	{
+		free_words(word);
+		in->failed = 1;
+		return (NULL);
+	}
+	return (word);
+}
+
+/**
+ * Rebuild the argument words of a command
+ * @param in Reader
+ * @param cmd Command to fill in
+ */
+static void	get_words(t_ast_reader *in, t_command *cmd)
+{
+	t_word			*last;
+	t_word			*word;
+	unsigned int	count;
+
+	last = NULL;
+	count = ast_get_u32(in);
+	while (count-- > 0 && !in->failed)
+	{
+		word = get_word(in);
+		if (!word)
+			return ;
+		if (last)
+			last->next = word;
+		else
+			cmd->words = word;
+		last = word;
+	}
+}
+
+/**
+ * Rebuild the redirections of a command
+ * @param in Reader
+ * @param cmd Command to fill in
+ */
+static void	get_redirections(t_ast_reader *in, t_command *cmd)
+{
+	t_redirection	*last;
+	t_redirection	*redir;
+	t_word			*word;
+	unsigned int	count;
+	unsigned char	type;
+
+	last = NULL;
+	count = ast_get_u32(in);
+	while (count-- > 0 && !in->failed)
+	{
+		if (ast_get(in, &type, 1) != SUCCESS || type >= TOKEN_EOF)
+			in->failed = 1;
+		word = get_word(in);
+		if (!word)
+			return ;
+		redir = create_redirection(type, word);
+		if (!redir)
+		{
+			in->failed = 1;
+			return ;
+		}
+		if (last)
+			last->next = redir;
+		else
+			cmd->redirections = redir;
+		last = redir;
+	}
+}
+
+/**
+ * Rebuild a command list
+ * @param in Reader
+ * @return Command list, NULL for an empty list or on error (in->failed)
+ */
+t_command	*ast_get_commands(t_ast_reader *in)
+{
+	t_command		*head;
+	t_command		*last;
+	t_command		*cmd;
+	unsigned int	count;
+	unsigned char	flags[2];
+
+	head = NULL;
+	last = NULL;
+	count = ast_get_u32(in);
+	while (count-- > 0 && !in->failed)
+	{
+		cmd = create_command();
+		if (!cmd || ast_get(in, flags, 2) != SUCCESS || flags[0] > CMD_FUNCDEF)
+		{
+			in->failed = 1;
+			free_commands(cmd);
+			break ;
+		}
+		if (last)
+			last->next = cmd;
+		else
+			head = cmd;
+		last = cmd;
+		cmd->type = flags[0];
+		cmd->pipe_out = flags[1];
+		get_words(in, cmd);
+		get_redirections(in, cmd);
+		cmd->func_name = ast_get_string(in);
+		cmd->body = ast_get_commands(in);
+	}
+	if (!in->failed)
+		return (head);
+	free_commands(head);
+	return (NULL);
+}
@@ -83,7 +83,7 @@ int	builtin_echo(t_command *cmd, t_shell *shell)
 	i = arg_start;
 	while (cmd->args[i])
 	{
-		if (write(STDOUT_FILENO, cmd->args[i], ft_strlen(cmd->args[i])) == -1)
+		if (builtin_write(STDOUT_FILENO, cmd->args[i], ft_strlen(cmd->args[i])) == -1)
 		{
 			print_error("echo", NULL, "write error");
 			return (ERROR);
@@ -91,7 +91,7 @@ int	builtin_echo(t_command *cmd, t_shell *shell)
 		
 		if (cmd->args[i + 1])
 		{
-			if (write(STDOUT_FILENO, " ", 1) == -1)
+			if (builtin_write(STDOUT_FILENO, " ", 1) == -1)
 			{
 				print_error("echo", NULL, "write error");
 				return (ERROR);
@@ -103,7 +103,7 @@ int	builtin_echo(t_command *cmd, t_shell *shell)
 	// Print newline if -n flag not present
 	if (!n_flag)
 	{
-		if (write(STDOUT_FILENO, "\n", 1) == -1)
+		if (builtin_write(STDOUT_FILENO, "\n", 1) == -1)
 		{
 			print_error("echo", NULL, "write error");
 			return (ERROR);
@@ -115,19 +115,38 @@ int	builtin_echo(t_command *cmd, t_shell *shell)
 
 /**
  * Built-in pwd command - prints current working directory
+ * Usage: pwd [-L|-P]; the logical path is served from the directory
+ * cache after a single stat check
  * @param cmd Command structure
  * @param shell Shell structure
  * @return SUCCESS or ERROR
  */
 int	builtin_pwd(t_command *cmd, t_shell *shell)
 {
-	char	current_dir[4096];
+	char	*current_dir;
+	int		physical;
+	int		i;
 
-	(void)cmd;
-	(void)shell;
+	physical = 0;
+	i = 1;
+	while (cmd->args[i] && cmd->args[i][0] == '-')
+	{
+		if (ft_strcmp(cmd->args[i], "-L") != 0
+			&& ft_strcmp(cmd->args[i], "-P") != 0)
+		{
+			print_error("pwd", cmd->args[i], "invalid option");
+			return (ERROR);
+		}
+		physical = (cmd->args[i++][1] == 'P');
+	}
 	
 	// Get current working directory with specific error handling
-	if (getcwd(current_dir, sizeof(current_dir)) == NULL)
+	cwd_validate(shell);
+	if (physical)
+		current_dir = cwd_physical(shell);
+	else
+		current_dir = cwd_logical(shell);
+	if (current_dir == NULL)
 	{
 		if (errno == ERANGE)
 			print_error("pwd", NULL, "path too long");
@@ -141,13 +160,13 @@ int	builtin_pwd(t_command *cmd, t_shell *shell)
 	
 	// Print with error checking
 	size_t dir_len = ft_strlen(current_dir);
-	if (write(STDOUT_FILENO, current_dir, dir_len) == -1)
+	if (builtin_write(STDOUT_FILENO, current_dir, dir_len) == -1)
 	{
 		print_error("pwd", NULL, "write error");
 		return (ERROR);
 	}
 	
-	if (write(STDOUT_FILENO, "\n", 1) == -1)
+	if (builtin_write(STDOUT_FILENO, "\n", 1) == -1)
 	{
 		print_error("pwd", NULL, "write error");
 		return (ERROR);
@@ -0,0 +1,286 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_cat.c                                     :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#define _GNU_SOURCE
+#include "../Inc/minishell.h"
+#include <sys/sendfile.h>
+
+/*
+ * cat [-u] [file...] moves bytes to stdout without copying them through
+ * the shell when the kernel can do it:
+ *
+ *   file to file   copy_file_range
+ *   pipe involved  splice
+ *   file to other  sendfile
+ *
+ * and with a read/write loop through a large buffer otherwise. Options
+ * other than -u are left to the external cat (see cat_is_plain).
+ */
+
+#define CAT_CHUNK 1048576
+#define CAT_BUFFER 131072
+
+typedef enum e_cat_method
+{
+	CAT_COPY_RANGE,
+	CAT_SPLICE,
+	CAT_SENDFILE
+}	t_cat_method;
+
+/* Outcome of one copy method */
+typedef enum e_cat_result
+{
+	CAT_DONE,
+	CAT_UNSUPPORTED,
+	CAT_FAILED,
+	CAT_INTERRUPTED
+}	t_cat_result;
+
+typedef struct s_cat
+{
+	t_shell		*shell;
+	struct stat	out;
+	char		*buf;
+}	t_cat;
+
+/**
+ * Check whether a cat command line only asks for a plain copy
+ * @param args Arguments, args[0] is cat
+ * @return 1 if the builtin handles it
+ */
+int	cat_is_plain(char **args)
+{
+	int	i;
+
+	i = 1;
+	while (args[i] && args[i][0] == '-' && args[i][1])
+	{
+		if (ft_strcmp(args[i], "--") == 0)
+			return (1);
+		if (ft_strcmp(args[i], "-u") != 0)
+			return (0);
+		i++;
+	}
+	return (1);
+}
+
+/**
+ * Move up to one chunk with a zero-copy method
+ * @param method Method to use
+ * @param in Input descriptor
+ * @return Bytes moved, 0 at end of input, -1 on error
+ */
+static ssize_t	move_chunk(t_cat_method method, int in)
+{
+	if (method == CAT_COPY_RANGE)
+		return (copy_file_range(in, NULL, STDOUT_FILENO, NULL, CAT_CHUNK, 0));
+	if (method == CAT_SPLICE)
+		return (splice(in, NULL, STDOUT_FILENO, NULL, CAT_CHUNK,
+				SPLICE_F_MOVE));
+	return (sendfile(STDOUT_FILENO, in, NULL, CAT_CHUNK));
+}
+
+/**
+ * Copy an input with a zero-copy method
+ * A method the kernel refuses before the first byte moved is reported
+ * as unsupported, so the next one can be tried
+ * @param cat Copy state
+ * @param method Method to use
+ * @param in Input descriptor
+ * @return Outcome
+ */
+static t_cat_result	copy_zero(t_cat *cat, t_cat_method method, int in)
+{
+	ssize_t	n;
+	int		moved;
+
+	moved = 0;
+	while (1)
+	{
+		n = move_chunk(method, in);
+		if (n > 0)
+		{
+			stats_add(STAT_BUILTIN_BYTES, n);
+			moved = 1;
+			continue ;
+		}
+		if (n == 0)
+			return (CAT_DONE);
+		if (errno == EINTR && cat->shell->received_signal == SIGINT)
+			return (CAT_INTERRUPTED);
+		if (errno == EINTR)
+			continue ;
+		if (!moved && (errno == EINVAL || errno == EXDEV || errno == ENOSYS
+				|| errno == EOPNOTSUPP || errno == EBADF))
+			return (CAT_UNSUPPORTED);
+		return (CAT_FAILED);
+	}
+}
+
+/**
+ * Copy an input through the buffer
+ * @param cat Copy state
+ * @param in Input descriptor
+ * @return Outcome
+ */
+static t_cat_result	copy_buffered(t_cat *cat, int in)
+{
+	ssize_t	n;
+	ssize_t	off;
+	ssize_t	written;
+
+	while (1)
+	{
+		n = read(in, cat->buf, CAT_BUFFER);
+		if (n == 0)
+			return (CAT_DONE);
+		if (n < 0 && errno == EINTR && cat->shell->received_signal == SIGINT)
+			return (CAT_INTERRUPTED);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n < 0)
+			return (CAT_FAILED);
+		off = 0;
+		while (off < n)
+		{
+			written = builtin_write(STDOUT_FILENO, cat->buf + off, n - off);
+			if (written < 0 && errno == EINTR)
+				continue ;
+			if (written <= 0)
+				return (CAT_FAILED);
+			off += written;
+		}
+	}
+}
+
+/**
+ * Copy one input to stdout, trying the cheapest method first
+ * Zero-sized regular files (/proc and friends) are read, since their
+ * size says nothing about their content
+ * @param cat Copy state
+ * @param in Input descriptor
+ * @return Outcome
+ */
+static t_cat_result	copy_input(t_cat *cat, int in)
+{
+	struct stat		st;
+	t_cat_result	result;
+	int				file;
+
+	if (fstat(in, &st) != 0)
+		return (CAT_FAILED);
+	file = S_ISREG(st.st_mode) && st.st_size > 0;
+	result = CAT_UNSUPPORTED;
+	if (file && S_ISREG(cat->out.st_mode))
+		result = copy_zero(cat, CAT_COPY_RANGE, in);
+	if (result == CAT_UNSUPPORTED
+		&& (S_ISFIFO(st.st_mode) || S_ISFIFO(cat->out.st_mode)))
+		result = copy_zero(cat, CAT_SPLICE, in);
+	if (result == CAT_UNSUPPORTED && file)
+		result = copy_zero(cat, CAT_SENDFILE, in);
+	if (result == CAT_UNSUPPORTED)
+		result = copy_buffered(cat, in);
+	return (result);
+}
+
+/**
+ * Open and copy one operand
+ * @param cat Copy state
+ * @param name File name, - for stdin
+ * @return Outcome
+ */
+static t_cat_result	cat_operand(t_cat *cat, char *name)
+{
+	struct stat		st;
+	t_cat_result	result;
+	int				fd;
+
+	fd = STDIN_FILENO;
+	if (ft_strcmp(name, "-") != 0)
+		fd = open(name, O_RDONLY | O_CLOEXEC);
+	if (fd < 0 || fstat(fd, &st) != 0)
+	{
+		print_error("cat", name, strerror(errno));
+		if (fd > STDIN_FILENO)
+			close(fd);
+		return (CAT_FAILED);
+	}
+	// Checked whatever the size, > has already truncated the file
+	if (S_ISREG(st.st_mode) && S_ISREG(cat->out.st_mode)
+		&& st.st_dev == cat->out.st_dev && st.st_ino == cat->out.st_ino)
+	{
+		print_error("cat", name, "input file is output file");
+		result = CAT_FAILED;
+	}
+	else if (S_ISDIR(st.st_mode))
+	{
+		print_error("cat", name, "Is a directory");
+		result = CAT_FAILED;
+	}
+	else
+	{
+		result = copy_input(cat, fd);
+		if (result == CAT_FAILED)
+			print_error("cat", name, strerror(errno));
+	}
+	if (fd != STDIN_FILENO)
+		close(fd);
+	return (result);
+}
+
+/**
+ * Built-in cat: concatenate files to stdout
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS, ERROR if an operand failed, 130 if interrupted
+ */
+int	builtin_cat(t_command *cmd, t_shell *shell)
+{
+	t_cat			cat;
+	t_cat_result	result;
+	int				status;
+	int				i;
+
+	// The zero-copy paths write to stdout behind the builtin buffer
+	builtin_flush();
+	cat.shell = shell;
+	cat.buf = ft_malloc(CAT_BUFFER);
+	if (!cat.buf || fstat(STDOUT_FILENO, &cat.out) != 0)
+	{
+		ft_free(cat.buf);
+		return (ERROR);
+	}
+	// Reads must give way to Ctrl-C, which the prompt handlers restart
+	setup_exec_signals();
+	i = 1;
+	while (cmd->args[i] && ft_strcmp(cmd->args[i], "-u") == 0)
+		i++;
+	if (cmd->args[i] && ft_strcmp(cmd->args[i], "--") == 0)
+		i++;
+	status = SUCCESS;
+	result = CAT_DONE;
+	if (!cmd->args[i])
+		result = cat_operand(&cat, "-");
+	while (cmd->args[i] && result != CAT_INTERRUPTED)
+	{
+		result = cat_operand(&cat, cmd->args[i++]);
+		if (result == CAT_FAILED)
+			status = ERROR;
+	}
+	ft_free(cat.buf);
+	setup_signals();
+	if (result == CAT_INTERRUPTED)
+		return (130);
+	if (result == CAT_FAILED)
+		return (ERROR);
+	return (status);
+}
@@ -13,133 +13,72 @@
 #include "../Inc/minishell.h"
 
 /**
- * Handles changing to HOME directory
+ * Resolve the operand of cd: HOME, OLDPWD for "-", or the argument
  * @param shell Shell structure
- * @return SUCCESS or ERROR
+ * @param arg Operand or NULL
+ * @return Target directory or NULL on error (already reported)
  */
-static int	cd_to_home(t_shell *shell)
+static char	*cd_target(t_shell *shell, char *arg)
 {
 	char	*path;
 
-	if (!shell || !shell->env_list)
-	{
-		print_error("cd", NULL, "shell not initialized");
-		return (ERROR);
-	}
-	
-	path = get_env_value(shell->env_list, "HOME");
+	if (!arg)
+		path = get_env_value(shell->env_list, "HOME");
+	else if (ft_strcmp(arg, "-") == 0)
+		path = get_env_value(shell->env_list, "OLDPWD");
+	else
+		path = arg;
 	if (!path)
 	{
-		print_error("cd", NULL, "HOME not set");
-		return (ERROR);
+		if (!arg)
+			print_error("cd", NULL, "HOME not set");
+		else
+			print_error("cd", NULL, "OLDPWD not set");
+		return (NULL);
 	}
 	
 	// Check path length
 	if (ft_strlen(path) > 4096)
 	{
 		print_error("cd", NULL, "path too long");
-		return (ERROR);
+		return (NULL);
 	}
-	
-	if (chdir(path) != 0)
-	{
-		print_error("cd", path, NULL);
-		return (ERROR);
-	}
-	
-	return (SUCCESS);
+	return (path);
 }
 
 /**
- * Handles changing to previous directory
- * @param shell Shell structure
- * @return SUCCESS or ERROR
- */
-static int	cd_to_previous(t_shell *shell)
-{
-	char	*path;
-
-	if (!shell || !shell->env_list)
-	{
-		print_error("cd", NULL, "shell not initialized");
-		return (ERROR);
-	}
-
-	path = get_env_value(shell->env_list, "OLDPWD");
-	if (!path)
-	{
-		print_error("cd", NULL, "OLDPWD not set");
-		return (ERROR);
-	}
-	
-	// Check path length
-	if (ft_strlen(path) > 4096)
-	{
-		print_error("cd", NULL, "path too long");
-		return (ERROR);
-	}
-	
-	// Display the directory we're changing to
-	if (write(STDOUT_FILENO, path, ft_strlen(path)) == -1 ||
-		write(STDOUT_FILENO, "\n", 1) == -1)
-	{
-		print_error("cd", NULL, "write error");
-		// Continue despite write error
-	}
-	
-	if (chdir(path) != 0)
-	{
-		print_error("cd", path, NULL);
-		return (ERROR);
-	}
-	
-	return (SUCCESS);
-}
-
-/**
- * Updates PWD and OLDPWD environment variables
+ * Updates PWD and OLDPWD environment variables from the directory cache
  * @param shell Shell structure
  * @param old_pwd Previous working directory
  * @return SUCCESS or ERROR
  */
 static int	update_pwd_vars(t_shell *shell, char *old_pwd)
 {
-	char	current_dir[4096];
-
-	if (!shell || !shell->env_list || !old_pwd)
-	{
-		free(old_pwd);
-		return (ERROR);
-	}
+	int	status;
 
-	if (getcwd(current_dir, sizeof(current_dir)) == NULL)
-	{
-		print_error("cd", NULL, "getcwd error");
-		free(old_pwd);
-		return (ERROR);
-	}
+	status = SUCCESS;
 	
 	// Update environment variables with error checking
-	if (set_env_value(shell->env_list, "OLDPWD", old_pwd) == ERROR)
+	if (old_pwd && set_env_value(shell->env_list, "OLDPWD", old_pwd) == ERROR)
 	{
 		print_error("cd", NULL, "failed to update OLDPWD");
-		free(old_pwd);
-		return (ERROR);
+		status = ERROR;
 	}
 	
-	if (set_env_value(shell->env_list, "PWD", current_dir) == ERROR)
+	if (set_env_value(shell->env_list, "PWD", cwd_logical(shell)) == ERROR)
 	{
 		print_error("cd", NULL, "failed to update PWD");
-		free(old_pwd);
-		return (ERROR);
+		status = ERROR;
 	}
 	
-	free(old_pwd);
-	return (SUCCESS);
+	ft_free(old_pwd);
+	return (status);
 }
 
 /**
  * Built-in cd command - changes current directory
+ * Usage: cd [-L|-P] [dir]; -L (default) resolves ".." against $PWD,
+ * -P follows the physical directory structure
  * @param cmd Command structure
  * @param shell Shell structure
  * @return SUCCESS or ERROR
@@ -147,7 +86,9 @@ static int	update_pwd_vars(t_shell *shell, char *old_pwd)
 int	builtin_cd(t_command *cmd, t_shell *shell)
 {
 	char	*old_pwd;
-	char	current_dir[4096];
+	char	*target;
+	int		physical;
+	int		i;
 
 	// Basic error checking
 	if (!cmd || !shell || !shell->env_list)
@@ -156,60 +97,48 @@ int	builtin_cd(t_command *cmd, t_shell *shell)
 		return (ERROR);
 	}
 	
-	// Get current directory before changing
-	if (getcwd(current_dir, sizeof(current_dir)) == NULL)
-	{
-		print_error("cd", NULL, "getcwd error");
-		return (ERROR);
-	}
-	
-	// Save old directory
-	old_pwd = ft_strdup(current_dir);
-	if (!old_pwd)
-	{
-		print_error("cd", NULL, "memory allocation failed");
-		return (ERROR);
-	}
-	
-	// No argument - go to HOME
-	if (!cmd->args[1])
+	physical = 0;
+	i = 1;
+	while (cmd->args[i] && cmd->args[i][0] == '-' && cmd->args[i][1])
 	{
-		if (cd_to_home(shell) != SUCCESS)
+		if (ft_strcmp(cmd->args[i], "--") == 0)
 		{
-			free(old_pwd);
-			return (ERROR);
+			i++;
+			break ;
 		}
-	}
-	// "-" argument - go to previous directory
-	else if (ft_strcmp(cmd->args[1], "-") == 0)
-	{
-		if (cd_to_previous(shell) != SUCCESS)
+		if (ft_strcmp(cmd->args[i], "-L") != 0
+			&& ft_strcmp(cmd->args[i], "-P") != 0)
 		{
-			free(old_pwd);
+			print_error("cd", cmd->args[i], "invalid option");
 			return (ERROR);
 		}
+		physical = (cmd->args[i++][1] == 'P');
 	}
-	// Regular path argument
-	else
+	
+	target = cd_target(shell, cmd->args[i]);
+	if (!target)
+		return (ERROR);
+	
+	// The previous directory comes from the cache, no getcwd needed
+	old_pwd = NULL;
+	if (cwd_logical(shell))
+		old_pwd = ft_strdup(cwd_logical(shell));
+	
+	if (cwd_change(shell, target, physical) != SUCCESS)
 	{
-		// Check path length
-		if (ft_strlen(cmd->args[1]) > 4096)
-		{
-			print_error("cd", NULL, "path too long");
-			free(old_pwd);
-			return (ERROR);
-		}
-		
-		// Try to change directory
-		if (chdir(cmd->args[1]) != 0)
-		{
-			print_error("cd", cmd->args[1], NULL);
-			free(old_pwd);
-			return (ERROR);
-		}
+		print_error("cd", target, NULL);
+		ft_free(old_pwd);
+		return (ERROR);
+	}
+	
+	// Display the directory we changed to for "cd -"
+	if (cmd->args[i] && ft_strcmp(cmd->args[i], "-") == 0)
+	{
+		builtin_write(STDOUT_FILENO, cwd_logical(shell),
+			ft_strlen(cwd_logical(shell)));
+		builtin_write(STDOUT_FILENO, "\n", 1);
 	}
 	
 	// Update environment variables
 	return (update_pwd_vars(shell, old_pwd));
 }
-
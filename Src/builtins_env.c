@@ -29,8 +29,8 @@ static int	print_exported_env(t_env *env_list)
 	while (current)
 	{
 		// Check for write errors with each operation
-		if (write(STDOUT_FILENO, "declare -x ", 11) == -1 ||
-			write(STDOUT_FILENO, current->key, ft_strlen(current->key)) == -1)
+		if (builtin_write(STDOUT_FILENO, "declare -x ", 11) == -1 ||
+			builtin_write(STDOUT_FILENO, current->key, ft_strlen(current->key)) == -1)
 		{
 			print_error("export", NULL, "write error");
 			return (ERROR);
@@ -38,7 +38,7 @@ static int	print_exported_env(t_env *env_list)
 		
 		// All variables should be displayed with quotes, even if value is NULL
 		// This is standard shell behavior
-		if (write(STDOUT_FILENO, "=\"", 2) == -1)
+		if (builtin_write(STDOUT_FILENO, "=\"", 2) == -1)
 		{
 			print_error("export", NULL, "write error");
 			return (ERROR);
@@ -46,14 +46,14 @@ static int	print_exported_env(t_env *env_list)
 		
 		// Write the value if it exists (could be empty string)
 		if (current->value && 
-			write(STDOUT_FILENO, current->value, ft_strlen(current->value)) == -1)
+			builtin_write(STDOUT_FILENO, current->value, ft_strlen(current->value)) == -1)
 		{
 			print_error("export", NULL, "write error");
 			return (ERROR);
 		}
 		
 		// Close the quotes and add newline
-		if (write(STDOUT_FILENO, "\"\n", 2) == -1)
+		if (builtin_write(STDOUT_FILENO, "\"\n", 2) == -1)
 		{
 			print_error("export", NULL, "write error");
 			return (ERROR);
@@ -104,9 +104,9 @@ int	builtin_export(t_command *cmd, t_shell *shell)
 		if (!is_valid_variable_name(key))
 		{
 			print_error("export", cmd->args[i], "not a valid identifier");
-			free(key);
+			ft_free(key);
 			if (value)
-				free(value);
+				ft_free(value);
 			status = ERROR;
 		}
 		else
@@ -120,29 +120,63 @@ int	builtin_export(t_command *cmd, t_shell *shell)
 				print_error("export", key, "failed to set variable");
 				status = ERROR;
 			}
-			free(key);
+			ft_free(key);
 			if (value)
-				free(value);
+				ft_free(value);
 		}
 		i++;
 	}
 	return (status);
 }
 
-/* Built-in unset command - removes environment variables */
+/**
+ * Read the options of unset
+ * @param args Arguments of unset
+ * @param i Set to the index of the first name
+ * @return 'f' for functions only, 'v' for variables only, 0 for a
+ *         variable or else a function, -1 on an invalid option
+ */
+static int	unset_mode(char **args, int *i)
+{
+	int	mode;
+
+	mode = 0;
+	*i = 1;
+	while (args[*i] && args[*i][0] == '-' && args[*i][1])
+	{
+		if (ft_strcmp(args[*i], "--") == 0)
+		{
+			(*i)++;
+			break ;
+		}
+		if (ft_strcmp(args[*i], "-f") == 0 || ft_strcmp(args[*i], "-v") == 0)
+			mode = args[*i][1];
+		else
+		{
+			print_error("unset", args[*i], "invalid option");
+			return (-1);
+		}
+		(*i)++;
+	}
+	return (mode);
+}
+
+/* Built-in unset command - removes variables, or functions with -f or
+ * when no variable has the name */
 int	builtin_unset(t_command *cmd, t_shell *shell)
 {
 	int	i;
 	int	status;
+	int	mode;
 
 	if (!cmd || !shell || !shell->env_list)
 		return (ERROR);
 		
 	status = SUCCESS;
-	if (!cmd->args[1])
-		return (SUCCESS);
+	mode = unset_mode(cmd->args, &i);
+	if (mode < 0)
+		return (SYNTAX_ERROR);
 		
-	i = 1;
 	while (cmd->args[i])
 	{
 		// Check for maximum variable length
@@ -159,10 +193,14 @@ int	builtin_unset(t_command *cmd, t_shell *shell)
 			print_error("unset", cmd->args[i], "not a valid identifier");
 			status = ERROR;
 		}
-		else if (unset_env_value(&shell->env_list, cmd->args[i]) == ERROR)
+		else if (mode == 'f')
+			unset_function(shell, cmd->args[i]);
+		else if (unset_env_value(&shell->env_list, cmd->args[i]) == ERROR
+			&& mode == 0)
 		{
-			// Just silently continue if variable doesn't exist
-			// This matches standard shell behavior
+			// No such variable: a function of that name goes instead,
+			// and a name that is neither is silently ignored
+			unset_function(shell, cmd->args[i]);
 		}
 		i++;
 	}
@@ -195,10 +233,10 @@ int	builtin_env(t_command *cmd, t_shell *shell)
 		if (current->value != NULL)
 		{
 			// Check for write errors with each operation
-			if (write(STDOUT_FILENO, current->key, ft_strlen(current->key)) == -1 ||
-				write(STDOUT_FILENO, "=", 1) == -1 ||
-				write(STDOUT_FILENO, current->value, ft_strlen(current->value)) == -1 ||
-				write(STDOUT_FILENO, "\n", 1) == -1)
+			if (builtin_write(STDOUT_FILENO, current->key, ft_strlen(current->key)) == -1 ||
+				builtin_write(STDOUT_FILENO, "=", 1) == -1 ||
+				builtin_write(STDOUT_FILENO, current->value, ft_strlen(current->value)) == -1 ||
+				builtin_write(STDOUT_FILENO, "\n", 1) == -1)
 			{
 				print_error("env", NULL, "write error");
 				return (ERROR);
@@ -59,8 +59,8 @@ int	builtin_exit(t_command *cmd, t_shell *shell)
 	if (!cmd || !shell)
 		return (ERROR);
 		
-	// Write "exit" message
-	if (write(STDOUT_FILENO, "exit\n", 5) == -1)
+	// Write "exit" message, only at an interactive prompt
+	if (shell->interactive && builtin_write(STDOUT_FILENO, "exit\n", 5) == -1)
 	{
 		// Even if write fails, continue with exit
 		print_error("exit", NULL, "write error");
@@ -0,0 +1,98 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_func.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/05 14:12:37 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/05 14:12:37 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Built-in local command - declares variables local to the current function
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	builtin_local(t_command *cmd, t_shell *shell)
+{
+	int		i;
+	char	*key;
+	char	*value;
+	int		status;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	if (!shell->frames)
+	{
+		print_error("local", NULL, "can only be used in a function");
+		return (ERROR);
+	}
+	status = SUCCESS;
+	i = 1;
+	while (cmd->args[i])
+	{
+		if (parse_variable_assignment(cmd->args[i], &key, &value) == ERROR)
+		{
+			print_error("local", cmd->args[i], "parse error");
+			status = ERROR;
+			i++;
+			continue ;
+		}
+		if (!is_valid_variable_name(key))
+		{
+			print_error("local", cmd->args[i], "not a valid identifier");
+			status = ERROR;
+		}
+		else if (set_local_variable(shell, key, value) != SUCCESS)
+		{
+			print_error("local", key, "failed to set variable");
+			status = ERROR;
+		}
+		ft_free(key);
+		ft_free(value);
+		i++;
+	}
+	return (status);
+}
+
+/**
+ * Built-in return command - leaves the current function or sourced script
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return Return status of the function
+ */
+int	builtin_return(t_command *cmd, t_shell *shell)
+{
+	int	status;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	if (!shell->frames && !shell->source_depth)
+	{
+		print_error("return", NULL,
+			"can only `return' from a function or sourced script");
+		return (ERROR);
+	}
+	status = shell->exit_status;
+	if (cmd->args[1])
+	{
+		if (!is_numeric(cmd->args[1]))
+		{
+			print_error("return", cmd->args[1], "numeric argument required");
+			status = SYNTAX_ERROR;
+		}
+		else
+		{
+			status = ft_atoi(cmd->args[1]) % 256;
+			if (status < 0)
+				status += 256;
+		}
+	}
+	shell->func_return = 1;
+	return (status);
+}
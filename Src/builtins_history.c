@@ -0,0 +1,128 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_history.c                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/12 15:48:03 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/12 15:48:03 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Print one numbered history entry through a line buffer
+ * @param out Output buffer of 4096 bytes
+ * @param len Bytes used in the buffer
+ * @param id Entry id (shown 1-based)
+ * @param text Entry text, or NULL to flush the buffer
+ * @return SUCCESS or ERROR
+ */
+static int	print_entry(char *out, size_t *len, int id, char *text)
+{
+	char	num[16];
+	size_t	need;
+	int		n;
+
+	n = 0;
+	if (text)
+		n = snprintf(num, sizeof(num), "%5d  ", id + 1);
+	need = n + (text ? ft_strlen(text) + 1 : 0);
+	if ((!text || *len + need > 4096) && *len)
+	{
+		if (builtin_write(STDOUT_FILENO, out, *len) == -1)
+			return (ERROR);
+		*len = 0;
+	}
+	if (!text)
+		return (SUCCESS);
+	if (need > 4096)
+	{
+		if (builtin_write(STDOUT_FILENO, num, n) == -1
+			|| builtin_write(STDOUT_FILENO, text, need - n - 1) == -1
+			|| builtin_write(STDOUT_FILENO, "\n", 1) == -1)
+			return (ERROR);
+		return (SUCCESS);
+	}
+	ft_memcpy(out + *len, num, n);
+	ft_memcpy(out + *len + n, text, need - n - 1);
+	out[*len + need - 1] = '\n';
+	*len += need;
+	return (SUCCESS);
+}
+
+/**
+ * Print every entry that contains a pattern, oldest first
+ * @param index History index
+ * @param pattern Text to search for
+ * @return SUCCESS, or ERROR on allocation or write failure
+ */
+static int	print_matches(t_hist_index *index, char *pattern)
+{
+	char	out[4096];
+	size_t	len;
+	int		*ids;
+	int		count;
+	int		id;
+
+	ids = (int *)ft_malloc(sizeof(int) * (index->next - index->first + 1));
+	if (!ids)
+		return (ERROR);
+	count = 0;
+	id = hist_index_search(index, pattern, index->next);
+	while (id >= 0)
+	{
+		ids[count++] = id;
+		id = hist_index_search(index, pattern, id);
+	}
+	len = 0;
+	while (count-- > 0)
+	{
+		if (print_entry(out, &len, ids[count],
+				hist_index_entry(index, ids[count])) != SUCCESS)
+			break ;
+	}
+	ft_free(ids);
+	if (count >= 0 || print_entry(out, &len, 0, NULL) != SUCCESS)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Built-in history command - lists, searches or clears the history
+ * Usage: history [-c | -s pattern]
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	builtin_history(t_command *cmd, t_shell *shell)
+{
+	t_hist_index	*index;
+
+	index = &shell->history.index;
+	if (cmd->args[1] && ft_strcmp(cmd->args[1], "-c") == 0 && !cmd->args[2])
+	{
+		hist_index_clear(index);
+		clear_history();
+		ft_free(shell->history.last);
+		shell->history.last = NULL;
+		return (SUCCESS);
+	}
+	if (cmd->args[1] && ft_strcmp(cmd->args[1], "-s") == 0)
+	{
+		if (!cmd->args[2] || cmd->args[3])
+		{
+			print_error("history", NULL, "usage: history [-c | -s pattern]");
+			return (SYNTAX_ERROR);
+		}
+		return (print_matches(index, cmd->args[2]));
+	}
+	if (cmd->args[1])
+	{
+		print_error("history", cmd->args[1], "invalid option");
+		return (SYNTAX_ERROR);
+	}
+	return (print_matches(index, ""));
+}
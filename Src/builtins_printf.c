@@ -0,0 +1,547 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_printf.c                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * printf [-v var] format [arguments]
+ *
+ * The whole output is formatted into memory first, then either written
+ * with one builtin_write, which lands in the builtin output buffer, or
+ * assigned to var without touching a descriptor. The format is reused
+ * while arguments remain; missing arguments read as "" or 0. Besides the
+ * C conversions for strings, characters, integers and floating point
+ * numbers, %b expands backslash escapes in its argument and %q quotes it
+ * for reuse as shell input.
+ */
+
+#define PRINTF_SPEC 64
+
+typedef struct s_printf
+{
+	t_shell	*shell;
+	char	**args;
+	int		next;
+	int		status;
+	int		stop;
+	char	*data;
+	size_t	len;
+	size_t	cap;
+}	t_printf;
+
+/* One conversion: its C specification and the converted argument */
+typedef struct s_conv
+{
+	char		spec[PRINTF_SPEC];
+	int			len;
+	char		type;
+	char		*text;
+	long long	number;
+	double		real;
+}	t_conv;
+
+/**
+ * Append bytes to the output
+ * @param p Formatter state
+ * @param s Bytes
+ * @param n Number of bytes
+ * @return SUCCESS or ERROR
+ */
+static int	out_put(t_printf *p, const char *s, size_t n)
+{
+	char	*grown;
+	size_t	cap;
+
+	if (p->len + n + 1 > p->cap)
+	{
+		cap = p->cap * 2 + 128;
+		while (cap < p->len + n + 1)
+			cap *= 2;
+		grown = ft_malloc(cap);
+		if (!grown)
+		{
+			// Stop formatting, the output could not be complete
+			p->status = ERROR;
+			p->stop = 1;
+			return (ERROR);
+		}
+		if (p->data)
+			ft_memcpy(grown, p->data, p->len);
+		ft_free(p->data);
+		p->data = grown;
+		p->cap = cap;
+	}
+	ft_memcpy(p->data + p->len, s, n);
+	p->len += n;
+	p->data[p->len] = '\0';
+	return (SUCCESS);
+}
+
+/**
+ * Take the next argument
+ * @param p Formatter state
+ * @return The argument, or "" when they ran out
+ */
+static char	*next_arg(t_printf *p)
+{
+	if (!p->args[p->next])
+		return ("");
+	return (p->args[p->next++]);
+}
+
+/**
+ * Convert up to max digits of a number in a small base
+ * @param s Digits
+ * @param base 8 or 16
+ * @param max Maximum number of digits
+ * @param value Converted value
+ * @return Number of digits used
+ */
+static int	small_number(const char *s, int base, int max, int *value)
+{
+	int	digit;
+	int	i;
+
+	*value = 0;
+	i = 0;
+	while (i < max && s[i])
+	{
+		digit = -1;
+		if (s[i] >= '0' && s[i] <= '7')
+			digit = s[i] - '0';
+		else if (base == 16 && ft_isdigit(s[i]))
+			digit = s[i] - '0';
+		else if (base == 16 && ft_strchr("abcdef", s[i] | 0x20))
+			digit = (s[i] | 0x20) - 'a' + 10;
+		if (digit < 0)
+			break ;
+		*value = *value * base + digit;
+		i++;
+	}
+	return (i);
+}
+
+/**
+ * Expand one backslash escape
+ * In %b arguments octal escapes are written \0NNN and \c ends all output
+ * @param p Formatter state
+ * @param s Text following the backslash
+ * @param in_arg Whether the escape is in a %b argument
+ * @return Number of characters used after the backslash
+ */
+static int	put_escape(t_printf *p, const char *s, int in_arg)
+{
+	static const char	*from = "\\abfnrtv\"'";
+	static const char	*to = "\\\a\b\f\n\r\t\v\"'";
+	int					used;
+	int					value;
+	char				c;
+
+	if (*s && ft_strchr(from, *s))
+	{
+		out_put(p, to + (ft_strchr(from, *s) - from), 1);
+		return (1);
+	}
+	if (in_arg && *s == 'c')
+	{
+		p->stop = 1;
+		return (1);
+	}
+	used = 0;
+	if (*s == 'x' && small_number(s + 1, 16, 2, &value))
+		used = 1 + small_number(s + 1, 16, 2, &value);
+	else if (in_arg && *s == '0')
+		used = 1 + small_number(s + 1, 8, 3, &value);
+	else if (*s >= '0' && *s <= '7')
+		used = small_number(s, 8, 3, &value);
+	if (!used)
+	{
+		out_put(p, "\\", 1);
+		return (0);
+	}
+	c = (char)value;
+	out_put(p, &c, 1);
+	return (used);
+}
+
+/**
+ * Expand the backslash escapes of a %b argument
+ * @param p Formatter state, the result is appended to the output
+ * @param arg Argument
+ */
+static void	put_escaped(t_printf *p, const char *arg)
+{
+	size_t	start;
+	size_t	i;
+
+	start = 0;
+	i = 0;
+	while (arg[i] && !p->stop)
+	{
+		if (arg[i] != '\\')
+		{
+			i++;
+			continue ;
+		}
+		out_put(p, arg + start, i - start);
+		i += 1 + put_escape(p, arg + i + 1, 1);
+		start = i;
+	}
+	if (!p->stop)
+		out_put(p, arg + start, i - start);
+}
+
+/**
+ * Quote an argument so the shell reads it back as one word
+ * @param p Formatter state, the result is appended to the output
+ * @param arg Argument
+ */
+static void	put_quoted(t_printf *p, const char *arg)
+{
+	size_t	i;
+
+	i = 0;
+	while (arg[i] && (ft_isalnum(arg[i]) || ft_strchr("_-+=.,:/@%^", arg[i])))
+		i++;
+	if (*arg && !arg[i])
+	{
+		out_put(p, arg, i);
+		return ;
+	}
+	// Single quotes keep everything but themselves
+	out_put(p, "'", 1);
+	i = 0;
+	while (arg[i])
+	{
+		if (arg[i] == '\'')
+			out_put(p, "'\\''", 4);
+		else
+			out_put(p, arg + i, 1);
+		i++;
+	}
+	out_put(p, "'", 1);
+}
+
+/**
+ * Report an argument that is not a valid number
+ * @param p Formatter state
+ * @param arg Argument
+ * @param message Error message
+ */
+static void	number_error(t_printf *p, char *arg, char *message)
+{
+	print_error("printf", arg, message);
+	p->status = ERROR;
+}
+
+/**
+ * Convert an integer argument; 'c takes the code of character c
+ * @param p Formatter state
+ * @param arg Argument
+ * @return Its value
+ */
+static long long	int_arg(t_printf *p, char *arg)
+{
+	long long	value;
+	char		*end;
+
+	if (arg[0] == '\'' || arg[0] == '"')
+		return ((unsigned char)arg[1]);
+	if (!*arg)
+		return (0);
+	errno = 0;
+	value = strtoll(arg, &end, 0);
+	if (end == arg || *end)
+		number_error(p, arg, "invalid number");
+	else if (errno == ERANGE)
+		number_error(p, arg, strerror(errno));
+	return (value);
+}
+
+/**
+ * Convert a floating point argument
+ * @param p Formatter state
+ * @param arg Argument
+ * @return Its value
+ */
+static double	float_arg(t_printf *p, char *arg)
+{
+	double	value;
+	char	*end;
+
+	if (arg[0] == '\'' || arg[0] == '"')
+		return ((unsigned char)arg[1]);
+	if (!*arg)
+		return (0);
+	value = strtod(arg, &end);
+	if (end == arg || *end)
+		number_error(p, arg, "invalid number");
+	return (value);
+}
+
+/**
+ * Run snprintf for a conversion
+ * @param buf Output buffer, NULL to measure
+ * @param size Size of buf
+ * @param conv Conversion with its converted value
+ * @return Length of the formatted value
+ */
+static int	render(char *buf, size_t size, t_conv *conv)
+{
+	if (conv->type == 'c')
+		return (snprintf(buf, size, conv->spec, conv->text[0]));
+	if (conv->type == 's')
+		return (snprintf(buf, size, conv->spec, conv->text));
+	if (ft_strchr("diouxX", conv->type))
+		return (snprintf(buf, size, conv->spec, conv->number));
+	return (snprintf(buf, size, conv->spec, conv->real));
+}
+
+/**
+ * Format one value with a C conversion specification
+ * @param p Formatter state
+ * @param conv Conversion, spec and type set
+ * @param arg Argument to convert
+ */
+static void	put_converted(t_printf *p, t_conv *conv, char *arg)
+{
+	char	*text;
+	int		n;
+
+	conv->text = arg;
+	if (ft_strchr("diouxX", conv->type))
+		conv->number = int_arg(p, arg);
+	else if (conv->type != 's' && conv->type != 'c')
+		conv->real = float_arg(p, arg);
+	n = render(NULL, 0, conv);
+	if (n <= 0)
+		return ;
+	text = ft_malloc(n + 1);
+	if (!text)
+	{
+		p->status = ERROR;
+		return ;
+	}
+	render(text, n + 1, conv);
+	out_put(p, text, n);
+	ft_free(text);
+}
+
+/**
+ * Copy digits of the format into the specification, or the value of the
+ * next argument for a *
+ * @param p Formatter state
+ * @param fmt Format
+ * @param i Position in the format, advanced past the number
+ * @param conv Conversion whose spec is extended
+ */
+static void	read_number(t_printf *p, char *fmt, int *i, t_conv *conv)
+{
+	if (fmt[*i] == '*')
+	{
+		(*i)++;
+		conv->len += snprintf(conv->spec + conv->len, 16, "%d",
+				(int)int_arg(p, next_arg(p)));
+		return ;
+	}
+	while (ft_isdigit(fmt[*i]))
+	{
+		if (conv->len < PRINTF_SPEC / 2)
+			conv->spec[conv->len++] = fmt[*i];
+		(*i)++;
+	}
+}
+
+/**
+ * Read the flags, width and precision of a conversion into its spec
+ * @param p Formatter state
+ * @param fmt Format, fmt[*i] follows the '%'
+ * @param i Position in the format, advanced to the conversion character
+ * @param conv Conversion to fill in
+ */
+static void	read_spec(t_printf *p, char *fmt, int *i, t_conv *conv)
+{
+	conv->spec[0] = '%';
+	conv->len = 1;
+	while (fmt[*i] && ft_strchr("-+ #0", fmt[*i]))
+	{
+		if (conv->len < 8)
+			conv->spec[conv->len++] = fmt[*i];
+		(*i)++;
+	}
+	read_number(p, fmt, i, conv);
+	if (fmt[*i] == '.')
+	{
+		conv->spec[conv->len++] = fmt[(*i)++];
+		read_number(p, fmt, i, conv);
+	}
+	// Length modifiers mean nothing here, integers are long long anyway
+	while (fmt[*i] && ft_strchr("hlLjzt", fmt[*i]))
+		(*i)++;
+	conv->type = fmt[*i];
+	if (conv->type)
+		(*i)++;
+	if (conv->type && ft_strchr("diouxX", conv->type))
+	{
+		conv->spec[conv->len++] = 'l';
+		conv->spec[conv->len++] = 'l';
+	}
+	conv->spec[conv->len++] = conv->type;
+	conv->spec[conv->len] = '\0';
+}
+
+/**
+ * Expand %b or %q, then pad the result like a string
+ * @param p Formatter state
+ * @param conv Conversion
+ */
+static void	put_expanded(t_printf *p, t_conv *conv)
+{
+	size_t	start;
+	char	*text;
+
+	start = p->len;
+	if (conv->type == 'b')
+		put_escaped(p, next_arg(p));
+	else
+		put_quoted(p, next_arg(p));
+	// Without width or precision the text is final, NUL bytes included
+	if (conv->len == 2)
+		return ;
+	text = ft_substr(p->data, start, p->len - start);
+	p->len = start;
+	if (!text)
+	{
+		p->status = ERROR;
+		return ;
+	}
+	conv->spec[conv->len - 1] = 's';
+	conv->type = 's';
+	put_converted(p, conv, text);
+	ft_free(text);
+}
+
+/**
+ * Expand one conversion of the format
+ * @param p Formatter state
+ * @param fmt Format, fmt[*i] follows the '%'
+ * @param i Position in the format, advanced past the conversion
+ */
+static void	put_conversion(t_printf *p, char *fmt, int *i)
+{
+	t_conv	conv;
+	char	bad[2];
+
+	ft_memset(&conv, 0, sizeof(t_conv));
+	read_spec(p, fmt, i, &conv);
+	if (conv.type && ft_strchr("diouxXcseEfFgGaA", conv.type))
+		put_converted(p, &conv, next_arg(p));
+	else if (conv.type == 'b' || conv.type == 'q')
+		put_expanded(p, &conv);
+	else if (conv.type == '%')
+		out_put(p, "%", 1);
+	else if (!conv.type)
+		number_error(p, "%", "missing format character");
+	else
+	{
+		bad[0] = conv.type;
+		bad[1] = '\0';
+		number_error(p, bad, "invalid format character");
+		p->stop = 1;
+	}
+}
+
+/**
+ * Expand the format once
+ * @param p Formatter state
+ * @param fmt Format
+ */
+static void	format_once(t_printf *p, char *fmt)
+{
+	int	start;
+	int	i;
+
+	start = 0;
+	i = 0;
+	while (fmt[i] && !p->stop)
+	{
+		if (fmt[i] != '%' && fmt[i] != '\\')
+		{
+			i++;
+			continue ;
+		}
+		out_put(p, fmt + start, i - start);
+		if (fmt[i++] == '\\')
+			i += put_escape(p, fmt + i, 0);
+		else
+			put_conversion(p, fmt, &i);
+		start = i;
+	}
+	if (!p->stop)
+		out_put(p, fmt + start, i - start);
+}
+
+/**
+ * Built-in printf: format and print arguments
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS, ERROR after a bad argument or write, 2 on misuse
+ */
+int	builtin_printf(t_command *cmd, t_shell *shell)
+{
+	t_printf	p;
+	char		*var;
+	int			i;
+	int			used;
+
+	ft_memset(&p, 0, sizeof(t_printf));
+	p.shell = shell;
+	var = NULL;
+	i = 1;
+	if (cmd->args[i] && ft_strcmp(cmd->args[i], "-v") == 0 && cmd->args[i + 1])
+	{
+		var = cmd->args[i + 1];
+		i += 2;
+		if (!is_valid_variable_name(var))
+		{
+			print_error("printf", var, "not a valid identifier");
+			return (2);
+		}
+	}
+	if (cmd->args[i] && ft_strcmp(cmd->args[i], "--") == 0)
+		i++;
+	if (!cmd->args[i])
+	{
+		print_error("printf", NULL, "usage: printf [-v var] format [arguments]");
+		return (2);
+	}
+	p.args = cmd->args + i + 1;
+	used = -1;
+	while (!p.stop && used != p.next && (used < 0 || p.args[p.next]))
+	{
+		used = p.next;
+		format_once(&p, cmd->args[i]);
+	}
+	if (!p.data)
+		out_put(&p, "", 0);
+	if (!p.data)
+		p.status = ERROR;
+	else if (var && assign_variable(shell, var, p.data) != SUCCESS)
+		p.status = ERROR;
+	else if (!var && p.len && builtin_write(STDOUT_FILENO, p.data, p.len) < 0)
+	{
+		print_error("printf", NULL, "write error");
+		p.status = ERROR;
+	}
+	ft_free(p.data);
+	return (p.status);
+}
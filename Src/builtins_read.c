@@ -0,0 +1,538 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_read.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+#include <poll.h>
+
+/*
+ * read [-r] [-d DELIM] [-n COUNT] [-t SECS] [-a NAME] [name...]
+ *
+ * Standard input is shared with the commands that run after read, so no
+ * byte past the delimiter may be consumed. Like the script reader, input
+ * is taken in chunks when that can be undone or cannot overshoot:
+ *
+ *   regular file     chunks, the offset is moved back after the line
+ *   terminal         one canonical line per read(2) when DELIM is newline
+ *   anything else    one byte at a time
+ *
+ * The shell has no arrays, so -a NAME sets NAME_0, NAME_1, ... and
+ * NAME_COUNT.
+ */
+
+#define READ_CHUNK 4096
+#define READ_TIMED_OUT 142
+
+typedef enum e_read_result
+{
+	READ_OK,
+	READ_EOF,
+	READ_TIMEOUT,
+	READ_INTERRUPTED,
+	READ_FAILED
+}	t_read_result;
+
+typedef struct s_read_opts
+{
+	int		raw;
+	char	delim;
+	long	nchars;
+	long	timeout;
+	char	*array;
+}	t_read_opts;
+
+/* Read-ahead over standard input */
+typedef struct s_read_in
+{
+	t_shell	*shell;
+	int		seekable;
+	size_t	chunk;
+	long	deadline;
+	ssize_t	len;
+	ssize_t	pos;
+	char	buf[READ_CHUNK];
+}	t_read_in;
+
+/* Line being read, quoted[i] marks bytes escaped by a backslash */
+typedef struct s_read_line
+{
+	char	*text;
+	char	*quoted;
+	size_t	len;
+	size_t	cap;
+}	t_read_line;
+
+/**
+ * Wait until input is available or the -t deadline passes
+ * @param in Input state
+ * @return READ_OK when input is ready
+ */
+static t_read_result	wait_input(t_read_in *in)
+{
+	struct pollfd	pfd;
+	long			left;
+	int				ready;
+
+	if (!in->deadline)
+		return (READ_OK);
+	left = in->deadline - monotonic_usec();
+	if (left < 0)
+		left = 0;
+	pfd.fd = STDIN_FILENO;
+	pfd.events = POLLIN;
+	ready = poll(&pfd, 1, (int)((left + 999) / 1000));
+	if (ready < 0 && errno == EINTR && in->shell->received_signal == SIGINT)
+		return (READ_INTERRUPTED);
+	if (ready < 0 && errno != EINTR)
+		return (READ_FAILED);
+	if (ready <= 0 && monotonic_usec() >= in->deadline)
+		return (READ_TIMEOUT);
+	return (READ_OK);
+}
+
+/**
+ * Take the next byte of input, refilling the read-ahead when it is empty
+ * @param in Input state
+ * @param c Byte read
+ * @return READ_OK or why no byte could be read
+ */
+static t_read_result	next_byte(t_read_in *in, char *c)
+{
+	t_read_result	result;
+
+	while (in->pos >= in->len)
+	{
+		result = wait_input(in);
+		if (result != READ_OK)
+			return (result);
+		in->pos = 0;
+		in->len = read(STDIN_FILENO, in->buf, in->chunk);
+		if (in->len == 0)
+			return (READ_EOF);
+		if (in->len > 0)
+			continue ;
+		in->len = 0;
+		if (errno == EINTR && in->shell->received_signal == SIGINT)
+			return (READ_INTERRUPTED);
+		if (errno != EINTR && errno != EAGAIN)
+			return (READ_FAILED);
+	}
+	*c = in->buf[in->pos++];
+	return (READ_OK);
+}
+
+/**
+ * Append a byte to the line
+ * @param line Line being read
+ * @param c Byte
+ * @param quoted Whether the byte was escaped
+ * @return SUCCESS or ERROR
+ */
+static int	line_push(t_read_line *line, char c, int quoted)
+{
+	char	*text;
+	char	*marks;
+	size_t	cap;
+
+	if (line->len + 1 >= line->cap)
+	{
+		cap = line->cap * 2 + 64;
+		text = ft_malloc(cap);
+		marks = ft_malloc(cap);
+		if (!text || !marks)
+		{
+			ft_free(text);
+			ft_free(marks);
+			return (ERROR);
+		}
+		ft_memcpy(text, line->text, line->len);
+		ft_memcpy(marks, line->quoted, line->len);
+		ft_free(line->text);
+		ft_free(line->quoted);
+		line->text = text;
+		line->quoted = marks;
+		line->cap = cap;
+	}
+	line->quoted[line->len] = quoted;
+	line->text[line->len++] = c;
+	line->text[line->len] = '\0';
+	return (SUCCESS);
+}
+
+/**
+ * Read up to the delimiter, processing backslashes unless -r was given
+ * @param in Input state
+ * @param opts Options
+ * @param line Line to fill in
+ * @return READ_OK when the delimiter or -n count was reached
+ */
+static t_read_result	read_input(t_read_in *in, t_read_opts *opts,
+	t_read_line *line)
+{
+	t_read_result	result;
+	char			c;
+	int				quoted;
+
+	while (opts->nchars < 0 || (long)line->len < opts->nchars)
+	{
+		result = next_byte(in, &c);
+		if (result != READ_OK)
+			return (result);
+		if (c == opts->delim)
+			return (READ_OK);
+		quoted = 0;
+		if (!opts->raw && c == '\\')
+		{
+			result = next_byte(in, &c);
+			if (result != READ_OK)
+				return (result);
+			// Backslash-newline continues the line
+			if (c == '\n')
+				continue ;
+			quoted = 1;
+		}
+		if (c && line_push(line, c, quoted) != SUCCESS)
+			return (READ_FAILED);
+	}
+	return (READ_OK);
+}
+
+/**
+ * Check whether a byte of the line separates fields
+ * @param line Line being split
+ * @param i Index of the byte
+ * @param ifs Field separators
+ * @param space Whether to only match IFS whitespace
+ * @return 1 for a separator
+ */
+static int	is_separator(t_read_line *line, size_t i, char *ifs, int space)
+{
+	char	c;
+
+	c = line->text[i];
+	if (line->quoted[i] || !c || !ft_strchr(ifs, c))
+		return (0);
+	return (!space || c == ' ' || c == '\t' || c == '\n');
+}
+
+/**
+ * Cut the next field and step over the separator after it: IFS
+ * whitespace, at most one other IFS character, IFS whitespace
+ * @param line Line being split
+ * @param ifs Field separators
+ * @param pos Position in the line, advanced past the separator
+ * @return The field or NULL on allocation failure
+ */
+static char	*next_field(t_read_line *line, char *ifs, size_t *pos)
+{
+	size_t	start;
+	char	*field;
+
+	start = *pos;
+	while (*pos < line->len && !is_separator(line, *pos, ifs, 0))
+		(*pos)++;
+	field = ft_substr(line->text, start, *pos - start);
+	while (*pos < line->len && is_separator(line, *pos, ifs, 1))
+		(*pos)++;
+	if (*pos < line->len && is_separator(line, *pos, ifs, 0))
+		(*pos)++;
+	while (*pos < line->len && is_separator(line, *pos, ifs, 1))
+		(*pos)++;
+	return (field);
+}
+
+/**
+ * Assign one variable and release its value
+ * @param shell Shell structure
+ * @param name Variable name
+ * @param value Value, NULL after an allocation failure
+ * @return SUCCESS or ERROR
+ */
+static int	assign_field(t_shell *shell, char *name, char *value)
+{
+	int	status;
+
+	status = ERROR;
+	if (value)
+		status = assign_variable(shell, name, value);
+	ft_free(value);
+	return (status);
+}
+
+/**
+ * Split the line into the elements of an -a array
+ * @param shell Shell structure
+ * @param line Line read
+ * @param ifs Field separators
+ * @param name Array name
+ * @return SUCCESS or ERROR
+ */
+static int	assign_array(t_shell *shell, t_read_line *line, char *ifs,
+	char *name)
+{
+	t_fields	fields;
+	size_t		pos;
+	int			status;
+
+	ft_memset(&fields, 0, sizeof(t_fields));
+	pos = 0;
+	while (pos < line->len && is_separator(line, pos, ifs, 1))
+		pos++;
+	status = SUCCESS;
+	while (pos < line->len && status == SUCCESS)
+		status = fields_push(&fields, next_field(line, ifs, &pos));
+	if (status == SUCCESS)
+		status = assign_list(shell, name, fields.items, fields.count);
+	free_string_array(fields.items);
+	return (status);
+}
+
+/**
+ * Split the line over the names, the last one takes the rest of it
+ * @param shell Shell structure
+ * @param line Line read
+ * @param names Variable names, NULL terminated
+ * @param opts Options
+ * @return SUCCESS or ERROR
+ */
+static int	assign_names(t_shell *shell, t_read_line *line, char **names,
+	t_read_opts *opts)
+{
+	char	*ifs;
+	size_t	pos;
+	size_t	end;
+
+	ifs = lookup_variable(shell, "IFS");
+	if (!ifs)
+		ifs = " \t\n";
+	if (opts->array)
+		return (assign_array(shell, line, ifs, opts->array));
+	if (!*names)
+		return (assign_field(shell, "REPLY", ft_strdup(line->text)));
+	pos = 0;
+	while (pos < line->len && is_separator(line, pos, ifs, 1))
+		pos++;
+	while (names[1])
+		if (assign_field(shell, *names++, next_field(line, ifs, &pos))
+			!= SUCCESS)
+			return (ERROR);
+	end = line->len;
+	while (end > pos && is_separator(line, end - 1, ifs, 1))
+		end--;
+	return (assign_field(shell, *names, ft_substr(line->text, pos,
+				end - pos)));
+}
+
+/**
+ * Report a bad option or operand
+ * @param arg Offending argument
+ * @param message Error message
+ * @return -1
+ */
+static int	read_error(char *arg, char *message)
+{
+	print_error("read", arg, message);
+	return (-1);
+}
+
+/**
+ * Apply an option that takes a value
+ * @param opts Options to fill in
+ * @param option Option letter
+ * @param value Option value
+ * @return 0 or -1 after reporting an invalid value
+ */
+static int	set_option(t_read_opts *opts, char option, char *value)
+{
+	char	*end;
+	double	seconds;
+
+	if (option == 'd')
+		opts->delim = value[0];
+	else if (option == 'n' && is_numeric(value) && ft_atoi(value) >= 0)
+		opts->nchars = ft_atoi(value);
+	else if (option == 'n')
+		return (read_error(value, "invalid number"));
+	else if (option == 't')
+	{
+		seconds = strtod(value, &end);
+		if (end == value || *end || seconds < 0)
+			return (read_error(value, "invalid timeout specification"));
+		if (seconds > 1e9)
+			seconds = 1e9;
+		opts->timeout = (long)(seconds * 1000000.0);
+	}
+	else if (!is_valid_variable_name(value))
+		return (read_error(value, "not a valid identifier"));
+	else
+		opts->array = value;
+	return (0);
+}
+
+/**
+ * Parse the options of read
+ * @param args Arguments of read
+ * @param opts Options to fill in
+ * @return Index of the first name, or -1 on error
+ */
+static int	parse_read_options(char **args, t_read_opts *opts)
+{
+	int	i;
+	int	j;
+
+	i = 1;
+	while (args[i] && args[i][0] == '-' && args[i][1])
+	{
+		if (ft_strcmp(args[i], "--") == 0)
+			return (i + 1);
+		j = 1;
+		while (args[i][j] == 'r' && ++j)
+			opts->raw = 1;
+		if (args[i][j] && !ft_strchr("dnta", args[i][j]))
+			return (read_error(args[i], "invalid option"));
+		if (args[i][j] && !args[i][j + 1] && !args[i + 1])
+			return (read_error(args[i], "option requires an argument"));
+		if (args[i][j] && args[i][j + 1]
+			&& set_option(opts, args[i][j], args[i] + j + 1) < 0)
+			return (-1);
+		if (args[i][j] && !args[i][j + 1]
+			&& set_option(opts, args[i][j], args[i + 1]) < 0)
+			return (-1);
+		// The value was the next argument
+		if (args[i][j] && !args[i][j + 1])
+			i++;
+		i++;
+	}
+	return (i);
+}
+
+/**
+ * Check the names and set up the read-ahead for standard input
+ * @param shell Shell structure
+ * @param opts Options
+ * @param names Variable names
+ * @param in Input state to fill in
+ * @return SUCCESS or ERROR
+ */
+static int	prepare_read(t_shell *shell, t_read_opts *opts, char **names,
+	t_read_in *in)
+{
+	struct stat	st;
+	int			i;
+
+	i = 0;
+	while (names[i])
+	{
+		if (!is_valid_variable_name(names[i]))
+		{
+			print_error("read", names[i], "not a valid identifier");
+			return (ERROR);
+		}
+		i++;
+	}
+	in->shell = shell;
+	in->len = 0;
+	in->pos = 0;
+	in->chunk = 1;
+	in->seekable = fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)
+		&& lseek(STDIN_FILENO, 0, SEEK_CUR) >= 0;
+	if (in->seekable)
+		in->chunk = READ_CHUNK;
+	else if (opts->delim == '\n' && opts->nchars < 0 && isatty(STDIN_FILENO))
+		in->chunk = READ_CHUNK;
+	in->deadline = 0;
+	if (opts->timeout > 0)
+		in->deadline = monotonic_usec() + opts->timeout;
+	return (SUCCESS);
+}
+
+/**
+ * Read a line and assign it to the names
+ * @param in Input state
+ * @param opts Options
+ * @param names Variable names
+ * @return Exit status of read
+ */
+static int	run_read(t_read_in *in, t_read_opts *opts, char **names)
+{
+	t_read_line		line;
+	t_read_result	result;
+	int				status;
+
+	ft_memset(&line, 0, sizeof(line));
+	status = ERROR;
+	// Start from an empty string, an empty line is still assigned
+	if (line_push(&line, '\0', 0) == SUCCESS)
+	{
+		line.len = 0;
+		// Reads must give way to Ctrl-C, which the prompt handlers restart
+		setup_exec_signals();
+		result = read_input(in, opts, &line);
+		setup_signals();
+		// Hand unused read-ahead back so the next reader starts after it
+		if (in->seekable && in->pos < in->len)
+			lseek(STDIN_FILENO, in->pos - in->len, SEEK_CUR);
+		if (result == READ_FAILED)
+			print_error("read", NULL, strerror(errno));
+		if (result == READ_OK || result == READ_EOF || result == READ_TIMEOUT)
+			status = assign_names(in->shell, &line, names, opts);
+		if (status == SUCCESS && result == READ_EOF)
+			status = ERROR;
+		else if (result == READ_TIMEOUT)
+			status = READ_TIMED_OUT;
+		else if (result == READ_INTERRUPTED)
+			status = 130;
+	}
+	ft_free(line.text);
+	ft_free(line.quoted);
+	return (status);
+}
+
+/**
+ * Built-in read: read a line from standard input into variables
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS, ERROR at end of input or on error, 142 on timeout,
+ * 130 if interrupted
+ */
+int	builtin_read(t_command *cmd, t_shell *shell)
+{
+	t_read_opts		opts;
+	t_read_in		*in;
+	struct pollfd	pfd;
+	int				first;
+	int				status;
+
+	ft_memset(&opts, 0, sizeof(opts));
+	opts.delim = '\n';
+	opts.nchars = -1;
+	opts.timeout = -1;
+	// A prompt written by an earlier builtin must show before waiting
+	builtin_flush();
+	first = parse_read_options(cmd->args, &opts);
+	if (first < 0)
+		return (2);
+	// -t 0 only reports whether input is waiting
+	if (opts.timeout == 0)
+	{
+		pfd.fd = STDIN_FILENO;
+		pfd.events = POLLIN;
+		return (poll(&pfd, 1, 0) != 1);
+	}
+	in = (t_read_in *)ft_malloc(sizeof(t_read_in));
+	if (!in)
+		return (ERROR);
+	status = prepare_read(shell, &opts, cmd->args + first, in);
+	if (status == SUCCESS)
+		status = run_read(in, &opts, cmd->args + first);
+	ft_free(in);
+	return (status);
+}
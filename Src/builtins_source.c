@@ -0,0 +1,346 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_source.c                                  :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * source FILE [args] and . FILE [args] run a script in the current shell,
+ * one line at a time as it is reached, so a large generated script starts
+ * at once and never has to fit in memory whole.
+ *
+ * A regular file is mapped privately and each newline is overwritten with
+ * the NUL the lexer needs; pages the script has moved past are handed
+ * back with MADV_DONTNEED. Anything else is read in large chunks, which
+ * is safe because the descriptor belongs to source alone; a line is
+ * copied out of the chunk buffer before it runs, since heredoc bodies
+ * read further lines into that buffer. Lines starting with # are
+ * comments.
+ */
+
+#define SOURCE_CHUNK 65536
+
+typedef struct s_source
+{
+	int		fd;
+	char	*map;
+	size_t	size;
+	size_t	pos;
+	size_t	released;
+	size_t	hold;
+	char	*buf;
+	size_t	len;
+	size_t	cap;
+	char	*tail;
+}	t_source;
+
+/**
+ * Open a script, mapping it when it is a regular file
+ * @param src Source to fill in
+ * @param name Script path
+ * @return SUCCESS or ERROR with errno set
+ */
+static int	source_open(t_source *src, char *name)
+{
+	struct stat	st;
+	int			ok;
+
+	ft_memset(src, 0, sizeof(t_source));
+	src->fd = open(name, O_RDONLY | O_CLOEXEC);
+	if (src->fd < 0)
+		return (ERROR);
+	ok = fstat(src->fd, &st) == 0;
+	if (ok && S_ISDIR(st.st_mode))
+	{
+		errno = EISDIR;
+		ok = 0;
+	}
+	if (!ok)
+	{
+		close(src->fd);
+		return (ERROR);
+	}
+	if (!S_ISREG(st.st_mode) || st.st_size == 0)
+		return (SUCCESS);
+	src->map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+			src->fd, 0);
+	if (src->map == MAP_FAILED)
+	{
+		src->map = NULL;
+		return (SUCCESS);
+	}
+	src->size = st.st_size;
+	close(src->fd);
+	src->fd = -1;
+	return (SUCCESS);
+}
+
+/**
+ * Release the mapping or buffer of a script
+ * @param src Source
+ */
+static void	source_close(t_source *src)
+{
+	if (src->map)
+		munmap(src->map, src->size);
+	if (src->fd >= 0)
+		close(src->fd);
+	ft_free(src->buf);
+	ft_free(src->tail);
+}
+
+/**
+ * Take the next line of a mapped script
+ * A last line without a newline may have no room for its NUL and is
+ * copied out
+ * @param src Source
+ * @return The line, NULL at the end of the script
+ */
+static char	*mapped_line(t_source *src)
+{
+	char	*line;
+	char	*nl;
+	size_t	page;
+	size_t	done;
+
+	// Pages wholly behind the running line are not needed again
+	page = sysconf(_SC_PAGESIZE);
+	done = src->hold / page * page;
+	if (done > src->released)
+	{
+		madvise(src->map + src->released, done - src->released,
+			MADV_DONTNEED);
+		src->released = done;
+	}
+	if (src->pos >= src->size)
+		return (NULL);
+	line = src->map + src->pos;
+	nl = ft_memchr(line, '\n', src->size - src->pos);
+	if (!nl)
+	{
+		src->tail = ft_substr(line, 0, src->size - src->pos);
+		src->pos = src->size;
+		return (src->tail);
+	}
+	*nl = '\0';
+	src->pos = nl + 1 - src->map;
+	return (line);
+}
+
+/**
+ * Read another chunk, moving the unread part to the front of the buffer
+ * @param src Source
+ * @return Bytes read, 0 at end of input, -1 on error
+ */
+static ssize_t	fill_chunk(t_source *src)
+{
+	char	*grown;
+	size_t	keep;
+	ssize_t	n;
+
+	keep = src->len - src->pos;
+	if (src->pos > 0 || keep + SOURCE_CHUNK + 1 > src->cap)
+	{
+		src->cap = keep + SOURCE_CHUNK + 1;
+		grown = ft_malloc(src->cap);
+		if (!grown)
+			return (-1);
+		if (keep)
+			ft_memcpy(grown, src->buf + src->pos, keep);
+		ft_free(src->buf);
+		src->buf = grown;
+		src->len = keep;
+		src->pos = 0;
+	}
+	n = read(src->fd, src->buf + src->len, SOURCE_CHUNK);
+	while (n < 0 && errno == EINTR)
+		n = read(src->fd, src->buf + src->len, SOURCE_CHUNK);
+	if (n > 0)
+		src->len += n;
+	return (n);
+}
+
+/**
+ * Take the next line of a script read in chunks
+ * @param src Source
+ * @return The line, NULL at the end of the script
+ */
+static char	*chunked_line(t_source *src)
+{
+	char	*line;
+	char	*nl;
+	ssize_t	n;
+
+	nl = NULL;
+	if (src->buf)
+		nl = ft_memchr(src->buf + src->pos, '\n', src->len - src->pos);
+	n = 1;
+	while (!nl && n > 0)
+	{
+		n = fill_chunk(src);
+		if (n > 0)
+			nl = ft_memchr(src->buf + src->pos, '\n', src->len - src->pos);
+	}
+	if (!nl && (n < 0 || src->pos == src->len))
+		return (NULL);
+	if (!nl)
+		nl = src->buf + src->len;
+	*nl = '\0';
+	line = src->buf + src->pos;
+	src->pos = nl - src->buf;
+	if (src->pos < src->len)
+		src->pos++;
+	return (line);
+}
+
+/**
+ * Take the next line of a script
+ * @param src Source
+ * @return The line, NULL at the end of the script
+ */
+static char	*next_line(t_source *src)
+{
+	if (src->map)
+		return (mapped_line(src));
+	return (chunked_line(src));
+}
+
+/**
+ * Supply a heredoc body line from the script being sourced
+ * @param ctx Source
+ * @return Tracked copy of the line, NULL at the end of the script
+ */
+static char	*source_body_line(void *ctx)
+{
+	char	*line;
+
+	line = next_line((t_source *)ctx);
+	if (!line)
+		return (NULL);
+	return (ft_strdup(line));
+}
+
+/**
+ * Run one line of a script
+ * The line runs nested inside the command that called source, whose
+ * tokens and AST must survive it
+ * @param shell Shell structure
+ * @param line Script line
+ * @return 1 if the line ran, 0 for a blank line or comment
+ */
+static int	source_line(t_shell *shell, char *line)
+{
+	t_token			*tokens;
+	t_command		*commands;
+	t_parse_entry	*entry;
+	int				i;
+
+	i = 0;
+	while (line[i] == ' ' || line[i] == '\t')
+		i++;
+	if (!line[i] || line[i] == '#')
+		return (0);
+	tokens = shell->tokens;
+	commands = shell->commands;
+	entry = shell->cached_entry;
+	shell->tokens = NULL;
+	shell->commands = NULL;
+	shell->cached_entry = NULL;
+	run_command_string(shell, line);
+	shell->tokens = tokens;
+	shell->commands = commands;
+	shell->cached_entry = entry;
+	return (1);
+}
+
+/**
+ * Run every line of a script until it ends, returns or is interrupted
+ * $? keeps the caller's status until the first command of the script
+ * has run
+ * @param shell Shell structure
+ * @param src Opened script
+ * @return Exit status of the last command, SUCCESS if none ran
+ */
+static int	source_run(t_shell *shell, t_source *src)
+{
+	char	*line;
+	int		status;
+
+	status = SUCCESS;
+	// A command killed by Ctrl-C abandons the rest of the script
+	while (shell->running && !shell->func_return && status != 128 + SIGINT)
+	{
+		src->hold = src->pos;
+		line = next_line(src);
+		if (line && !src->map)
+			line = ft_strdup(line);
+		if (!line)
+			break ;
+		if (source_line(shell, line))
+			status = shell->exit_status;
+		if (!src->map)
+			ft_free(line);
+	}
+	// A return ends the script, not the function around source
+	shell->func_return = 0;
+	return (status);
+}
+
+/**
+ * Built-in source and .: run a script in the current shell
+ * Arguments after the file become its positional parameters
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return Exit status of the script, ERROR if it cannot be read
+ */
+int	builtin_source(t_command *cmd, t_shell *shell)
+{
+	t_source		src;
+	t_line_source	lines;
+	t_line_source	*outer;
+	int				status;
+
+	if (!cmd->args[1])
+	{
+		print_error(cmd->args[0], NULL, "filename argument required");
+		return (SYNTAX_ERROR);
+	}
+	if (shell->source_depth >= FUNC_MAX_DEPTH)
+	{
+		print_error(cmd->args[0], cmd->args[1],
+			"maximum source nesting level exceeded");
+		return (ERROR);
+	}
+	if (source_open(&src, cmd->args[1]) != SUCCESS)
+	{
+		print_error(cmd->args[0], cmd->args[1], strerror(errno));
+		return (ERROR);
+	}
+	status = SUCCESS;
+	if (cmd->args[2])
+		status = push_frame(shell, cmd->args + 1);
+	if (status == SUCCESS)
+	{
+		// Heredocs in the script take their bodies from it, not stdin
+		lines.next = source_body_line;
+		lines.ctx = &src;
+		outer = shell->line_source;
+		shell->line_source = &lines;
+		shell->source_depth++;
+		status = source_run(shell, &src);
+		shell->source_depth--;
+		shell->line_source = outer;
+		if (cmd->args[2])
+			pop_frame(shell);
+	}
+	source_close(&src);
+	return (status);
+}
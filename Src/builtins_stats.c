@@ -0,0 +1,162 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_stats.c                                   :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Write a key=value line with an unsigned counter
+ * @param key Counter name
+ * @param value Counter value
+ * @return SUCCESS or ERROR
+ */
+static int	print_counter(char *key, unsigned long value)
+{
+	char	line[128];
+	int		len;
+
+	len = snprintf(line, sizeof(line), "%s=%lu\n", key, value);
+	if (len < 0 || builtin_write(STDOUT_FILENO, line, len) == -1)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Built-in parsecache command - shows or clears the parse cache
+ * Usage: parsecache [-c]
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	builtin_parsecache(t_command *cmd, t_shell *shell)
+{
+	t_parse_cache	*cache;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	cache = &shell->parse_cache;
+	if (cmd->args[1] && ft_strcmp(cmd->args[1], "-c") == 0)
+	{
+		parse_cache_clear(cache);
+		cache->hits = 0;
+		cache->misses = 0;
+		return (SUCCESS);
+	}
+	if (cmd->args[1])
+	{
+		print_error("parsecache", cmd->args[1], "invalid option");
+		return (SYNTAX_ERROR);
+	}
+	if (print_counter("hits", cache->hits) != SUCCESS
+		|| print_counter("misses", cache->misses) != SUCCESS
+		|| print_counter("entries", cache->count) != SUCCESS
+		|| print_counter("capacity", PARSE_CACHE_SIZE) != SUCCESS)
+	{
+		print_error("parsecache", NULL, "write error");
+		return (ERROR);
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Write the allocation counters of one subsystem on a single line
+ * @param name Subsystem name
+ * @param tag Subsystem, or MEM_TAGS for the totals
+ * @return SUCCESS or ERROR
+ */
+static int	print_mem_line(char *name, t_mem_tag tag)
+{
+	t_mem_stats	stats;
+	char		line[160];
+	int			len;
+
+	mem_stats(tag, &stats);
+	len = snprintf(line, sizeof(line),
+			"%-9s live=%zu peak=%zu allocs=%lu frees=%lu\n", name,
+			stats.live, stats.peak, stats.allocs, stats.frees);
+	if (len < 0 || builtin_write(STDOUT_FILENO, line, len) == -1)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Built-in memstats command - shows or resets allocation counters
+ * Usage: memstats [-r]
+ * Live bytes are never reset, -r restarts the counts and the peaks
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	builtin_memstats(t_command *cmd, t_shell *shell)
+{
+	static char	*names[MEM_TAGS + 1] = {"other", "lexer", "parser", "env",
+		"heredoc", "executor", "total"};
+	int			i;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	if (cmd->args[1] && ft_strcmp(cmd->args[1], "-r") == 0 && !cmd->args[2])
+	{
+		mem_stats_reset();
+		return (SUCCESS);
+	}
+	if (cmd->args[1])
+	{
+		print_error("memstats", cmd->args[1], "invalid option");
+		return (SYNTAX_ERROR);
+	}
+	i = 0;
+	while (i <= MEM_TAGS)
+	{
+		if (print_mem_line(names[i], (t_mem_tag)i) != SUCCESS)
+		{
+			print_error("memstats", NULL, "write error");
+			return (ERROR);
+		}
+		i++;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Built-in shellstats command - shows or resets the runtime counters
+ * Usage: shellstats [-j | -r]
+ * Set MINISHELL_STATS_FILE to also get them as JSON when the shell exits
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	builtin_shellstats(t_command *cmd, t_shell *shell)
+{
+	int	json;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	json = 0;
+	if (cmd->args[1] && !cmd->args[2] && ft_strcmp(cmd->args[1], "-r") == 0)
+	{
+		stats_reset();
+		return (SUCCESS);
+	}
+	if (cmd->args[1] && !cmd->args[2] && ft_strcmp(cmd->args[1], "-j") == 0)
+		json = 1;
+	else if (cmd->args[1])
+	{
+		print_error("shellstats", cmd->args[1], "invalid option");
+		return (SYNTAX_ERROR);
+	}
+	if (stats_print(STDOUT_FILENO, json) != SUCCESS)
+	{
+		print_error("shellstats", NULL, "write error");
+		return (ERROR);
+	}
+	return (SUCCESS);
+}
@@ -0,0 +1,645 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_test.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * test EXPR, [ EXPR ] and [[ EXPR ]]
+ *
+ * All three share one evaluator over the POSIX unary and binary operators
+ * with !, ( ), -a and -o. File operators stat through fstatat, and the
+ * result is kept for the rest of the expression, so [ -f x -a -s x ]
+ * costs one system call; -r, -w and -x ask faccessat for the effective
+ * ids instead.
+ *
+ * [[ gets its operands unsplit and unglobbed, in the escaped pattern form
+ * of expand_command: == and != match the right operand as a pattern and
+ * =~ as an extended regex, compiled once per pattern in the shell's regex
+ * cache. && is an ordinary word to the lexer and works inside [[, and the
+ * parser hands < and > over as words; | ends the command, so [[ also
+ * takes -a and -o, while (, ) and || must be quoted there. Capture groups of =~ are stored in
+ * BASH_REMATCH_0, BASH_REMATCH_1, ... and BASH_REMATCH_COUNT.
+ */
+
+#define TEST_STAT_SLOTS 4
+#define TEST_MAX_GROUPS 10
+#define TEST_SYNTAX 2
+
+typedef struct s_test_stat
+{
+	char		*path;
+	int			follow;
+	int			result;
+	struct stat	st;
+}	t_test_stat;
+
+/* Expression being evaluated; raw holds the pattern forms for [[ */
+typedef struct s_test
+{
+	t_shell		*shell;
+	char		*name;
+	char		**args;
+	char		**raw;
+	int			end;
+	int			pos;
+	int			extended;
+	int			error;
+	int			next_slot;
+	t_test_stat	stats[TEST_STAT_SLOTS];
+}	t_test;
+
+/**
+ * Report a malformed expression, only the first error is printed
+ * @param t Expression
+ * @param arg Offending operand, or NULL
+ * @param message Error message
+ * @return 0, the value of a failed test
+ */
+static int	test_error(t_test *t, char *arg, char *message)
+{
+	if (!t->error)
+		print_error(t->name, arg, message);
+	t->error = 1;
+	return (0);
+}
+
+/**
+ * stat a path once per expression
+ * @param t Expression
+ * @param path Path operand
+ * @param follow Whether to follow a final symlink
+ * @return Cached stat result, NULL if the path does not exist
+ */
+static struct stat	*test_stat(t_test *t, char *path, int follow)
+{
+	t_test_stat	*slot;
+	int			i;
+
+	slot = NULL;
+	i = 0;
+	while (!slot && i < TEST_STAT_SLOTS)
+	{
+		slot = &t->stats[i++];
+		if (!slot->path || slot->follow != follow
+			|| ft_strcmp(slot->path, path) != 0)
+			slot = NULL;
+	}
+	if (!slot)
+	{
+		slot = &t->stats[t->next_slot];
+		t->next_slot = (t->next_slot + 1) % TEST_STAT_SLOTS;
+		slot->path = path;
+		slot->follow = follow;
+		if (follow)
+			slot->result = fstatat(AT_FDCWD, path, &slot->st, 0);
+		else
+			slot->result = fstatat(AT_FDCWD, path, &slot->st,
+					AT_SYMLINK_NOFOLLOW);
+	}
+	if (slot->result != 0)
+		return (NULL);
+	return (&slot->st);
+}
+
+/**
+ * Evaluate a file operator
+ * @param t Expression
+ * @param op Operator letter
+ * @param path Path operand
+ * @return Result of the test
+ */
+static int	file_test(t_test *t, char op, char *path)
+{
+	struct stat	*st;
+
+	// Permissions go to the kernel, which knows ACLs, capabilities and
+	// read-only mounts that the mode bits do not show
+	if (op == 'r')
+		return (faccessat(AT_FDCWD, path, R_OK, AT_EACCESS) == 0);
+	if (op == 'w')
+		return (faccessat(AT_FDCWD, path, W_OK, AT_EACCESS) == 0);
+	if (op == 'x')
+		return (faccessat(AT_FDCWD, path, X_OK, AT_EACCESS) == 0);
+	st = test_stat(t, path, op != 'h' && op != 'L');
+	if (!st)
+		return (0);
+	if (op == 'b' || op == 'c' || op == 'd' || op == 'f' || op == 'p'
+		|| op == 'S' || op == 'h' || op == 'L')
+		return ((op == 'b' && S_ISBLK(st->st_mode))
+			|| (op == 'c' && S_ISCHR(st->st_mode))
+			|| (op == 'd' && S_ISDIR(st->st_mode))
+			|| (op == 'f' && S_ISREG(st->st_mode))
+			|| (op == 'p' && S_ISFIFO(st->st_mode))
+			|| (op == 'S' && S_ISSOCK(st->st_mode))
+			|| ((op == 'h' || op == 'L') && S_ISLNK(st->st_mode)));
+	if (op == 'g' || op == 'u' || op == 'k')
+		return ((op == 'g' && (st->st_mode & S_ISGID))
+			|| (op == 'u' && (st->st_mode & S_ISUID))
+			|| (op == 'k' && (st->st_mode & S_ISVTX)));
+	if (op == 's')
+		return (st->st_size > 0);
+	if (op == 'O')
+		return (st->st_uid == geteuid());
+	if (op == 'G')
+		return (st->st_gid == getegid());
+	return (1);
+}
+
+/**
+ * Check whether an operand is a unary operator
+ * @param arg Operand
+ * @return Operator letter, or 0
+ */
+static char	unary_op(char *arg)
+{
+	if (arg[0] == '-' && arg[1] && !arg[2]
+		&& ft_strchr("bcdefghkLnOGprsStuwxz", arg[1]))
+		return (arg[1]);
+	return (0);
+}
+
+/**
+ * Evaluate a unary operator
+ * @param t Expression
+ * @param op Operator letter
+ * @param arg Operand
+ * @return Result of the test
+ */
+static int	unary_test(t_test *t, char op, char *arg)
+{
+	if (op == 'n')
+		return (arg[0] != '\0');
+	if (op == 'z')
+		return (arg[0] == '\0');
+	if (op == 't' && !is_numeric(arg))
+		return (test_error(t, arg, "integer expression expected"));
+	if (op == 't')
+		return (isatty(ft_atoi(arg)));
+	return (file_test(t, op, arg));
+}
+
+/**
+ * Check whether an operand is a binary operator
+ * @param t Expression
+ * @param arg Operand
+ * @return 1 for a binary operator
+ */
+static int	is_binary(t_test *t, char *arg)
+{
+	static const char	*ops[] = {"=", "==", "!=", "<", ">", "-eq", "-ne",
+		"-lt", "-le", "-gt", "-ge", "-nt", "-ot", "-ef", NULL};
+	int					i;
+
+	if (t->extended && ft_strcmp(arg, "=~") == 0)
+		return (1);
+	i = 0;
+	while (ops[i] && ft_strcmp(ops[i], arg) != 0)
+		i++;
+	return (ops[i] != NULL);
+}
+
+/**
+ * Parse an integer operand, blanks around it are allowed
+ * @param t Expression
+ * @param arg Operand
+ * @return Its value, 0 after reporting a bad integer
+ */
+static long long	test_integer(t_test *t, char *arg)
+{
+	char		*end;
+	long long	value;
+
+	errno = 0;
+	value = strtoll(arg, &end, 10);
+	while (*end == ' ' || *end == '\t')
+		end++;
+	if (end == arg || *end || errno == ERANGE)
+		return (test_error(t, arg, "integer expression expected"));
+	return (value);
+}
+
+/**
+ * Compare two integers
+ * @param t Expression
+ * @param op Operator, one of -eq -ne -lt -le -gt -ge
+ * @param left Left operand
+ * @param right Right operand
+ * @return Result of the comparison
+ */
+static int	integer_test(t_test *t, char *op, char *left, char *right)
+{
+	long long	a;
+	long long	b;
+
+	a = test_integer(t, left);
+	b = test_integer(t, right);
+	if (op[1] == 'e' && op[2] == 'q')
+		return (a == b);
+	if (op[1] == 'n')
+		return (a != b);
+	if (op[1] == 'l' && op[2] == 't')
+		return (a < b);
+	if (op[1] == 'l')
+		return (a <= b);
+	if (op[2] == 't')
+		return (a > b);
+	return (a >= b);
+}
+
+/**
+ * Compare two files by modification time or identity
+ * @param t Expression
+ * @param op Operator, one of -nt -ot -ef
+ * @param left Left path
+ * @param right Right path
+ * @return Result of the comparison
+ */
+static int	file_compare(t_test *t, char *op, char *left, char *right)
+{
+	struct stat	*a;
+	struct stat	*b;
+
+	a = test_stat(t, left, 1);
+	b = test_stat(t, right, 1);
+	if (op[1] == 'e')
+		return (a && b && a->st_dev == b->st_dev && a->st_ino == b->st_ino);
+	if (op[1] == 'o')
+	{
+		a = b;
+		b = test_stat(t, left, 1);
+	}
+	if (!a || !b)
+		return (a != NULL);
+	if (a->st_mtim.tv_sec != b->st_mtim.tv_sec)
+		return (a->st_mtim.tv_sec > b->st_mtim.tv_sec);
+	return (a->st_mtim.tv_nsec > b->st_mtim.tv_nsec);
+}
+
+/**
+ * Get the compiled form of a regex, compiling it on first use
+ * @param cache Regex cache
+ * @param pattern Extended regular expression
+ * @param err regcomp error code on failure
+ * @return Compiled regex, NULL on error
+ */
+static regex_t	*regex_lookup(t_regex_cache *cache, char *pattern, int *err)
+{
+	t_regex_entry	*slot;
+
+	slot = &cache->slots[hash_line(pattern) % REGEX_CACHE_SLOTS];
+	if (slot->pattern && ft_strcmp(slot->pattern, pattern) == 0)
+	{
+		cache->hits++;
+		return (&slot->re);
+	}
+	if (slot->pattern)
+	{
+		regfree(&slot->re);
+		ft_free(slot->pattern);
+		slot->pattern = NULL;
+	}
+	*err = regcomp(&slot->re, pattern, REG_EXTENDED);
+	if (*err != 0)
+		return (NULL);
+	slot->pattern = ft_strdup(pattern);
+	if (!slot->pattern)
+	{
+		regfree(&slot->re);
+		*err = REG_ESPACE;
+		return (NULL);
+	}
+	cache->compiles++;
+	return (&slot->re);
+}
+
+/**
+ * Free every compiled regex of the cache
+ * @param cache Regex cache
+ */
+void	regex_cache_clear(t_regex_cache *cache)
+{
+	int	i;
+
+	i = 0;
+	while (i < REGEX_CACHE_SLOTS)
+	{
+		if (cache->slots[i].pattern)
+		{
+			regfree(&cache->slots[i].re);
+			ft_free(cache->slots[i].pattern);
+			cache->slots[i].pattern = NULL;
+		}
+		i++;
+	}
+}
+
+/**
+ * Store the match and capture groups of =~ in BASH_REMATCH_n
+ * @param t Expression
+ * @param text Matched string
+ * @param groups Match offsets
+ * @param count Number of groups including the whole match, 0 if none
+ */
+static void	set_rematch(t_test *t, char *text, regmatch_t *groups, int count)
+{
+	char	*items[TEST_MAX_GROUPS];
+	int		i;
+
+	i = 0;
+	while (i < count)
+	{
+		if (groups[i].rm_so < 0)
+			items[i] = ft_strdup("");
+		else
+			items[i] = ft_substr(text, groups[i].rm_so,
+					groups[i].rm_eo - groups[i].rm_so);
+		if (!items[i])
+			count = i;
+		i++;
+	}
+	assign_list(t->shell, "BASH_REMATCH", items, count);
+	while (count-- > 0)
+		ft_free(items[count]);
+}
+
+/**
+ * Match a string against an extended regex
+ * @param t Expression
+ * @param text Left operand
+ * @param pattern Right operand, quoted characters are escaped
+ * @return 1 on match
+ */
+static int	regex_test(t_test *t, char *text, char *pattern)
+{
+	regmatch_t	groups[TEST_MAX_GROUPS];
+	regex_t		*re;
+	char		message[128];
+	int			err;
+	int			count;
+
+	re = regex_lookup(&t->shell->regex_cache, pattern, &err);
+	if (!re)
+	{
+		regerror(err, NULL, message, sizeof(message));
+		return (test_error(t, pattern, message));
+	}
+	if (regexec(re, text, TEST_MAX_GROUPS, groups, 0) != 0)
+	{
+		set_rematch(t, text, groups, 0);
+		return (0);
+	}
+	count = re->re_nsub + 1;
+	if (count > TEST_MAX_GROUPS)
+		count = TEST_MAX_GROUPS;
+	set_rematch(t, text, groups, count);
+	return (1);
+}
+
+/**
+ * Evaluate a binary operator
+ * @param t Expression
+ * @param i Index of the left operand
+ * @return Result of the test
+ */
+static int	binary_test(t_test *t, int i)
+{
+	char	*op;
+	char	*left;
+	char	*right;
+	int		match;
+
+	left = t->args[i];
+	op = t->args[i + 1];
+	right = t->args[i + 2];
+	if (op[0] == '-' && (op[1] == 'n' || op[1] == 'o' || op[1] == 'e')
+		&& (op[2] == 't' || op[2] == 'f'))
+		return (file_compare(t, op, left, right));
+	if (op[0] == '-')
+		return (integer_test(t, op, left, right));
+	if (op[0] == '<')
+		return (ft_strcmp(left, right) < 0);
+	if (op[0] == '>')
+		return (ft_strcmp(left, right) > 0);
+	if (op[1] == '~')
+		return (regex_test(t, left, t->raw[i + 2]));
+	if (t->extended)
+		match = glob_pattern_match(t->raw[i + 2], left);
+	else
+		match = ft_strcmp(left, right) == 0;
+	if (match < 0)
+		return (test_error(t, NULL, strerror(ENOMEM)));
+	return (match == (op[0] != '!'));
+}
+
+static int	eval_or(t_test *t);
+
+/**
+ * Evaluate a primary: a binary or unary test, a group or a string
+ * @param t Expression
+ * @return Result
+ */
+static int	eval_primary(t_test *t)
+{
+	char	*arg;
+	int		left;
+	int		value;
+
+	if (t->pos >= t->end)
+		return (test_error(t, NULL, "argument expected"));
+	arg = t->args[t->pos];
+	left = t->end - t->pos;
+	if (left >= 3 && is_binary(t, t->args[t->pos + 1]))
+	{
+		t->pos += 3;
+		return (binary_test(t, t->pos - 3));
+	}
+	if (left >= 2 && ft_strcmp(arg, "(") == 0)
+	{
+		t->pos++;
+		value = eval_or(t);
+		if (t->pos >= t->end || ft_strcmp(t->args[t->pos], ")") != 0)
+			return (test_error(t, NULL, "`)' expected"));
+		t->pos++;
+		return (value);
+	}
+	if (left >= 2 && unary_op(arg))
+	{
+		t->pos += 2;
+		return (unary_test(t, unary_op(arg), t->args[t->pos - 1]));
+	}
+	t->pos++;
+	return (arg[0] != '\0');
+}
+
+/**
+ * Evaluate a negation, a lone ! is a non-empty string
+ * @param t Expression
+ * @return Result
+ */
+static int	eval_not(t_test *t)
+{
+	if (t->end - t->pos >= 2 && ft_strcmp(t->args[t->pos], "!") == 0)
+	{
+		t->pos++;
+		return (!eval_not(t));
+	}
+	return (eval_primary(t));
+}
+
+/**
+ * Check whether the next operand is a connective
+ * @param t Expression
+ * @param test_op Operator of test and [, also taken by [[
+ * @param extended_op Operator of [[ alone
+ * @return 1 if it is, and it has been consumed
+ */
+static int	take_connective(t_test *t, char *test_op, char *extended_op)
+{
+	char	*arg;
+
+	if (t->pos >= t->end - 1 || t->error)
+		return (0);
+	arg = t->args[t->pos];
+	if (ft_strcmp(arg, test_op) != 0
+		&& (!t->extended || ft_strcmp(arg, extended_op) != 0))
+		return (0);
+	t->pos++;
+	return (1);
+}
+
+/**
+ * Evaluate a conjunction, -a or &&
+ * @param t Expression
+ * @return Result
+ */
+static int	eval_and(t_test *t)
+{
+	int	value;
+
+	value = eval_not(t);
+	while (take_connective(t, "-a", "&&"))
+		value = eval_not(t) && value;
+	return (value);
+}
+
+/**
+ * Evaluate a disjunction, -o or ||
+ * @param t Expression
+ * @return Result
+ */
+static int	eval_or(t_test *t)
+{
+	int	value;
+
+	value = eval_and(t);
+	while (take_connective(t, "-o", "||"))
+		value = eval_and(t) || value;
+	return (value);
+}
+
+/**
+ * Evaluate the whole expression
+ * Three and four operand forms follow the POSIX rules, so that
+ * [ ! = x ] compares strings instead of negating one
+ * @param t Expression
+ * @return Exit status of the test
+ */
+static int	eval_test(t_test *t)
+{
+	int	value;
+
+	if (t->end == 0)
+		return (1);
+	if (!t->extended && t->end == 3 && is_binary(t, t->args[1]))
+		value = binary_test(t, 0);
+	else if (!t->extended && t->end == 4 && ft_strcmp(t->args[0], "!") == 0
+		&& is_binary(t, t->args[2]))
+		value = !binary_test(t, 1);
+	else
+	{
+		value = eval_or(t);
+		if (t->pos < t->end)
+			test_error(t, t->args[t->pos], "too many arguments");
+	}
+	if (t->error)
+		return (TEST_SYNTAX);
+	return (!value);
+}
+
+/**
+ * Give [[ its operands without the pattern escapes, keeping the
+ * escaped forms in raw for the pattern operands
+ * @param t Expression
+ * @return SUCCESS or ERROR
+ */
+static int	unescape_operands(t_test *t)
+{
+	int	i;
+
+	t->raw = t->args;
+	t->args = (char **)ft_malloc(sizeof(char *) * (t->end + 1));
+	if (!t->args)
+		return (ERROR);
+	i = 0;
+	while (i < t->end)
+	{
+		t->args[i] = ft_strdup(t->raw[i]);
+		if (!t->args[i])
+		{
+			t->args[i] = NULL;
+			return (ERROR);
+		}
+		unescape_field(t->args[i++]);
+	}
+	t->args[i] = NULL;
+	return (SUCCESS);
+}
+
+/**
+ * Built-in test, [ and [[: evaluate a conditional expression
+ * @param cmd Command structure
+ * @param shell Shell structure
+ * @return 0 if true, 1 if false, 2 on a malformed expression
+ */
+int	builtin_test(t_command *cmd, t_shell *shell)
+{
+	t_test	t;
+	char	*closing;
+	int		status;
+
+	ft_memset(&t, 0, sizeof(t_test));
+	t.shell = shell;
+	t.name = cmd->args[0];
+	t.args = cmd->args + 1;
+	t.extended = ft_strcmp(t.name, "[[") == 0;
+	while (t.args[t.end])
+		t.end++;
+	closing = "]";
+	if (t.extended)
+		closing = "]]";
+	if (ft_strcmp(t.name, "test") != 0)
+	{
+		if (!t.end || ft_strcmp(t.args[t.end - 1], closing) != 0)
+		{
+			print_error(t.name, NULL, "missing closing bracket");
+			return (TEST_SYNTAX);
+		}
+		t.end--;
+	}
+	t.raw = t.args;
+	status = ERROR;
+	if (!t.extended || unescape_operands(&t) == SUCCESS)
+		status = eval_test(&t);
+	if (t.extended)
+		free_string_array(t.args);
+	return (status);
+}
@@ -0,0 +1,171 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   builtins_timeout.c                                 :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * timeout [-s SIG] [-k KILLAFTER] DURATION command [args...]
+ *
+ * Unlike coreutils there is no timeout process: the stage's own child
+ * runs the command in a new process group and the wait loop of the
+ * shell signals that group when the deadline passes. The exit status
+ * is 124 when the command timed out (137 if it had to be killed), 125
+ * when timeout itself is misused, and the command's status otherwise.
+ */
+
+/**
+ * Convert a signal name or number
+ * @param name KILL, SIGKILL or 9
+ * @return Signal number or -1
+ */
+static int	signal_number(char *name)
+{
+	static const char	*names[] = {"HUP", "INT", "QUIT", "KILL", "USR1",
+		"USR2", "ALRM", "TERM", "CONT", "STOP", NULL};
+	static const int	numbers[] = {SIGHUP, SIGINT, SIGQUIT, SIGKILL,
+		SIGUSR1, SIGUSR2, SIGALRM, SIGTERM, SIGCONT, SIGSTOP};
+	int					i;
+
+	if (is_numeric(name))
+	{
+		i = ft_atoi(name);
+		if (i > 0 && i < NSIG)
+			return (i);
+		return (-1);
+	}
+	if (ft_strncmp(name, "SIG", 3) == 0)
+		name += 3;
+	i = 0;
+	while (names[i] && ft_strcmp(names[i], name) != 0)
+		i++;
+	if (!names[i])
+		return (-1);
+	return (numbers[i]);
+}
+
+/**
+ * Parse a duration: a decimal number with an optional s, m, h or d suffix
+ * @param text Duration operand
+ * @return Microseconds, or -1 if invalid
+ */
+static long	parse_duration(char *text)
+{
+	char	*end;
+	double	value;
+
+	value = strtod(text, &end);
+	if (end == text || value < 0)
+		return (-1);
+	if (*end == 'm')
+		value *= 60;
+	else if (*end == 'h')
+		value *= 3600;
+	else if (*end == 'd')
+		value *= 86400;
+	else if (*end && *end != 's')
+		return (-1);
+	if (*end && end[1])
+		return (-1);
+	// Anything longer than a few centuries is as good as no deadline
+	if (value > 1e10)
+		value = 1e10;
+	return ((long)(value * 1000000.0));
+}
+
+/**
+ * Report misuse of timeout
+ * @param arg Offending argument, or NULL
+ * @param message Error message
+ * @return ERROR
+ */
+static int	timeout_error(char *arg, char *message)
+{
+	print_error("timeout", arg, message);
+	return (ERROR);
+}
+
+/**
+ * Parse the -s and -k options
+ * @param args Arguments of timeout
+ * @param timeout Deadline to fill in
+ * @return Index of DURATION, or -1 on error
+ */
+static int	parse_options(char **args, t_timeout *timeout)
+{
+	int	i;
+
+	i = 1;
+	while (args[i] && args[i][0] == '-' && args[i][1])
+	{
+		if (ft_strcmp(args[i], "--") == 0)
+			return (i + 1);
+		if (ft_strcmp(args[i], "-s") == 0 && args[i + 1])
+		{
+			timeout->signal = signal_number(args[++i]);
+			if (timeout->signal < 0)
+				return (-timeout_error(args[i], "invalid signal"));
+		}
+		else if (ft_strcmp(args[i], "-k") == 0 && args[i + 1])
+		{
+			timeout->kill_after = parse_duration(args[++i]);
+			if (timeout->kill_after < 0)
+				return (-timeout_error(args[i], "invalid time interval"));
+		}
+		else
+			return (-timeout_error(args[i], "invalid option"));
+		i++;
+	}
+	return (i);
+}
+
+/**
+ * Turn a timeout stage into a stage running its command with a deadline
+ * The timeout words are removed from cmd->args, which the next
+ * expansion rebuilds
+ * @param stage Stage whose command starts with timeout
+ * @param cmd Command of the stage
+ * @return SUCCESS, or ERROR after reporting misuse
+ */
+int	timeout_prepare(t_stage *stage, t_command *cmd)
+{
+	t_timeout	*timeout;
+	long		duration;
+	int			first;
+	int			i;
+
+	timeout = &stage->timeout;
+	ft_memset(timeout, 0, sizeof(t_timeout));
+	timeout->signal = SIGTERM;
+	first = parse_options(cmd->args, timeout);
+	if (first < 0)
+		return (ERROR);
+	if (!cmd->args[first] || !cmd->args[first + 1])
+		return (timeout_error(NULL, "missing operand"));
+	duration = parse_duration(cmd->args[first]);
+	if (duration < 0)
+		return (timeout_error(cmd->args[first], "invalid time interval"));
+	i = 0;
+	while (i <= first)
+		ft_free(cmd->args[i++]);
+	i = 0;
+	while (cmd->args[first + 1 + i])
+	{
+		cmd->args[i] = cmd->args[first + 1 + i];
+		i++;
+	}
+	cmd->args[i] = NULL;
+	timeout->active = 1;
+	// A zero duration runs the command without a deadline
+	if (duration > 0)
+		timeout->deadline = monotonic_usec() + duration;
+	return (SUCCESS);
+}
@@ -12,6 +12,114 @@
 
 #include "../Inc/minishell.h"
 
+/*
+ * Builtins write to stdout through one buffer, so a script running many
+ * small echo or printf commands does not make a system call for each of
+ * them. The buffer is flushed before anything else could write to the
+ * same file: before forking, around redirections, before error messages,
+ * at the prompt and when the shell exits. A terminal is written directly.
+ */
+
+#define BUILTIN_OUT_SIZE 65536
+
+typedef struct s_builtin_out
+{
+	size_t	len;
+	int		mode;
+	char	data[BUILTIN_OUT_SIZE];
+}	t_builtin_out;
+
+static t_builtin_out	g_out;
+
+/**
+ * Write all bytes, retrying short and interrupted writes
+ * @param fd Descriptor to write to
+ * @param buf Bytes to write
+ * @param len Number of bytes
+ * @return SUCCESS or ERROR
+ */
+static int	write_all(int fd, const char *buf, size_t len)
+{
+	ssize_t	written;
+
+	while (len > 0)
+	{
+		written = write(fd, buf, len);
+		if (written < 0 && errno == EINTR)
+			continue ;
+		if (written <= 0)
+			return (ERROR);
+		buf += written;
+		len -= written;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Write out the buffered builtin output
+ * The kind of stdout is looked up again afterwards, since it may change
+ * once the buffer is empty
+ * @return SUCCESS or ERROR if the write failed
+ */
+int	builtin_flush(void)
+{
+	int	status;
+
+	status = SUCCESS;
+	if (g_out.len > 0)
+		status = write_all(STDOUT_FILENO, g_out.data, g_out.len);
+	g_out.len = 0;
+	g_out.mode = 0;
+	return (status);
+}
+
+/**
+ * Check whether stdout output is buffered, terminals are not
+ * @return 1 if buffered
+ */
+static int	out_buffered(void)
+{
+	struct stat	st;
+
+	if (g_out.mode == 0)
+	{
+		g_out.mode = -1;
+		if (fstat(STDOUT_FILENO, &st) == 0 && !S_ISCHR(st.st_mode))
+			g_out.mode = 1;
+	}
+	return (g_out.mode > 0);
+}
+
+/**
+ * Write builtin output, counting the bytes for shellstats
+ * Output to stdout is buffered, see builtin_flush
+ * @param fd Descriptor to write to
+ * @param buf Bytes to write
+ * @param len Number of bytes
+ * @return Bytes written or -1 on error
+ */
+ssize_t	builtin_write(int fd, const void *buf, size_t len)
+{
+	ssize_t	written;
+
+	if (fd == STDOUT_FILENO && out_buffered())
+	{
+		if (g_out.len + len > BUILTIN_OUT_SIZE && builtin_flush() != SUCCESS)
+			return (-1);
+		if (len < BUILTIN_OUT_SIZE)
+		{
+			ft_memcpy(g_out.data + g_out.len, buf, len);
+			g_out.len += len;
+			stats_add(STAT_BUILTIN_BYTES, len);
+			return (len);
+		}
+	}
+	written = write(fd, buf, len);
+	if (written > 0)
+		stats_add(STAT_BUILTIN_BYTES, written);
+	return (written);
+}
+
 /**
  * Checks if a variable name is valid (starts with letter/_, contains alnum/_)
  * @param var Variable name to check
@@ -96,7 +204,7 @@ int	parse_variable_assignment(char *arg, char **key, char **value)
 	*value = ft_strdup(equal_sign + 1);
 	if (!*value)
 	{
-		free(*key);
+		ft_free(*key);
 		*key = NULL;
 		return (ERROR);
 	}
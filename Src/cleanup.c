@@ -29,11 +29,14 @@ int	cleanup_command_resources(t_shell *shell)
 		shell->tokens = NULL;
 	}
 	
-	if (shell->commands)
-	{
+	// A cached AST stays owned by the parse cache
+	if (shell->commands && !shell->cached_entry)
 		free_commands(shell->commands);
-		shell->commands = NULL;
-	}
+	shell->commands = NULL;
+	shell->cached_entry = NULL;
+	
+	// Directory listings are only reused within one command line
+	glob_cache_clear(&shell->glob_cache);
 	
 	return (SUCCESS);
 }
@@ -52,7 +55,12 @@ int	cleanup_terminal_state(t_shell *shell)
 		
 	status = SUCCESS;
 	
-	// Clear readline history
+	// Close the history file
+	history_close(shell);
+	
+	// Readline, the terminal and the handlers are only ours after a prompt
+	if (!shell->interactive)
+		return (SUCCESS);
 	clear_history();
 	
 	// Restore terminal settings
@@ -103,13 +111,14 @@ int	cleanup_active_process(t_shell *shell)
 		// Free the filename
 		if (shell->heredoc_file)
 		{
-			free(shell->heredoc_file);
+			ft_free(shell->heredoc_file);
 			shell->heredoc_file = NULL;
 		}
 	}
 	
 	// Reset signal handlers to interactive mode
-	set_signal_mode(shell, 0);
+	if (shell->interactive)
+		set_signal_mode(shell, 0);
 	
 	return (status);
 }
@@ -128,10 +137,43 @@ int	cleanup_shell(t_shell *shell)
 		
 	status = SUCCESS;
 	
+	// Write out what builtins left in the output buffer
+	builtin_flush();
+	
 	// Clean up commands and tokens
 	if (cleanup_command_resources(shell) != SUCCESS)
 		status = ERROR;
 	
+	// Free the parse cache
+	parse_cache_clear(&shell->parse_cache);
+	
+	// Free the resolved command paths
+	path_cache_clear(&shell->path_cache);
+	
+	// Free the compiled [[ =~ patterns
+	regex_cache_clear(&shell->regex_cache);
+	
+	// Close the signalfd used to wait for children
+	if (shell->signal_fd >= 0)
+		close(shell->signal_fd);
+	shell->signal_fd = -1;
+	
+	// Stop the idle zygotes
+	zygote_pool_clear(&shell->zygotes);
+	
+	// Write out pending execution events
+	event_log_close(shell);
+	
+	// Free the cached working directory
+	cwd_free(shell);
+	
+	// Free the prompt template and its rendering
+	prompt_free(&shell->prompt);
+	
+	// Free the function table
+	free_functions(shell->functions);
+	shell->functions = NULL;
+	
 	// Free environment list
 	if (shell->env_list)
 	{
@@ -148,7 +190,7 @@ int	cleanup_shell(t_shell *shell)
 		status = ERROR;
 	
 	// Finally, free the shell structure itself
-	free(shell);
+	ft_free(shell);
 	
 	return (status);
 }
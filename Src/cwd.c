@@ -0,0 +1,286 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   cwd.c                                              :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/10 09:21:44 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/10 09:21:44 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Record the identity of the directory the process is in and keep it open
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+static int	remember_identity(t_shell *shell)
+{
+	struct stat	st;
+
+	if (shell->cwd.fd >= 0)
+		close(shell->cwd.fd);
+	shell->cwd.fd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (stat(".", &st) != 0)
+		return (ERROR);
+	shell->cwd.dev = st.st_dev;
+	shell->cwd.ino = st.st_ino;
+	return (SUCCESS);
+}
+
+/**
+ * Check whether a path names the directory the process is in
+ * @param shell Shell structure
+ * @param path Path to check
+ * @return 1 if it does, 0 otherwise
+ */
+static int	names_cwd(t_shell *shell, char *path)
+{
+	struct stat	st;
+
+	return (path && path[0] == '/' && stat(path, &st) == 0
+		&& st.st_dev == shell->cwd.dev && st.st_ino == shell->cwd.ino);
+}
+
+/**
+ * Get the physical current directory as a tracked allocation
+ * @return Allocated path or NULL on error
+ */
+static char	*current_dir(void)
+{
+	char	*raw;
+	char	*path;
+
+	raw = getcwd(NULL, 0);
+	if (!raw)
+		return (NULL);
+	path = ft_strdup(raw);
+	free(raw);
+	return (path);
+}
+
+/**
+ * Replace the cached paths after the directory changed
+ * @param shell Shell structure
+ * @param logical New logical path (owned by the cache)
+ * @param physical New physical path (owned by the cache) or NULL
+ */
+static void	set_paths(t_shell *shell, char *logical, char *physical)
+{
+	ft_free(shell->cwd.logical);
+	ft_free(shell->cwd.physical);
+	shell->cwd.logical = logical;
+	shell->cwd.physical = physical;
+	shell->cwd.generation++;
+}
+
+/**
+ * Initialize the directory cache from $PWD, falling back to getcwd
+ * $PWD is trusted only when it really names the current directory
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	cwd_init(t_shell *shell)
+{
+	char	*pwd;
+	char	*path;
+
+	shell->cwd.fd = -1;
+	if (remember_identity(shell) != SUCCESS)
+		return (ERROR);
+	pwd = get_env_value(shell->env_list, "PWD");
+	if (names_cwd(shell, pwd))
+		path = ft_strdup(pwd);
+	else
+		path = current_dir();
+	if (!path)
+		return (ERROR);
+	set_paths(shell, path, NULL);
+	set_env_value(shell->env_list, "PWD", path);
+	return (SUCCESS);
+}
+
+/**
+ * Revalidate the cached directory with a single stat
+ * Refreshes both paths with getcwd if the logical path no longer leads
+ * to the directory the shell is in (e.g. it was renamed)
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	cwd_validate(t_shell *shell)
+{
+	char	*path;
+
+	if (names_cwd(shell, shell->cwd.logical))
+		return (SUCCESS);
+	if (remember_identity(shell) != SUCCESS)
+		return (ERROR);
+	path = current_dir();
+	if (!path)
+		return (ERROR);
+	set_paths(shell, path, ft_strdup(path));
+	return (SUCCESS);
+}
+
+/**
+ * Get the cached logical directory without any system call
+ * @param shell Shell structure
+ * @return Logical path or NULL if unknown
+ */
+char	*cwd_logical(t_shell *shell)
+{
+	return (shell->cwd.logical);
+}
+
+/**
+ * Get the physical directory, resolving it on first use
+ * @param shell Shell structure
+ * @return Physical path or NULL on error
+ */
+char	*cwd_physical(t_shell *shell)
+{
+	if (!shell->cwd.physical)
+		shell->cwd.physical = current_dir();
+	return (shell->cwd.physical);
+}
+
+/**
+ * Append the components of a path to a canonical path being built
+ * "." and empty components are skipped, ".." drops the last component
+ * @param out Output buffer holding an absolute path
+ * @param len Current length of out
+ * @param src Path to append
+ * @return New length of out
+ */
+static size_t	append_components(char *out, size_t len, char *src)
+{
+	size_t	start;
+
+	while (*src)
+	{
+		while (*src == '/')
+			src++;
+		start = 0;
+		while (src[start] && src[start] != '/')
+			start++;
+		if (start == 2 && src[0] == '.' && src[1] == '.')
+		{
+			while (len > 1 && out[len - 1] != '/')
+				len--;
+			if (len > 1)
+				len--;
+		}
+		else if (start && !(start == 1 && src[0] == '.'))
+		{
+			if (len > 1)
+				out[len++] = '/';
+			ft_memcpy(out + len, src, start);
+			len += start;
+		}
+		src += start;
+	}
+	out[len] = '\0';
+	return (len);
+}
+
+/**
+ * Resolve a cd target lexically against the logical directory
+ * @param shell Shell structure
+ * @param target Directory operand
+ * @return Newly allocated absolute path or NULL on error
+ */
+static char	*lexical_path(t_shell *shell, char *target)
+{
+	char	*base;
+	char	*out;
+	size_t	len;
+
+	base = "/";
+	if (target[0] != '/' && shell->cwd.logical)
+		base = shell->cwd.logical;
+	out = (char *)ft_malloc(ft_strlen(base) + ft_strlen(target) + 3);
+	if (!out)
+		return (NULL);
+	out[0] = '/';
+	len = 1;
+	if (target[0] != '/')
+		len = append_components(out, len, base);
+	append_components(out, len, target);
+	return (out);
+}
+
+/**
+ * Change directory and update the cache
+ * In logical mode ".." removes the previous component of $PWD instead of
+ * following the physical parent; when the lexical path cannot be entered
+ * the operand is tried as given and the cache falls back to getcwd
+ * @param shell Shell structure
+ * @param target Directory operand
+ * @param physical 1 for cd -P, 0 for cd -L
+ * @return SUCCESS or ERROR (errno describes the failure)
+ */
+int	cwd_change(t_shell *shell, char *target, int physical)
+{
+	char	*path;
+	int		err;
+
+	path = NULL;
+	if (!physical)
+	{
+		path = lexical_path(shell, target);
+		if (!path)
+			return (ERROR);
+		if (chdir(path) != 0)
+		{
+			err = errno;
+			ft_free(path);
+			path = NULL;
+			errno = err;
+		}
+	}
+	if (!path && chdir(target) != 0)
+		return (ERROR);
+	remember_identity(shell);
+	if (path)
+		set_paths(shell, path, NULL);
+	else
+	{
+		path = current_dir();
+		if (!path)
+			return (ERROR);
+		set_paths(shell, path, ft_strdup(path));
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Move the process back into the shell's directory
+ * The working directory is per process, so every shell sharing one goes
+ * back to its own before it runs anything
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	cwd_enter(t_shell *shell)
+{
+	if (shell->cwd.fd >= 0 && fchdir(shell->cwd.fd) != 0)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Free the cached directory paths and close the directory
+ * @param shell Shell structure
+ */
+void	cwd_free(t_shell *shell)
+{
+	if (shell->cwd.fd >= 0)
+		close(shell->cwd.fd);
+	shell->cwd.fd = -1;
+	ft_free(shell->cwd.logical);
+	ft_free(shell->cwd.physical);
+	shell->cwd.logical = NULL;
+	shell->cwd.physical = NULL;
+}
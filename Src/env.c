@@ -18,17 +18,17 @@
  * @param value Environment variable value
  * @return Newly created environment node
  */
-static t_env	*create_env_node(char *key, char *value)
+static t_env	*new_env_node(char *key, char *value)
 {
 	t_env	*new_node;
 
-	new_node = (t_env *)malloc(sizeof(t_env));
+	new_node = (t_env *)ft_malloc(sizeof(t_env));
 	if (!new_node)
 		return (NULL);
 	new_node->key = ft_strdup(key);
 	if (!new_node->key)
 	{
-		free(new_node);
+		ft_free(new_node);
 		return (NULL);
 	}
 	if (value)
@@ -36,8 +36,8 @@ static t_env	*create_env_node(char *key, char *value)
 		new_node->value = ft_strdup(value);
 		if (!new_node->value)
 		{
-			free(new_node->key);
-			free(new_node);
+			ft_free(new_node->key);
+			ft_free(new_node);
 			return (NULL);
 		}
 	}
@@ -47,6 +47,23 @@ static t_env	*create_env_node(char *key, char *value)
 	return (new_node);
 }
 
+/**
+ * Create a new environment node charged to the environment
+ * @param key Environment variable name
+ * @param value Environment variable value
+ * @return Newly created environment node
+ */
+static t_env	*create_env_node(char *key, char *value)
+{
+	t_mem_tag	previous;
+	t_env		*new_node;
+
+	previous = mem_scope(MEM_ENV);
+	new_node = new_env_node(key, value);
+	mem_scope(previous);
+	return (new_node);
+}
+
 /**
  * Parse a single environment variable string into key and value
  * @param env_str Environment variable string in format KEY=VALUE
@@ -78,7 +95,7 @@ static int	parse_env_var(char *env_str, char **key, char **value)
 	*value = ft_strdup(equal_sign + 1);
 	if (!(*value))
 	{
-		free(*key);
+		ft_free(*key);
 		return (ERROR);
 	}
 	
@@ -99,10 +116,10 @@ void	free_env(t_env *env_list)
 	{
 		next = current->next;
 		if (current->key)
-			free(current->key);
+			ft_free(current->key);
 		if (current->value)
-			free(current->value);
-		free(current);
+			ft_free(current->value);
+		ft_free(current);
 		current = next;
 	}
 }
@@ -125,6 +142,7 @@ t_env	*init_env(char **envp)
 		return (NULL);
 	
 	env_list = NULL;
+	current = NULL;
 	i = 0;
 	while (envp[i])
 	{
@@ -135,8 +153,8 @@ t_env	*init_env(char **envp)
 		}
 		
 		new_node = create_env_node(key, value);
-		free(key);
-		free(value);
+		ft_free(key);
+		ft_free(value);
 		
 		if (!new_node)
 		{
@@ -144,21 +162,65 @@ t_env	*init_env(char **envp)
 			return (NULL);
 		}
 		
+		// Append through the tail to keep the environment order
 		if (!env_list)
 			env_list = new_node;
 		else
-		{
-			current = env_list;
-			while (current->next)
-				current = current->next;
 			current->next = new_node;
-		}
+		current = new_node;
 		i++;
 	}
 	
 	return (env_list);
 }
 
+/**
+ * Copy an environment list, keeping its order
+ * @param env_list Environment to copy
+ * @return New list, or NULL on error or for an empty list
+ */
+t_env	*env_dup(t_env *env_list)
+{
+	t_env	*copy;
+	t_env	*tail;
+	t_env	*node;
+
+	copy = NULL;
+	tail = NULL;
+	while (env_list)
+	{
+		node = create_env_node(env_list->key, env_list->value);
+		if (!node)
+		{
+			free_env(copy);
+			return (NULL);
+		}
+		if (tail)
+			tail->next = node;
+		else
+			copy = node;
+		tail = node;
+		env_list = env_list->next;
+	}
+	return (copy);
+}
+
+/**
+ * Get the environment generation, optionally bumping it
+ * Every change to a variable bumps the generation so that values derived
+ * from the environment (such as the rendered prompt) know to refresh
+ * @param bump 1 to record a change, 0 to only read
+ * @return Current generation
+ */
+unsigned long	env_generation(int bump)
+{
+	static unsigned long	generation;
+
+	if (bump)
+		generation++;
+	return (generation);
+}
+
 /**
  * Get the value of an environment variable
  * @param env_list Linked list of environment variables
@@ -172,6 +234,7 @@ char	*get_env_value(t_env *env_list, char *key)
 	if (!env_list || !key)
 		return (NULL);
 	
+	stats_add(STAT_ENV_LOOKUPS, 1);
 	current = env_list;
 	while (current)
 	{
@@ -192,24 +255,29 @@ char	*get_env_value(t_env *env_list, char *key)
  */
 int	set_env_value(t_env *env_list, char *key, char *value)
 {
-	t_env	*current;
-	t_env	*new_node;
-	t_env	*last;
+	t_env		*current;
+	t_env		*new_node;
+	t_env		*last;
+	t_mem_tag	previous;
 
 	if (!env_list || !key)
 		return (ERROR);
 	
+	env_generation(1);
 	current = env_list;
 	while (current)
 	{
 		if (ft_strcmp(current->key, key) == 0)
 		{
 			if (current->value)
-				free(current->value);
+				ft_free(current->value);
+			current->value = NULL;
 			if (value)
+			{
+				previous = mem_scope(MEM_ENV);
 				current->value = ft_strdup(value);
-			else
-				current->value = NULL;
+				mem_scope(previous);
+			}
 			return (SUCCESS);
 		}
 		if (!current->next)
@@ -252,11 +320,12 @@ int	unset_env_value(t_env **env_list, char *key)
 			else
 				*env_list = current->next;
 			
+			env_generation(1);
 			to_remove = current;
-			free(to_remove->key);
+			ft_free(to_remove->key);
 			if (to_remove->value)
-				free(to_remove->value);
-			free(to_remove);
+				ft_free(to_remove->value);
+			ft_free(to_remove);
 			
 			return (SUCCESS);
 		}
@@ -302,7 +371,7 @@ char	**env_to_array(t_env *env_list)
 	int		i;
 
 	count = count_env_vars(env_list);
-	env_array = (char **)malloc(sizeof(char *) * (count + 1));
+	env_array = (char **)ft_malloc(sizeof(char *) * (count + 1));
 	if (!env_array)
 		return (NULL);
 	
@@ -316,13 +385,13 @@ char	**env_to_array(t_env *env_list)
 			if (!tmp)
 			{
 				while (--i >= 0)
-					free(env_array[i]);
-				free(env_array);
+					ft_free(env_array[i]);
+				ft_free(env_array);
 				return (NULL);
 			}
 			
 			env_array[i] = ft_strjoin(tmp, current->value);
-			free(tmp);
+			ft_free(tmp);
 		}
 		else
 			env_array[i] = ft_strdup(current->key);
@@ -330,8 +399,8 @@ char	**env_to_array(t_env *env_list)
 		if (!env_array[i])
 		{
 			while (--i >= 0)
-				free(env_array[i]);
-			free(env_array);
+				ft_free(env_array[i]);
+			ft_free(env_array);
 			return (NULL);
 		}
 		
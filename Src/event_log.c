@@ -0,0 +1,383 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   event_log.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * Opt-in execution log enabled by setting MINISHELL_EVENT_LOG to a file
+ * path. Every pipeline becomes one JSON line:
+ *
+ *   {"shell":PID,"start":US,"stages":[STAGE,...],"end":US,"status":N}
+ *
+ * where each stage records its expanded argv, resolved path, redirections,
+ * pid, timestamps, status and, for forked stages, the child's rusage.
+ * Timestamps are wall clock microseconds. Lines are buffered and written
+ * with one O_APPEND write, so records of concurrent shells never mix.
+ */
+
+typedef struct s_event_src
+{
+	const char	*s;
+	size_t		n;
+}	t_event_src;
+
+/**
+ * Current wall clock time in microseconds
+ * @return Microseconds since the epoch
+ */
+static long	now_usec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (ts.tv_sec * 1000000L + ts.tv_nsec / 1000L);
+}
+
+/**
+ * Append bytes to a growable buffer
+ * @param buf Buffer, may be moved
+ * @param len Used length
+ * @param cap Capacity
+ * @param src Bytes to append
+ * @return SUCCESS or ERROR
+ */
+static int	buf_append(char **buf, size_t *len, size_t *cap, t_event_src src)
+{
+	char	*grown;
+	size_t	new_cap;
+
+	if (*len + src.n > *cap)
+	{
+		new_cap = *cap * 2 + src.n + 256;
+		grown = ft_malloc(new_cap);
+		if (!grown)
+			return (ERROR);
+		ft_memcpy(grown, *buf, *len);
+		ft_free(*buf);
+		*buf = grown;
+		*cap = new_cap;
+	}
+	ft_memcpy(*buf + *len, src.s, src.n);
+	*len += src.n;
+	return (SUCCESS);
+}
+
+/**
+ * Append raw bytes to a pipeline record, dropping the record on failure
+ * @param pipe Pipeline record
+ * @param s Bytes to append
+ * @param n Number of bytes
+ */
+static void	put_raw(t_event_pipe *pipe, const char *s, size_t n)
+{
+	t_event_src	src;
+
+	if (!pipe->enabled)
+		return ;
+	src.s = s;
+	src.n = n;
+	if (buf_append(&pipe->buf, &pipe->len, &pipe->cap, src) != SUCCESS)
+		pipe->enabled = 0;
+}
+
+/**
+ * Append a "key": prefix followed by a number
+ * @param pipe Pipeline record
+ * @param key Key with its quotes, colon and leading comma if needed
+ * @param value Number to append
+ */
+static void	put_num(t_event_pipe *pipe, const char *key, long value)
+{
+	char	num[24];
+	int		n;
+
+	put_raw(pipe, key, ft_strlen(key));
+	n = snprintf(num, sizeof(num), "%ld", value);
+	put_raw(pipe, num, n);
+}
+
+/**
+ * Append a JSON string, or null
+ * @param pipe Pipeline record
+ * @param s String to escape, may be NULL
+ */
+static void	put_str(t_event_pipe *pipe, const char *s)
+{
+	char	esc[8];
+	size_t	run;
+
+	if (!s)
+	{
+		put_raw(pipe, "null", 4);
+		return ;
+	}
+	put_raw(pipe, "\"", 1);
+	while (*s)
+	{
+		run = 0;
+		while (s[run] && s[run] != '"' && s[run] != '\\'
+			&& (unsigned char)s[run] >= 0x20)
+			run++;
+		put_raw(pipe, s, run);
+		s += run;
+		if (!*s)
+			break ;
+		if (*s == '"' || *s == '\\')
+			snprintf(esc, sizeof(esc), "\\%c", *s);
+		else
+			snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*s);
+		put_raw(pipe, esc, ft_strlen(esc));
+		s++;
+	}
+	put_raw(pipe, "\"", 1);
+}
+
+/**
+ * Follow MINISHELL_EVENT_LOG, reopening the log when it changes
+ * The variable is only looked up again after the environment changed
+ * @param shell Shell structure
+ * @return 1 if logging is enabled
+ */
+static int	event_log_sync(t_shell *shell)
+{
+	t_event_log	*log;
+	char		*path;
+
+	log = &shell->events;
+	if (log->synced && log->generation == env_generation(0))
+		return (log->fd >= 0);
+	log->synced = 1;
+	log->generation = env_generation(0);
+	path = get_env_value(shell->env_list, "MINISHELL_EVENT_LOG");
+	if (path && !*path)
+		path = NULL;
+	if ((!path && !log->path) || (path && log->path
+			&& ft_strcmp(path, log->path) == 0))
+		return (log->fd >= 0);
+	event_log_close(shell);
+	if (!path)
+		return (0);
+	log->path = ft_strdup(path);
+	log->fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (log->fd < 0)
+		print_error("event log", path, strerror(errno));
+	log->shell_pid = getpid();
+	return (log->fd >= 0);
+}
+
+/**
+ * Start the record of a pipeline
+ * @param shell Shell structure
+ * @param pipe Pipeline record, owned by the caller
+ */
+void	event_pipe_begin(t_shell *shell, t_event_pipe *pipe)
+{
+	ft_memset(pipe, 0, sizeof(t_event_pipe));
+	if (!event_log_sync(shell))
+		return ;
+	pipe->enabled = 1;
+	pipe->open = 1;
+	put_num(pipe, "{\"shell\":", shell->events.shell_pid);
+	put_num(pipe, ",\"start\":", now_usec());
+	put_raw(pipe, ",\"stages\":[", 11);
+}
+
+/**
+ * Start a stage, the launch reports the pid and path of a forked child
+ * through shell->events.stage until event_stage_launched
+ * @param shell Shell structure
+ * @param pipe Pipeline record
+ * @param st Stage record, owned by the caller until event_stage_end
+ */
+void	event_stage_begin(t_shell *shell, t_event_pipe *pipe, t_event_stage *st)
+{
+	if (!pipe->open)
+		return ;
+	ft_memset(st, 0, sizeof(t_event_stage));
+	pipe->saved = shell->events.stage;
+	shell->events.stage = st;
+	st->start = now_usec();
+	st->end = st->start;
+}
+
+/**
+ * Mark the launch of a stage as done
+ * A stage run by the shell itself ends here, a forked one when reaped
+ * @param shell Shell structure
+ * @param pipe Pipeline record
+ */
+void	event_stage_launched(t_shell *shell, t_event_pipe *pipe)
+{
+	if (!pipe->open)
+		return ;
+	shell->events.stage->end = now_usec();
+	shell->events.stage = pipe->saved;
+}
+
+/**
+ * Record the end and resource usage of a reaped child
+ * @param st Stage record
+ * @param usage Resource usage from wait4
+ */
+void	event_stage_reaped(t_event_stage *st, struct rusage *usage)
+{
+	st->end = now_usec();
+	st->usage = *usage;
+	st->has_usage = 1;
+}
+
+/**
+ * Append the redirections of a stage
+ * @param pipe Pipeline record
+ * @param redir Redirection list
+ */
+static void	put_redirs(t_event_pipe *pipe, t_redirection *redir)
+{
+	const char	*op;
+
+	put_raw(pipe, ",\"redirs\":[", 11);
+	while (redir)
+	{
+		op = ">";
+		if (redir->type == TOKEN_REDIRECT_IN)
+			op = "<";
+		else if (redir->type == TOKEN_HEREDOC)
+			op = "<<";
+		else if (redir->type == TOKEN_REDIRECT_APPEND)
+			op = ">>";
+		put_raw(pipe, "{\"op\":", 6);
+		put_str(pipe, op);
+		put_raw(pipe, ",\"file\":", 8);
+		put_str(pipe, redir->file);
+		put_raw(pipe, "}", 1);
+		redir = redir->next;
+		if (redir)
+			put_raw(pipe, ",", 1);
+	}
+	put_raw(pipe, "]", 1);
+}
+
+/**
+ * Finish a stage and append it to the pipeline record
+ * @param pipe Pipeline record
+ * @param cmd Command that ran
+ * @param st Stage record, its path is released
+ * @param status Exit status of the stage
+ */
+void	event_stage_end(t_event_pipe *pipe, t_command *cmd, t_event_stage *st,
+	int status)
+{
+	int	i;
+
+	if (!pipe->open)
+		return ;
+	if (pipe->stages++)
+		put_raw(pipe, ",", 1);
+	put_raw(pipe, "{\"argv\":[", 9);
+	i = 0;
+	while (cmd->type == CMD_SIMPLE && cmd->args && cmd->args[i])
+	{
+		if (i)
+			put_raw(pipe, ",", 1);
+		put_str(pipe, cmd->args[i++]);
+	}
+	put_raw(pipe, "],\"path\":", 9);
+	put_str(pipe, st->path);
+	put_redirs(pipe, cmd->redirections);
+	put_num(pipe, ",\"pid\":", st->pid);
+	put_num(pipe, ",\"start\":", st->start);
+	put_num(pipe, ",\"end\":", st->end);
+	put_num(pipe, ",\"status\":", status);
+	if (st->has_usage)
+	{
+		put_num(pipe, ",\"utime_us\":", st->usage.ru_utime.tv_sec * 1000000L
+			+ st->usage.ru_utime.tv_usec);
+		put_num(pipe, ",\"stime_us\":", st->usage.ru_stime.tv_sec * 1000000L
+			+ st->usage.ru_stime.tv_usec);
+		put_num(pipe, ",\"maxrss_kb\":", st->usage.ru_maxrss);
+	}
+	put_raw(pipe, "}", 1);
+	ft_free(st->path);
+	st->path = NULL;
+}
+
+/**
+ * Finish a pipeline record and queue it for writing
+ * @param shell Shell structure
+ * @param pipe Pipeline record
+ * @param status Exit status of the pipeline
+ */
+void	event_pipe_end(t_shell *shell, t_event_pipe *pipe, int status)
+{
+	t_event_log	*log;
+	t_event_src	src;
+
+	if (!pipe->open)
+		return ;
+	pipe->open = 0;
+	put_num(pipe, "],\"end\":", now_usec());
+	put_num(pipe, ",\"status\":", status);
+	put_raw(pipe, "}\n", 2);
+	log = &shell->events;
+	src.s = pipe->buf;
+	src.n = pipe->len;
+	if (pipe->enabled && log->fd >= 0
+		&& buf_append(&log->buf, &log->len, &log->cap, src) == SUCCESS
+		&& log->len >= EVENT_LOG_FLUSH)
+		event_log_flush(shell);
+	ft_free(pipe->buf);
+	pipe->buf = NULL;
+}
+
+/**
+ * Write out every queued record
+ * @param shell Shell structure
+ */
+void	event_log_flush(t_shell *shell)
+{
+	t_event_log	*log;
+	ssize_t		n;
+	size_t		off;
+
+	log = &shell->events;
+	off = 0;
+	while (log->fd >= 0 && off < log->len)
+	{
+		n = write(log->fd, log->buf + off, log->len - off);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			break ;
+		off += n;
+	}
+	log->len = 0;
+}
+
+/**
+ * Flush and close the event log
+ * @param shell Shell structure
+ */
+void	event_log_close(t_shell *shell)
+{
+	t_event_log	*log;
+
+	log = &shell->events;
+	event_log_flush(shell);
+	if (log->fd >= 0)
+		close(log->fd);
+	log->fd = -1;
+	ft_free(log->path);
+	log->path = NULL;
+	ft_free(log->buf);
+	log->buf = NULL;
+	log->cap = 0;
+}
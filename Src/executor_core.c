@@ -12,9 +12,6 @@
 
 #include "../Inc/minishell.h"
 
-/* External global signal variable */
-extern volatile int	g_received_signal;
-
 /* Check if a command is a built-in shell command */
 int	is_builtin(char *cmd)
 {
@@ -23,7 +20,30 @@ int	is_builtin(char *cmd)
 	return (ft_strcmp(cmd, "echo") == 0 || ft_strcmp(cmd, "cd") == 0
 		|| ft_strcmp(cmd, "pwd") == 0 || ft_strcmp(cmd, "export") == 0
 		|| ft_strcmp(cmd, "unset") == 0 || ft_strcmp(cmd, "env") == 0
-		|| ft_strcmp(cmd, "exit") == 0);
+		|| ft_strcmp(cmd, "exit") == 0 || ft_strcmp(cmd, "local") == 0
+		|| ft_strcmp(cmd, "return") == 0
+		|| ft_strcmp(cmd, "parsecache") == 0
+		|| ft_strcmp(cmd, "history") == 0
+		|| ft_strcmp(cmd, "memstats") == 0
+		|| ft_strcmp(cmd, "shellstats") == 0
+		|| ft_strcmp(cmd, "cat") == 0
+		|| ft_strcmp(cmd, "read") == 0
+		|| ft_strcmp(cmd, "test") == 0 || ft_strcmp(cmd, "[") == 0
+		|| ft_strcmp(cmd, "[[") == 0 || ft_strcmp(cmd, "printf") == 0
+		|| ft_strcmp(cmd, "source") == 0 || ft_strcmp(cmd, ".") == 0);
+}
+
+/**
+ * Check whether a command line is run by a builtin
+ * cat is only built in for plain copies, other options need the real one
+ * @param args Expanded arguments
+ * @return 1 for a builtin, 0 for an external command
+ */
+int	runs_as_builtin(char **args)
+{
+	if (!is_builtin(args[0]))
+		return (0);
+	return (ft_strcmp(args[0], "cat") != 0 || cat_is_plain(args));
 }
 
 /* Execute a built-in shell command */
@@ -48,43 +68,166 @@ int	execute_builtin(t_command *cmd, t_shell *shell)
 		return (builtin_env(cmd, shell));
 	else if (ft_strcmp(command, "exit") == 0)
 		return (builtin_exit(cmd, shell));
+	else if (ft_strcmp(command, "local") == 0)
+		return (builtin_local(cmd, shell));
+	else if (ft_strcmp(command, "return") == 0)
+		return (builtin_return(cmd, shell));
+	else if (ft_strcmp(command, "parsecache") == 0)
+		return (builtin_parsecache(cmd, shell));
+	else if (ft_strcmp(command, "history") == 0)
+		return (builtin_history(cmd, shell));
+	else if (ft_strcmp(command, "memstats") == 0)
+		return (builtin_memstats(cmd, shell));
+	else if (ft_strcmp(command, "shellstats") == 0)
+		return (builtin_shellstats(cmd, shell));
+	else if (ft_strcmp(command, "cat") == 0)
+		return (builtin_cat(cmd, shell));
+	else if (ft_strcmp(command, "read") == 0)
+		return (builtin_read(cmd, shell));
+	else if (ft_strcmp(command, "test") == 0 || ft_strcmp(command, "[") == 0
+		|| ft_strcmp(command, "[[") == 0)
+		return (builtin_test(cmd, shell));
+	else if (ft_strcmp(command, "printf") == 0)
+		return (builtin_printf(cmd, shell));
+	else if (ft_strcmp(command, "source") == 0 || ft_strcmp(command, ".") == 0)
+		return (builtin_source(cmd, shell));
 	return (ERROR);
 }
 
-/* Execute a list of commands, handling pipes */
+/**
+ * Count the stages of the pipeline starting at a command
+ * @param cmd First stage
+ * @return Number of stages
+ */
+static int	pipeline_length(t_command *cmd)
+{
+	int	count;
+
+	count = 1;
+	while (cmd->pipe_out && cmd->next)
+	{
+		cmd = cmd->next;
+		count++;
+	}
+	return (count);
+}
+
+/**
+ * Expand and launch every stage of a pipeline without waiting, so that
+ * each stage already has a reader when it fills its pipe
+ * @param stages Stages with their commands set
+ * @param count Number of stages
+ * @param shell Shell structure
+ * @param event Pipeline record
+ * @return Number of stages launched
+ */
+static int	launch_pipeline(t_stage *stages, int count, t_shell *shell,
+	t_event_pipe *event)
+{
+	int	pipefd[2];
+	int	in_fd;
+	int	i;
+
+	in_fd = STDIN_FILENO;
+	i = 0;
+	while (i < count)
+	{
+		pipefd[0] = STDIN_FILENO;
+		pipefd[1] = STDOUT_FILENO;
+		event_stage_begin(shell, event, &stages[i].event);
+		if (i + 1 < count && pipe(pipefd) == -1)
+		{
+			print_error("pipe", NULL, NULL);
+			stages[i].status = ERROR;
+			count = i + 1;
+		}
+		else
+		{
+			// The child closes the read end of its own output pipe,
+			// CLOEXEC only backs that up for whatever it execs
+			stages[i].next_in = -1;
+			if (pipefd[0] != STDIN_FILENO)
+			{
+				stages[i].next_in = pipefd[0];
+				fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+				pipe_apply_size(shell, pipefd[0]);
+			}
+			if (expand_command(stages[i].cmd, shell) != SUCCESS)
+				stages[i].status = ERROR;
+			else
+				launch_stage(&stages[i], shell, in_fd, pipefd[1]);
+		}
+		event_stage_launched(shell, event);
+		if (in_fd != STDIN_FILENO)
+			close(in_fd);
+		if (pipefd[1] != STDOUT_FILENO)
+			close(pipefd[1]);
+		in_fd = pipefd[0];
+		i++;
+	}
+	return (count);
+}
+
+/**
+ * Run one pipeline and wait for all of its stages
+ * @param first First stage
+ * @param shell Shell structure
+ * @return Exit status of the last stage
+ */
+static int	execute_pipeline(t_command *first, t_shell *shell)
+{
+	t_stage			*stages;
+	t_event_pipe	event;
+	int				count;
+	int				launched;
+	int				i;
+
+	count = pipeline_length(first);
+	stages = (t_stage *)ft_malloc(sizeof(t_stage) * count);
+	if (!stages)
+		return (ERROR);
+	ft_memset(stages, 0, sizeof(t_stage) * count);
+	i = 0;
+	while (i < count)
+	{
+		stages[i++].cmd = first;
+		first = first->next;
+	}
+	event_pipe_begin(shell, &event);
+	launched = launch_pipeline(stages, count, shell, &event);
+	wait_pipeline(shell, stages, launched);
+	i = 0;
+	while (i < launched)
+	{
+		event_stage_end(&event, stages[i].cmd, &stages[i].event,
+			stages[i].status);
+		i++;
+	}
+	i = stages[launched - 1].status;
+	event_pipe_end(shell, &event, i);
+	ft_free(stages);
+	return (i);
+}
+
+/* Execute a list of commands, handling pipes and ';' separators
+ * Heredoc files stay with the commands, which may be a function body
+ * that runs again; whoever owns the list removes them */
 int	execute_commands(t_command *commands, t_shell *shell)
 {
 	t_command	*current;
 	int			status;
-	int			pipefd[2];
-	int			prev_pipe_read;
 
 	if (!commands)
 		return (ERROR);
 	current = commands;
-	prev_pipe_read = STDIN_FILENO;
 	status = SUCCESS;
-	while (current)
+	while (current && shell->running && !shell->func_return)
 	{
-		if (current->pipe_out && pipe(pipefd) == -1)
-		{
-			print_error("pipe", NULL, NULL);
-			if (prev_pipe_read != STDIN_FILENO)
-				close(prev_pipe_read);
-			return (ERROR);
-		}
-		status = execute_single_command(current, shell,
-				prev_pipe_read, current->pipe_out ? pipefd[1] : STDOUT_FILENO);
-		if (prev_pipe_read != STDIN_FILENO)
-			close(prev_pipe_read);
-		if (current->pipe_out)
-		{
-			close(pipefd[1]);
-			prev_pipe_read = pipefd[0];
-		}
+		status = execute_pipeline(current, shell);
+		shell->exit_status = status;
+		while (current->pipe_out && current->next)
+			current = current->next;
 		current = current->next;
 	}
-	cleanup_all_heredocs(commands);
 	return (status);
 }
-
@@ -12,28 +12,6 @@
 
 #include "../Inc/minishell.h"
 
-/**
- * Free array of strings and return NULL
- * @param paths Array of strings to free
- * @return NULL always
- */
-static char	*free_paths_and_return_null(char **paths)
-{
-	int	i;
-
-	if (!paths)
-		return (NULL);
-		
-	i = 0;
-	while (paths[i])
-	{
-		free(paths[i]);
-		i++;
-	}
-	free(paths);
-	return (NULL);
-}
-
 /**
  * Check if a path is valid and has reasonable length
  * @param path Path to check
@@ -52,57 +30,49 @@ static int	is_valid_path(char *path)
 }
 
 /**
- * Try to find command in given path
- * @param path Directory path to search in
+ * Try to find command in one directory of $PATH
+ * @param dir Directory path, not NUL-terminated
+ * @param dir_len Length of the directory path
  * @param cmd Command name to look for
+ * @param err Set to EACCES when a match exists but is not executable
  * @return Full path if found and executable, NULL otherwise
  */
-static char	*try_path(char *path, char *cmd)
+static char	*try_path(char *dir, size_t dir_len, char *cmd, int *err)
 {
-	char	*tmp;
-	char	*full_path;
+	char	full_path[4096 + 256 + 2];
+	size_t	cmd_len;
 
 	// Skip empty path segments
-	if (!path || !*path || !cmd || !*cmd)
+	cmd_len = ft_strlen(cmd);
+	if (dir_len == 0 || dir_len + cmd_len + 2 > sizeof(full_path))
 		return (NULL);
 		
-	// Create full path
-	tmp = ft_strjoin(path, "/");
-	if (!tmp)
-		return (NULL);
-		
-	full_path = ft_strjoin(tmp, cmd);
-	free(tmp);
-	if (!full_path)
-		return (NULL);
+	// Build the full path without allocating
+	ft_memcpy(full_path, dir, dir_len);
+	full_path[dir_len] = '/';
+	ft_memcpy(full_path + dir_len + 1, cmd, cmd_len + 1);
 		
 	// Check if file exists and is executable
-	if (access(full_path, F_OK) == 0)
-	{
-		if (access(full_path, X_OK) == 0)
-			return (full_path);
-		
-		// File exists but not executable
-		print_error(full_path, NULL, "Permission denied");
-	}
-	
-	free(full_path);
+	if (access(full_path, X_OK) == 0)
+		return (ft_strdup(full_path));
+	if (errno == EACCES && access(full_path, F_OK) == 0)
+		*err = EACCES;
 	return (NULL);
 }
 
 /**
- * Find the path of an executable command
+ * Find the path of an executable command, without printing anything
  * @param cmd Command to find
- * @param env_list Environment variable list for PATH lookup
- * @return Full path to command or NULL if not found
+ * @param path_env Value of $PATH, may be NULL
+ * @param err Set to ENOENT, EACCES or ENAMETOOLONG when NULL is returned
+ * @return Allocated full path to command or NULL if not found
  */
-char	*find_command_path(char *cmd, t_env *env_list)
+char	*find_command_path(char *cmd, char *path_env, int *err)
 {
-	char	*path_env;
-	char	**paths;
 	char	*full_path;
-	int		i;
+	char	*end;
 
+	*err = ENOENT;
 	// Basic command validation
 	if (!cmd || !*cmd)
 		return (NULL);
@@ -110,57 +80,32 @@ char	*find_command_path(char *cmd, t_env *env_list)
 	// Check path length
 	if (!is_valid_path(cmd))
 	{
-		print_error(cmd, NULL, "Path too long");
+		*err = ENAMETOOLONG;
 		return (NULL);
 	}
 	
 	// Handle absolute or relative paths directly
-	if (cmd[0] == '/' || cmd[0] == '.' || ft_strchr(cmd, '/'))
-	{
-		// Check if the file exists and is executable
-		if (access(cmd, F_OK) != 0)
-		{
-			print_error(cmd, NULL, "No such file or directory");
-			return (NULL);
-		}
-		if (access(cmd, X_OK) != 0)
-		{
-			print_error(cmd, NULL, "Permission denied");
-			return (NULL);
-		}
-		return (ft_strdup(cmd));
-	}
-	
-	// Search in PATH environment variable
-	path_env = get_env_value(env_list, "PATH");
-	if (!path_env || !*path_env)
+	if (ft_strchr(cmd, '/'))
 	{
-		print_error(cmd, NULL, "No such file or directory");
+		if (access(cmd, X_OK) == 0)
+			return (ft_strdup(cmd));
+		if (errno == EACCES)
+			*err = EACCES;
 		return (NULL);
 	}
 	
-	// Split PATH into components
-	paths = ft_split(path_env, ':');
-	if (!paths)
+	// Try each PATH component in place
+	while (path_env && *path_env)
 	{
-		print_error(cmd, NULL, "Memory allocation failed");
-		return (NULL);
-	}
-	
-	// Try each PATH component
-	i = 0;
-	while (paths[i])
-	{
-		full_path = try_path(paths[i], cmd);
+		end = ft_strchr(path_env, ':');
+		if (!end)
+			end = path_env + ft_strlen(path_env);
+		full_path = try_path(path_env, end - path_env, cmd, err);
 		if (full_path)
-		{
-			free_paths_and_return_null(paths);
 			return (full_path);
-		}
-		i++;
+		path_env = *end ? end + 1 : end;
 	}
 	
 	// Command not found in any PATH component
-	return (free_paths_and_return_null(paths));
+	return (NULL);
 }
-
@@ -12,15 +12,19 @@
 
 #include "../Inc/minishell.h"
 
-/* External global signal variable */
-extern volatile sig_atomic_t g_received_signal;
-
 /* Execute builtin directly (without forking) */
 int	execute_builtin_directly(t_command *cmd, t_shell *shell, int out_fd)
 {
 	int	status;
 	int	saved_fds[2];
 
+	// Nothing to redirect: run in place, output stays buffered
+	if (out_fd == STDOUT_FILENO && !cmd->redirections)
+	{
+		stats_add(STAT_BUILTINS, 1);
+		return (execute_builtin(cmd, shell));
+	}
+	builtin_flush();
 	saved_fds[0] = -1;
 	saved_fds[1] = -1;
 	
@@ -48,13 +52,39 @@ int	execute_builtin_directly(t_command *cmd, t_shell *shell, int out_fd)
 		restore_std_fds(saved_fds);
 		return (ERROR);
 	}
+	stats_add(STAT_BUILTINS, 1);
 	status = execute_builtin(cmd, shell);
+	builtin_flush();
 	restore_std_fds(saved_fds);
 	return (status);
 }
 
+/**
+ * Report a command that could not be resolved and leave the child
+ * @param name Command name
+ * @param err Reason from path resolution
+ */
+static void	exit_not_found(char *name, int err)
+{
+	if (err == EACCES)
+	{
+		print_error(name, NULL, "Permission denied");
+		_exit(CMD_NOT_EXEC);
+	}
+	if (err == ENAMETOOLONG)
+		print_error(name, NULL, "Path too long");
+	else if (ft_strchr(name, '/'))
+		print_error(name, NULL, "No such file or directory");
+	else
+		print_error(name, NULL, "command not found");
+	_exit(CMD_NOT_FOUND);
+}
+
 /**
  * Execute child process after fork
+ * The command path was resolved by the parent into shell->exec_path.
+ * The child leaves with _exit so the stdio buffers and atexit handlers
+ * of a process embedding the shell do not run a second time
  * @param cmd Command to execute
  * @param shell Shell structure
  * @param in_fd Input file descriptor
@@ -65,12 +95,16 @@ int	execute_child_process(t_command *cmd, t_shell *shell,
 {
 	char	*cmd_path;
 	char	**env_array;
+	int		status;
 
+	// --serve ignores SIGPIPE, which would otherwise survive execve
+	signal(SIGPIPE, SIG_DFL);
+	
 	// Redirect input if needed
 	if (in_fd != STDIN_FILENO)
 	{
 		if (dup2(in_fd, STDIN_FILENO) == -1)
-			exit(ERROR);
+			_exit(ERROR);
 		close(in_fd);
 	}
 	
@@ -78,24 +112,29 @@ int	execute_child_process(t_command *cmd, t_shell *shell,
 	if (out_fd != STDOUT_FILENO)
 	{
 		if (dup2(out_fd, STDOUT_FILENO) == -1)
-			exit(ERROR);
+			_exit(ERROR);
 		close(out_fd);
 	}
 	if (setup_redirections(cmd->redirections) != SUCCESS)
-		exit(ERROR);
-	if (is_builtin(cmd->args[0]))
-		exit(execute_builtin(cmd, shell));
-	cmd_path = find_command_path(cmd->args[0], shell->env_list);
-	if (!cmd_path)
+		_exit(ERROR);
+	if (find_function(shell, cmd->args[0]) || runs_as_builtin(cmd->args))
 	{
-		print_error(cmd->args[0], NULL, "command not found");
-		exit(CMD_NOT_FOUND);
+		if (find_function(shell, cmd->args[0]))
+			status = call_function(find_function(shell, cmd->args[0]), cmd,
+					shell);
+		else
+			status = execute_builtin(cmd, shell);
+		builtin_flush();
+		_exit(status);
 	}
+	cmd_path = shell->exec_path;
+	if (!cmd_path)
+		exit_not_found(cmd->args[0], shell->exec_err);
 	env_array = env_to_array(shell->env_list);
 	if (!env_array)
 	{
-		free(cmd_path);
-		exit(ERROR);
+		ft_free(cmd_path);
+		_exit(ERROR);
 	}
 	
 	// Execute the command
@@ -105,7 +144,7 @@ int	execute_child_process(t_command *cmd, t_shell *shell,
 	print_error(cmd_path, NULL, NULL);
 	
 	// Clean up all resources before exit
-	free(cmd_path);
+	ft_free(cmd_path);
 	free_string_array(env_array);
 	
 	// Close any redirected file descriptors
@@ -114,65 +153,123 @@ int	execute_child_process(t_command *cmd, t_shell *shell,
 	if (out_fd != STDOUT_FILENO)
 		close(STDOUT_FILENO);
 		
-	exit(ERROR);
+	_exit(ERROR);
 }
 
-/* Execute a single command */
-int	execute_single_command(t_command *cmd, t_shell *shell,
-	int in_fd, int out_fd)
+/**
+ * Launch one pipeline stage without waiting for it
+ * Builtins and functions that are neither piped nor redirected run in
+ * the shell and complete here; everything else is forked, or handed to
+ * a zygote, and left in stage->pid for wait_pipeline
+ * @param stage Stage to launch, pid and status are set
+ * @param shell Shell structure
+ * @param in_fd Input file descriptor
+ * @param out_fd Output file descriptor
+ * @return SUCCESS, or ERROR if no process could be started
+ */
+int	launch_stage(t_stage *stage, t_shell *shell, int in_fd, int out_fd)
 {
-	int		status;
-	pid_t	pid;
+	t_command	*cmd;
+	pid_t		pid;
+	t_func		*func;
 
-	if (!cmd || !cmd->args || !cmd->args[0])
+	cmd = stage->cmd;
+	stage->status = ERROR;
+	
+	// Definitions inside a pipeline would only live in the subshell
+	if (cmd->type == CMD_FUNCDEF)
+	{
+		stage->status = SUCCESS;
+		if (!cmd->pipe_out && in_fd == STDIN_FILENO)
+			stage->status = define_function(shell, cmd->func_name, cmd->body);
+		return (SUCCESS);
+	}
+	if (!cmd->args || !cmd->args[0])
 		return (ERROR);
+	stats_add(STAT_COMMANDS, 1);
+	
+	// Functions run in the current process unless redirected or piped
+	func = find_function(shell, cmd->args[0]);
+	
+	// timeout forks its command into a process group of its own
+	if (!func && ft_strcmp(cmd->args[0], "timeout") == 0)
+	{
+		if (timeout_prepare(stage, cmd) != SUCCESS)
+		{
+			stage->status = TIMEOUT_FAILED;
+			return (SUCCESS);
+		}
+		func = find_function(shell, cmd->args[0]);
+	}
+	if (func && !cmd->redirections && !cmd->pipe_out && in_fd == STDIN_FILENO
+		&& !stage->timeout.active)
+	{
+		stage->status = call_function(func, cmd, shell);
+		return (SUCCESS);
+	}
 		
 	// Handle builtins directly if possible
-	if (is_builtin(cmd->args[0]) && !cmd->pipe_out && in_fd == STDIN_FILENO)
-		return (execute_builtin_directly(cmd, shell, out_fd));
+	if (!func && runs_as_builtin(cmd->args) && !cmd->pipe_out
+		&& in_fd == STDIN_FILENO && !stage->timeout.active)
+	{
+		stage->status = execute_builtin_directly(cmd, shell, out_fd);
+		return (SUCCESS);
+	}
+	
+	// Resolve external commands in the parent so the PATH cache persists
+	if (!func && !runs_as_builtin(cmd->args))
+	{
+		shell->exec_path = path_cache_resolve(shell, cmd->args[0],
+				&shell->exec_err);
+		stats_add(STAT_EXECS, 1);
+	}
 	
 	// Set up signal handlers for execution
 	setup_exec_signals();
 	
-	// Create child process
-	pid = fork();
+	// The child must not inherit, or overtake, buffered builtin output
+	builtin_flush();
+	
+	// Hand the command to a pre-forked zygote, or create a child process
+	pid = -1;
+	if (!stage->timeout.active)
+		pid = zygote_launch(shell, cmd, in_fd, out_fd);
+	if (pid == -1)
+	{
+		pid = fork();
+		if (pid > 0)
+			stats_add(STAT_FORKS, 1);
+	}
 	if (pid == -1)
 	{
 		print_error("fork", NULL, NULL);
+		ft_free(shell->exec_path);
+		shell->exec_path = NULL;
 		return (ERROR);
 	}
 	
-	// Child process
+	// Both sides set the group so neither can signal it too early
+	if (stage->timeout.active)
+		setpgid(pid, 0);
+	
+	// Child process, a builtin or function writing to a pipe whose read
+	// end it still held would never see its reader go away
 	if (pid == 0)
+	{
+		if (stage->next_in >= 0)
+			close(stage->next_in);
 		execute_child_process(cmd, shell, in_fd, out_fd);
-	// Parent process
-	else
+	}
+	stage->pid = pid;
+	
+	// The event log keeps the resolved path of the stage
+	if (shell->events.stage)
 	{
-		int wait_result;
-		
-		// Reset signal flag
-		g_received_signal = 0;
-		
-		// Wait for child process with error handling for interruption
-		wait_result = waitpid(pid, &status, 0);
-		while (wait_result == -1 && errno == EINTR)
-		{
-			// If interrupted by signal, try again
-			wait_result = waitpid(pid, &status, 0);
-		}
-		
-		// Restore interactive mode signals
-		setup_signals();
-		
-		// Check if waitpid failed for a reason other than interruption
-		if (wait_result == -1)
-		{
-			print_error("waitpid", NULL, NULL);
-			return (ERROR);
-		}
-		
-		return (get_exit_status(status));
+		shell->events.stage->pid = pid;
+		shell->events.stage->path = shell->exec_path;
 	}
-	return (ERROR);
+	else
+		ft_free(shell->exec_path);
+	shell->exec_path = NULL;
+	return (SUCCESS);
 }
-
@@ -66,7 +66,7 @@ static int	check_directory_permission(char *file_path)
 		// Empty string means root directory
 		if (dir_path[0] == '\0')
 		{
-			free(dir_path);
+			ft_free(dir_path);
 			dir_path = ft_strdup("/");
 			if (!dir_path)
 				return (ERROR);
@@ -77,12 +77,12 @@ static int	check_directory_permission(char *file_path)
 		if (result == -1)
 		{
 			print_error(NULL, file_path, "Permission denied");
-			free(dir_path);
+			ft_free(dir_path);
 			return (ERROR);
 		}
 	}
 	
-	free(dir_path);
+	ft_free(dir_path);
 	return (SUCCESS);
 }
 
@@ -166,10 +166,6 @@ int	setup_redirections(t_redirection *redirections)
 			}
 			
 			close(fd);
-			
-			// Clean up heredoc file if needed
-			if (is_heredoc_file(current->file))
-				cleanup_heredoc(current->file);
 		}
 		else if (current->type == TOKEN_REDIRECT_OUT)
 		{
@@ -270,7 +266,8 @@ int	cleanup_heredoc_files(t_command *cmd)
 }
 
 /**
- * Cleanup all heredoc files in a command list
+ * Cleanup all heredoc files in a command list, including the bodies of
+ * the functions it defines
  * @param commands List of commands
  * @return SUCCESS or ERROR
  */
@@ -287,7 +284,8 @@ int	cleanup_all_heredocs(t_command *commands)
 	
 	while (current)
 	{
-		if (cleanup_heredoc_files(current) != SUCCESS)
+		if (cleanup_heredoc_files(current) != SUCCESS
+			|| cleanup_all_heredocs(current->body) != SUCCESS)
 			status = ERROR;
 		current = current->next;
 	}
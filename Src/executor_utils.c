@@ -11,6 +11,11 @@
 /* ************************************************************************** */
 
 #include "../Inc/minishell.h"
+#include <limits.h>
+
+#ifndef F_SETPIPE_SZ
+# define F_SETPIPE_SZ 1031
+#endif
 
 /**
  * Get proper exit status based on wait() status
@@ -33,6 +38,97 @@ int	get_exit_status(int status)
 	return (ERROR);
 }
 
+/**
+ * Current time of the monotonic clock
+ * @return Microseconds
+ */
+long	monotonic_usec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000L + ts.tv_nsec / 1000L);
+}
+
+/**
+ * Read the largest pipe size an unprivileged process may request
+ * @return Size in bytes, or 1MiB if unknown
+ */
+static int	pipe_max_size(void)
+{
+	char	buf[32];
+	ssize_t	n;
+	int		fd;
+
+	fd = open("/proc/sys/fs/pipe-max-size", O_RDONLY | O_CLOEXEC);
+	n = -1;
+	if (fd >= 0)
+	{
+		n = read(fd, buf, sizeof(buf) - 1);
+		close(fd);
+	}
+	if (n <= 0)
+		return (1 << 20);
+	buf[n] = '\0';
+	return (ft_atoi(buf));
+}
+
+/**
+ * Parse a size with an optional K or M suffix
+ * @param text Size such as 65536, 256K or 1M
+ * @return Size in bytes, 0 if invalid
+ */
+static long	parse_size(char *text)
+{
+	long	size;
+	int		i;
+
+	size = 0;
+	i = 0;
+	while (ft_isdigit(text[i]) && size <= INT_MAX)
+		size = size * 10 + text[i++] - '0';
+	if (text[i] == 'k' || text[i] == 'K')
+		size *= 1024;
+	else if (text[i] == 'm' || text[i] == 'M')
+		size *= 1024 * 1024;
+	else if (text[i])
+		return (0);
+	if (text[i] && text[i + 1])
+		return (0);
+	return (size);
+}
+
+/**
+ * Give a new pipe the buffer size requested by MINISHELL_PIPE_SIZE
+ * The variable is parsed again only after the environment changed and
+ * the size is capped by /proc/sys/fs/pipe-max-size
+ * @param shell Shell structure
+ * @param fd Either end of the pipe
+ */
+void	pipe_apply_size(t_shell *shell, int fd)
+{
+	t_pipe_size	*pipe_size;
+	char		*value;
+	long		bytes;
+
+	pipe_size = &shell->pipe_size;
+	if (!pipe_size->synced || pipe_size->generation != env_generation(0))
+	{
+		pipe_size->synced = 1;
+		pipe_size->generation = env_generation(0);
+		value = get_env_value(shell->env_list, "MINISHELL_PIPE_SIZE");
+		bytes = 0;
+		if (value)
+			bytes = parse_size(value);
+		if (bytes > 0 && bytes > pipe_max_size())
+			bytes = pipe_max_size();
+		pipe_size->bytes = (int)bytes;
+	}
+	// Failing only leaves the default size, e.g. over the per-user limit
+	if (pipe_size->bytes > 0)
+		fcntl(fd, F_SETPIPE_SZ, pipe_size->bytes);
+}
+
 /**
  * Save the current standard input and output file descriptors
  * @param saved_fds Array to store saved file descriptors
@@ -155,13 +251,49 @@ int	free_string_array(char **arr)
 	{
 		if (arr[i])
 		{
-			free(arr[i]);
+			ft_free(arr[i]);
 			arr[i] = NULL;
 		}
 		i++;
 	}
 	
-	free(arr);
+	ft_free(arr);
 	return (SUCCESS);
 }
 
+/**
+ * Duplicate a NULL-terminated array of strings
+ * @param arr Array of strings to copy
+ * @return Newly allocated copy, or NULL on error or if arr is NULL
+ */
+char	**dup_string_array(char **arr)
+{
+	char	**copy;
+	int		count;
+	int		i;
+
+	if (!arr)
+		return (NULL);
+	count = 0;
+	while (arr[count])
+		count++;
+	copy = (char **)ft_malloc(sizeof(char *) * (count + 1));
+	if (!copy)
+		return (NULL);
+	i = 0;
+	while (i < count)
+	{
+		copy[i] = ft_strdup(arr[i]);
+		if (!copy[i])
+		{
+			while (--i >= 0)
+				ft_free(copy[i]);
+			ft_free(copy);
+			return (NULL);
+		}
+		i++;
+	}
+	copy[i] = NULL;
+	return (copy);
+}
+
@@ -0,0 +1,314 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   executor_wait.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+#include <poll.h>
+#include <sys/pidfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+/*
+ * Waiting for a pipeline is one poll loop. Slot 0 is a signalfd for
+ * SIGCHLD, SIGINT and SIGQUIT, which stay blocked while the loop runs;
+ * slot 1 is a timerfd armed for the nearest timeout deadline, and the
+ * other slots are pidfds of the children still running. A child whose
+ * pidfd could not be opened is found by the SIGCHLD wakeup.
+ */
+
+#define WAIT_SLOTS 2
+
+/**
+ * Get the shell's signalfd, creating it on first use
+ * @param shell Shell structure
+ * @param mask Signals to read from it
+ * @return Descriptor or -1
+ */
+static int	signal_fd(t_shell *shell, sigset_t *mask)
+{
+	if (shell->signal_fd < 0)
+		shell->signal_fd = signalfd(-1, mask, SFD_CLOEXEC | SFD_NONBLOCK);
+	return (shell->signal_fd);
+}
+
+/**
+ * Reap a stage if its child has exited
+ * @param stage Stage with a running child
+ * @return 1 if the child was reaped
+ */
+static int	reap_stage(t_stage *stage)
+{
+	struct rusage	usage;
+	pid_t			result;
+	int				status;
+
+	result = wait4(stage->pid, &status, WNOHANG, &usage);
+	if (result == 0 || (result == -1 && errno == EINTR))
+		return (0);
+	stage->pid = 0;
+	if (result == -1)
+	{
+		print_error("waitpid", NULL, NULL);
+		stage->status = ERROR;
+		return (1);
+	}
+	stage->status = get_exit_status(status);
+	if (stage->timeout.expired
+		&& !(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL))
+		stage->status = TIMEOUT_EXPIRED;
+	event_stage_reaped(&stage->event, &usage);
+	return (1);
+}
+
+/**
+ * Pass a signal on to the children that did not get it themselves
+ * Stages under timeout have their own process group, which the terminal
+ * does not signal; the rest share the shell's group and only miss
+ * signals sent to the shell alone
+ * @param info Signal read from the signalfd
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ */
+static void	forward_signal(struct signalfd_siginfo *info, t_stage *stages,
+	int count)
+{
+	int	i;
+
+	i = 0;
+	while (i < count)
+	{
+		if (stages[i].pid > 0 && stages[i].timeout.active)
+			kill(-stages[i].pid, info->ssi_signo);
+		else if (stages[i].pid > 0 && info->ssi_code != SI_KERNEL)
+			kill(stages[i].pid, info->ssi_signo);
+		i++;
+	}
+}
+
+/**
+ * Drain the signalfd, reporting interrupts like the exec handlers do
+ * @param fd Signalfd
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ */
+static void	read_signals(int fd, t_stage *stages, int count)
+{
+	struct signalfd_siginfo	info;
+
+	while (read(fd, &info, sizeof(info)) == sizeof(info))
+	{
+		if (info.ssi_signo == SIGCHLD)
+			continue ;
+		if (info.ssi_signo == SIGINT)
+			handle_sigint_exec(SIGINT);
+		else
+			handle_sigquit_exec(SIGQUIT);
+		forward_signal(&info, stages, count);
+	}
+}
+
+/**
+ * Reap every child that has exited and rebuild the poll set
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ * @param fds Poll set, fds[i + WAIT_SLOTS] belongs to stages[i]
+ * @return Number of children still running
+ */
+static int	reap_ready(t_stage *stages, int count, struct pollfd *fds)
+{
+	int	live;
+	int	i;
+
+	live = 0;
+	i = 0;
+	while (i < count)
+	{
+		if (stages[i].pid > 0 && (fds[i + WAIT_SLOTS].fd < 0 || fds[i + WAIT_SLOTS].revents)
+			&& reap_stage(&stages[i]) && fds[i + WAIT_SLOTS].fd >= 0)
+		{
+			close(fds[i + WAIT_SLOTS].fd);
+			fds[i + WAIT_SLOTS].fd = -1;
+		}
+		if (stages[i].pid > 0)
+			live++;
+		fds[i + WAIT_SLOTS].revents = 0;
+		i++;
+	}
+	return (live);
+}
+
+/**
+ * Open a pidfd for every launched child
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ * @param fds Poll set to fill in
+ */
+static void	watch_children(t_stage *stages, int count, struct pollfd *fds)
+{
+	int	i;
+
+	i = 0;
+	while (i < count)
+	{
+		fds[i + WAIT_SLOTS].fd = -1;
+		if (stages[i].pid > 0)
+			fds[i + WAIT_SLOTS].fd = pidfd_open(stages[i].pid, 0);
+		fds[i + WAIT_SLOTS].events = POLLIN;
+		// Checked once before sleeping, the child may be gone already
+		fds[i + WAIT_SLOTS].revents = POLLIN;
+		i++;
+	}
+}
+
+/**
+ * Signal the process group of a stage whose deadline passed
+ * @param stage Stage under timeout
+ * @param now Current monotonic time
+ */
+static void	expire_stage(t_stage *stage, long now)
+{
+	t_timeout	*timeout;
+
+	timeout = &stage->timeout;
+	kill(-stage->pid, timeout->signal);
+	// A stopped group could not act on the signal
+	if (timeout->signal != SIGKILL && timeout->signal != SIGCONT)
+		kill(-stage->pid, SIGCONT);
+	timeout->expired = 1;
+	timeout->deadline = 0;
+	if (timeout->kill_after > 0)
+	{
+		timeout->deadline = now + timeout->kill_after;
+		timeout->kill_after = 0;
+		timeout->signal = SIGKILL;
+	}
+}
+
+/**
+ * Enforce the deadlines that passed and arm the timer for the next one
+ * @param timer_fd Timerfd, or -1
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ * @return 1 while a deadline is pending
+ */
+static int	enforce_deadlines(int timer_fd, t_stage *stages, int count)
+{
+	struct itimerspec	spec;
+	uint64_t			ticks;
+	long				now;
+	long				next;
+	int					i;
+
+	if (timer_fd >= 0 && read(timer_fd, &ticks, sizeof(ticks)) < 0)
+		ticks = 0;
+	now = monotonic_usec();
+	next = 0;
+	i = 0;
+	while (i < count)
+	{
+		if (stages[i].pid > 0 && stages[i].timeout.deadline
+			&& stages[i].timeout.deadline <= now)
+			expire_stage(&stages[i], now);
+		if (stages[i].pid > 0 && stages[i].timeout.deadline
+			&& (!next || stages[i].timeout.deadline < next))
+			next = stages[i].timeout.deadline;
+		i++;
+	}
+	ft_memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = next / 1000000L;
+	spec.it_value.tv_nsec = next % 1000000L * 1000L;
+	if (timer_fd >= 0)
+		timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+	return (next != 0);
+}
+
+/**
+ * Create the timerfd if a stage has a deadline
+ * @param stages Stages of the pipeline
+ * @param count Number of stages
+ * @return Timerfd, or -1 if none is needed or it cannot be created
+ */
+static int	deadline_timer(t_stage *stages, int count)
+{
+	int	i;
+
+	i = 0;
+	while (i < count && !stages[i].timeout.deadline)
+		i++;
+	if (i == count)
+		return (-1);
+	return (timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK));
+}
+
+/**
+ * Wait for every child of a pipeline
+ * @param shell Shell structure
+ * @param stages Launched stages, statuses of forked ones are filled in
+ * @param count Number of stages
+ * @return SUCCESS or ERROR
+ */
+int	wait_pipeline(t_shell *shell, t_stage *stages, int count)
+{
+	struct pollfd	*fds;
+	sigset_t		mask;
+	sigset_t		saved;
+	long			start;
+	int				timeout;
+	int				i;
+
+	i = 0;
+	while (i < count && stages[i].pid <= 0)
+		i++;
+	if (i == count)
+		return (SUCCESS);
+	fds = (struct pollfd *)ft_malloc(sizeof(struct pollfd)
+			* (count + WAIT_SLOTS));
+	if (!fds)
+		return (ERROR);
+	start = monotonic_usec();
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGQUIT);
+	sigprocmask(SIG_BLOCK, &mask, &saved);
+	fds[0].fd = signal_fd(shell, &mask);
+	fds[0].events = POLLIN;
+	fds[1].fd = deadline_timer(stages, count);
+	fds[1].events = POLLIN;
+	watch_children(stages, count, fds);
+	enforce_deadlines(fds[1].fd, stages, count);
+	while (reap_ready(stages, count, fds) > 0)
+	{
+		// Without a signalfd or timerfd, fall back to checking every 10ms
+		timeout = -1;
+		if (fds[0].fd < 0 || (fds[1].fd < 0
+				&& enforce_deadlines(-1, stages, count)))
+			timeout = 10;
+		if (poll(fds, count + WAIT_SLOTS, timeout) < 0 && errno != EINTR)
+			break ;
+		if (fds[0].revents)
+			read_signals(fds[0].fd, stages, count);
+		enforce_deadlines(fds[1].fd, stages, count);
+	}
+	sigprocmask(SIG_SETMASK, &saved, NULL);
+	stats_add(STAT_WAIT_USEC, monotonic_usec() - start);
+	i = 1;
+	while (i < count + WAIT_SLOTS)
+	{
+		if (fds[i].fd >= 0)
+			close(fds[i].fd);
+		i++;
+	}
+	ft_free(fds);
+	// Restore interactive mode signals
+	setup_signals();
+	return (SUCCESS);
+}
@@ -0,0 +1,487 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   expand.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/08 16:40:12 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/08 16:40:12 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Append raw bytes to the field being built, growing it geometrically
+ * Marks the field active even when n is 0
+ * @param buf Field buffer
+ * @param s Bytes to append
+ * @param n Number of bytes
+ * @return SUCCESS or ERROR
+ */
+static int	buf_write(t_field_buf *buf, const char *s, size_t n)
+{
+	char	*grown;
+	size_t	cap;
+
+	if (buf->len + n + 1 > buf->cap)
+	{
+		cap = buf->cap;
+		if (cap == 0)
+			cap = 32;
+		while (cap < buf->len + n + 1)
+			cap *= 2;
+		grown = (char *)ft_malloc(cap);
+		if (!grown)
+			return (ERROR);
+		if (buf->data)
+			ft_memcpy(grown, buf->data, buf->len);
+		ft_free(buf->data);
+		buf->data = grown;
+		buf->cap = cap;
+	}
+	ft_memcpy(buf->data + buf->len, s, n);
+	buf->len += n;
+	buf->data[buf->len] = '\0';
+	buf->active = 1;
+	return (SUCCESS);
+}
+
+/**
+ * Check if a character is special to pathname expansion
+ * @param c Character to check
+ * @return 1 if special, 0 otherwise
+ */
+static int	is_glob_char(char c)
+{
+	return (c == '*' || c == '?' || c == '[');
+}
+
+/**
+ * Append text to the field being built, keeping track of globbing
+ * Quoted glob characters and all backslashes are escaped so the field
+ * doubles as a pattern; unquoted glob characters set has_glob
+ * @param buf Field buffer
+ * @param s Text to append
+ * @param n Number of bytes
+ * @param quoted Whether the text came from inside quotes
+ * @return SUCCESS or ERROR
+ */
+static int	buf_append(t_field_buf *buf, const char *s, size_t n, int quoted)
+{
+	size_t	i;
+	size_t	start;
+
+	i = 0;
+	start = 0;
+	while (i < n)
+	{
+		if (s[i] == '\\' || (quoted && (is_glob_char(s[i]) || s[i] == ']')))
+		{
+			if (buf_write(buf, s + start, i - start) != SUCCESS
+				|| buf_write(buf, "\\", 1) != SUCCESS)
+				return (ERROR);
+			buf->escaped = 1;
+			start = i;
+		}
+		else if (is_glob_char(s[i]))
+			buf->has_glob = 1;
+		i++;
+	}
+	return (buf_write(buf, s + start, n - start));
+}
+
+/**
+ * Remove the escapes added by buf_append
+ * @param s Field text, modified in place
+ */
+void	unescape_field(char *s)
+{
+	char	*out;
+
+	out = s;
+	while (*s)
+	{
+		if (*s == '\\' && s[1])
+			s++;
+		*out++ = *s++;
+	}
+	*out = '\0';
+}
+
+/**
+ * Append an item to the field list
+ * @param fields Field list
+ * @param item Item to append, owned by the list (freed on error)
+ * @return SUCCESS or ERROR
+ */
+int	fields_push(t_fields *fields, char *item)
+{
+	char	**grown;
+	int		cap;
+
+	if (item && fields->count + 1 >= fields->cap)
+	{
+		cap = fields->cap * 2;
+		if (cap == 0)
+			cap = 8;
+		grown = (char **)ft_malloc(sizeof(char *) * cap);
+		if (grown && fields->items)
+			ft_memcpy(grown, fields->items, sizeof(char *) * fields->count);
+		if (grown)
+		{
+			ft_free(fields->items);
+			fields->items = grown;
+			fields->cap = cap;
+		}
+	}
+	if (!item || fields->count + 1 >= fields->cap)
+	{
+		ft_free(item);
+		return (ERROR);
+	}
+	fields->items[fields->count++] = item;
+	fields->items[fields->count] = NULL;
+	return (SUCCESS);
+}
+
+/**
+ * Move the field being built to the end of the field list
+ * A field with unquoted glob characters is replaced by the matching
+ * paths, or kept (unescaped) when nothing matches
+ * @param fields Field list
+ * @param buf Field buffer, reset afterwards
+ * @return SUCCESS or ERROR
+ */
+static int	push_field(t_fields *fields, t_field_buf *buf)
+{
+	int	matches;
+
+	matches = 0;
+	if (buf->has_glob && fields->glob)
+		matches = glob_expand(fields->glob, buf->data, fields);
+	if (matches < 0)
+		return (ERROR);
+	if (matches > 0)
+		ft_free(buf->data);
+	else
+	{
+		if (!buf->data)
+			buf->data = ft_strdup("");
+		else if (buf->escaped && !fields->patterns)
+			unescape_field(buf->data);
+		if (fields_push(fields, buf->data) != SUCCESS)
+		{
+			ft_memset(buf, 0, sizeof(t_field_buf));
+			return (ERROR);
+		}
+	}
+	ft_memset(buf, 0, sizeof(t_field_buf));
+	return (SUCCESS);
+}
+
+/**
+ * Join the positional parameters of the current frame with spaces
+ * @param shell Shell structure
+ * @return Newly allocated string or NULL on error
+ */
+static char	*join_positional(t_shell *shell)
+{
+	t_field_buf	buf;
+	int			i;
+
+	ft_memset(&buf, 0, sizeof(t_field_buf));
+	i = 1;
+	while (shell->frames && i < shell->frames->argc)
+	{
+		if ((i > 1 && buf_write(&buf, " ", 1) != SUCCESS)
+			|| buf_write(&buf, shell->frames->argv[i],
+				ft_strlen(shell->frames->argv[i])) != SUCCESS)
+		{
+			ft_free(buf.data);
+			return (NULL);
+		}
+		i++;
+	}
+	if (!buf.data)
+		return (ft_strdup(""));
+	return (buf.data);
+}
+
+/**
+ * Get the value of a parameter ($?, $#, $@, $*, positional or variable)
+ * @param shell Shell structure
+ * @param name Parameter name
+ * @return Newly allocated value or NULL on error
+ */
+static char	*param_value(t_shell *shell, char *name)
+{
+	char	*value;
+
+	if (ft_strcmp(name, "?") == 0)
+		return (ft_itoa(shell->exit_status));
+	if (ft_strcmp(name, "#") == 0)
+	{
+		if (!shell->frames)
+			return (ft_itoa(0));
+		return (ft_itoa(shell->frames->argc - 1));
+	}
+	if (ft_strcmp(name, "@") == 0 || ft_strcmp(name, "*") == 0)
+		return (join_positional(shell));
+	value = lookup_variable(shell, name);
+	if (!value)
+		return (ft_strdup(""));
+	return (ft_strdup(value));
+}
+
+/**
+ * Split an unquoted parameter value on IFS
+ * IFS whitespace collapses and never produces empty fields; any other IFS
+ * character (with surrounding IFS whitespace) ends exactly one field
+ * @param value Parameter value
+ * @param ifs Field separators
+ * @param buf Field being built, continued by the value's first field
+ * @param fields Field list receiving completed fields
+ * @return SUCCESS or ERROR
+ */
+static int	split_value(char *value, char *ifs, t_field_buf *buf,
+	t_fields *fields)
+{
+	size_t	i;
+	size_t	start;
+	int		hard;
+
+	i = 0;
+	while (value[i])
+	{
+		if (!ft_strchr(ifs, value[i]))
+		{
+			start = i;
+			while (value[i] && !ft_strchr(ifs, value[i]))
+				i++;
+			if (buf_append(buf, value + start, i - start, 0) != SUCCESS)
+				return (ERROR);
+			continue ;
+		}
+		hard = 0;
+		while (value[i] && ft_strchr(ifs, value[i]))
+		{
+			if (!is_whitespace(value[i]))
+			{
+				if (hard)
+					break ;
+				hard = 1;
+			}
+			i++;
+		}
+		if ((buf->active || hard) && push_field(fields, buf) != SUCCESS)
+			return (ERROR);
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Expand "$@": one field per positional parameter
+ * The first and last parameters join the text around the quotes
+ * @param shell Shell structure
+ * @param buf Field being built
+ * @param fields Field list receiving completed fields
+ * @return SUCCESS or ERROR
+ */
+static int	expand_quoted_at(t_shell *shell, t_field_buf *buf,
+	t_fields *fields)
+{
+	int	i;
+
+	i = 1;
+	while (shell->frames && i < shell->frames->argc)
+	{
+		if (i > 1 && push_field(fields, buf) != SUCCESS)
+			return (ERROR);
+		if (buf_append(buf, shell->frames->argv[i],
+				ft_strlen(shell->frames->argv[i]), 1) != SUCCESS)
+			return (ERROR);
+		i++;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Expand one segment into the field being built
+ * @param seg Segment to expand
+ * @param shell Shell structure
+ * @param ifs Field separators
+ * @param buf Field being built
+ * @param fields Field list receiving completed fields
+ * @return SUCCESS or ERROR
+ */
+static int	expand_segment(t_segment *seg, t_shell *shell, char *ifs,
+	t_field_buf *buf, t_fields *fields)
+{
+	char	*value;
+	int		status;
+
+	if (seg->type != SEG_PARAM)
+		return (buf_append(buf, seg->text, ft_strlen(seg->text),
+				seg->quoted));
+	if (seg->quoted && ft_strcmp(seg->text, "@") == 0)
+		return (expand_quoted_at(shell, buf, fields));
+	value = param_value(shell, seg->text);
+	if (!value)
+		return (ERROR);
+	if (seg->quoted)
+		status = buf_append(buf, value, ft_strlen(value), 1);
+	else
+		status = split_value(value, ifs, buf, fields);
+	ft_free(value);
+	return (status);
+}
+
+/**
+ * Check if a word has glob characters outside quotes
+ * @param word Word to check
+ * @return 1 if pathname expansion may apply, 0 otherwise
+ */
+static int	word_has_glob(t_word *word)
+{
+	t_segment	*seg;
+	int			i;
+
+	seg = word->segs;
+	while (seg)
+	{
+		i = 0;
+		while (seg->type == SEG_LITERAL && seg->text[i])
+		{
+			if (is_glob_char(seg->text[i++]))
+				return (1);
+		}
+		seg = seg->next;
+	}
+	return (0);
+}
+
+/**
+ * Expand a word into zero or more fields
+ * Segments are walked once; quoted text is copied verbatim and only
+ * unquoted parameters are split. An unquoted word that expands to
+ * nothing produces no field.
+ * @param word Word to expand
+ * @param shell Shell structure
+ * @param ifs Field separators
+ * @param fields Field list receiving the results
+ * @return SUCCESS or ERROR
+ */
+static int	expand_word(t_word *word, t_shell *shell, char *ifs,
+	t_fields *fields)
+{
+	t_field_buf	buf;
+	t_segment	*seg;
+	int			status;
+
+	ft_memset(&buf, 0, sizeof(t_field_buf));
+	// Words without parameters or patterns are their quote-removed text
+	if (!word->has_params && !word_has_glob(word) && !fields->patterns)
+	{
+		if (!*word->text && !word->quoted)
+			return (SUCCESS);
+		return (fields_push(fields, ft_strdup(word->text)));
+	}
+	status = SUCCESS;
+	seg = word->segs;
+	while (seg && status == SUCCESS)
+	{
+		status = expand_segment(seg, shell, ifs, &buf, fields);
+		seg = seg->next;
+	}
+	if (status == SUCCESS && (buf.active || fields->patterns))
+		status = push_field(fields, &buf);
+	ft_free(buf.data);
+	return (status);
+}
+
+/**
+ * Expand a redirection target, which must produce exactly one field
+ * @param redir Redirection to expand
+ * @param shell Shell structure
+ * @param ifs Field separators
+ * @return SUCCESS or ERROR
+ */
+static int	expand_redirection(t_redirection *redir, t_shell *shell,
+	char *ifs)
+{
+	t_fields	fields;
+
+	ft_memset(&fields, 0, sizeof(t_fields));
+	fields.glob = &shell->glob_cache;
+	if (expand_word(redir->word, shell, ifs, &fields) != SUCCESS)
+	{
+		free_string_array(fields.items);
+		return (ERROR);
+	}
+	if (fields.count != 1)
+	{
+		print_error(NULL, redir->word->text, "ambiguous redirect");
+		free_string_array(fields.items);
+		return (ERROR);
+	}
+	ft_free(redir->file);
+	redir->file = fields.items[0];
+	ft_free(fields.items);
+	return (SUCCESS);
+}
+
+/**
+ * Expand the words and redirection targets of a command
+ * Rebuilds cmd->args from cmd->words, leaving the words untouched so the
+ * same command can be expanded again on its next execution
+ * @param cmd Command to expand
+ * @param shell Shell structure for variable lookup
+ * @return Success or error code
+ */
+int	expand_command(t_command *cmd, t_shell *shell)
+{
+	t_fields		fields;
+	t_redirection	*redir;
+	t_word			*word;
+	char			*ifs;
+
+	if (!cmd || !shell)
+		return (ERROR);
+	free_string_array(cmd->args);
+	cmd->args = NULL;
+	ifs = lookup_variable(shell, "IFS");
+	if (!ifs)
+		ifs = " \t\n";
+	ft_memset(&fields, 0, sizeof(t_fields));
+	fields.glob = &shell->glob_cache;
+	// [[ sees unsplit words and matches its patterns itself
+	if (cmd->words && ft_strcmp(cmd->words->text, "[[") == 0)
+	{
+		fields.glob = NULL;
+		fields.patterns = 1;
+		ifs = "";
+	}
+	word = cmd->words;
+	while (word)
+	{
+		if (expand_word(word, shell, ifs, &fields) != SUCCESS)
+		{
+			free_string_array(fields.items);
+			return (ERROR);
+		}
+		word = word->next;
+	}
+	cmd->args = fields.items;
+	redir = cmd->redirections;
+	while (redir)
+	{
+		// Heredoc temp files are already final
+		if (!is_heredoc_file(redir->word->text)
+			&& expand_redirection(redir, shell, ifs) != SUCCESS)
+			return (ERROR);
+		redir = redir->next;
+	}
+	return (SUCCESS);
+}
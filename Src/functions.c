@@ -0,0 +1,510 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   functions.c                                        :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/05 14:12:37 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/05 14:12:37 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Find a shell function by name
+ * @param shell Shell structure
+ * @param name Function name to look up
+ * @return Function entry or NULL if not defined
+ */
+t_func	*find_function(t_shell *shell, char *name)
+{
+	t_func	*current;
+
+	if (!shell || !name)
+		return (NULL);
+	current = shell->functions;
+	while (current)
+	{
+		if (ft_strcmp(current->name, name) == 0)
+			return (current);
+		current = current->next;
+	}
+	return (NULL);
+}
+
+/**
+ * Give a copied body heredoc files of its own
+ * The body runs once per call and outlives the line that defined it, so
+ * it must not share files that line removes. A redirection whose file
+ * cannot be copied is left without one
+ * @param shell Shell structure
+ * @param commands Copied body
+ * @return SUCCESS, or ERROR if any file could not be copied
+ */
+static int	own_heredocs(t_shell *shell, t_command *commands)
+{
+	t_redirection	*redir;
+	char			*copy;
+	int				status;
+
+	status = SUCCESS;
+	while (commands)
+	{
+		redir = commands->redirections;
+		while (redir)
+		{
+			if (is_heredoc_file(redir->file))
+			{
+				copy = copy_heredoc_file(shell, redir->file);
+				ft_free(redir->file);
+				redir->file = copy;
+				free_words(redir->word);
+				redir->word = NULL;
+				if (copy)
+					redir->word = word_from_text(copy);
+				if (!redir->word)
+					status = ERROR;
+			}
+			redir = redir->next;
+		}
+		if (own_heredocs(shell, commands->body) != SUCCESS)
+			status = ERROR;
+		commands = commands->next;
+	}
+	return (status);
+}
+
+/**
+ * Copy a function body with heredoc files of its own
+ * @param shell Shell structure
+ * @param body Body to copy
+ * @return Copied body or NULL on error
+ */
+static t_command	*copy_body(t_shell *shell, t_command *body)
+{
+	t_command	*copy;
+
+	copy = copy_commands(body);
+	if (copy && own_heredocs(shell, copy) != SUCCESS)
+	{
+		cleanup_all_heredocs(copy);
+		free_commands(copy);
+		copy = NULL;
+	}
+	return (copy);
+}
+
+/**
+ * Free a single function entry, its body and the body's heredoc files
+ * @param func Function entry to free
+ */
+static void	free_function(t_func *func)
+{
+	cleanup_all_heredocs(func->body);
+	ft_free(func->name);
+	free_commands(func->body);
+	ft_free(func);
+}
+
+/**
+ * Unlink a function from the table
+ * A function that is still executing is only marked defunct and is
+ * freed by call_function once its last active call returns
+ * @param shell Shell structure
+ * @param func Function entry to remove
+ */
+static void	remove_function(t_shell *shell, t_func *func)
+{
+	t_func	**link;
+
+	link = &shell->functions;
+	while (*link && *link != func)
+		link = &(*link)->next;
+	if (*link)
+		*link = func->next;
+	func->next = NULL;
+	if (func->refs > 0)
+		func->defunct = 1;
+	else
+		free_function(func);
+}
+
+/**
+ * Define or redefine a shell function
+ * The table keeps its own copy of the parsed body, so the definition
+ * outlives the command line it came from
+ * @param shell Shell structure
+ * @param name Function name
+ * @param body Parsed (unexpanded) function body
+ * @return SUCCESS or ERROR
+ */
+int	define_function(t_shell *shell, char *name, t_command *body)
+{
+	t_func	*func;
+	t_func	*old;
+
+	if (!shell || !name || !body)
+		return (ERROR);
+	func = (t_func *)ft_malloc(sizeof(t_func));
+	if (!func)
+		return (ERROR);
+	func->name = ft_strdup(name);
+	func->body = copy_body(shell, body);
+	if (!func->name || !func->body)
+	{
+		ft_free(func->name);
+		cleanup_all_heredocs(func->body);
+		free_commands(func->body);
+		ft_free(func);
+		print_error(name, NULL, "failed to define function");
+		return (ERROR);
+	}
+	func->refs = 0;
+	func->defunct = 0;
+	old = find_function(shell, name);
+	if (old)
+		remove_function(shell, old);
+	func->next = shell->functions;
+	shell->functions = func;
+	return (SUCCESS);
+}
+
+/**
+ * Remove a shell function by name
+ * @param shell Shell structure
+ * @param name Function name
+ * @return SUCCESS, or ERROR when there is no such function
+ */
+int	unset_function(t_shell *shell, char *name)
+{
+	t_func	*func;
+
+	func = find_function(shell, name);
+	if (!func)
+		return (ERROR);
+	remove_function(shell, func);
+	return (SUCCESS);
+}
+
+/**
+ * Copy a function table, keeping its order
+ * @param shell Shell structure
+ * @param functions Function list to copy
+ * @param copy Set to the copied list
+ * @return SUCCESS or ERROR (nothing is copied)
+ */
+int	copy_functions(t_shell *shell, t_func *functions, t_func **copy)
+{
+	t_func	**link;
+	t_func	*func;
+
+	*copy = NULL;
+	link = copy;
+	while (functions)
+	{
+		func = (t_func *)ft_malloc(sizeof(t_func));
+		if (!func)
+			break ;
+		ft_memset(func, 0, sizeof(t_func));
+		*link = func;
+		link = &func->next;
+		func->name = ft_strdup(functions->name);
+		func->body = copy_body(shell, functions->body);
+		if (!func->name || !func->body)
+			break ;
+		functions = functions->next;
+	}
+	if (!functions)
+		return (SUCCESS);
+	free_functions(*copy);
+	*copy = NULL;
+	return (ERROR);
+}
+
+/**
+ * Free the whole function table
+ * @param functions Function list to free
+ */
+void	free_functions(t_func *functions)
+{
+	t_func	*next;
+
+	while (functions)
+	{
+		next = functions->next;
+		free_function(functions);
+		functions = next;
+	}
+}
+
+/**
+ * Push a call frame holding the positional parameters
+ * @param shell Shell structure
+ * @param args Expanded argv of the call ($0 is the function or script name)
+ * @return SUCCESS or ERROR
+ */
+int	push_frame(t_shell *shell, char **args)
+{
+	t_frame	*frame;
+
+	frame = (t_frame *)ft_malloc(sizeof(t_frame));
+	if (!frame)
+		return (ERROR);
+	frame->argv = dup_string_array(args);
+	if (!frame->argv)
+	{
+		ft_free(frame);
+		return (ERROR);
+	}
+	frame->argc = 0;
+	while (frame->argv[frame->argc])
+		frame->argc++;
+	frame->locals = NULL;
+	frame->prev = shell->frames;
+	shell->frames = frame;
+	shell->func_depth++;
+	return (SUCCESS);
+}
+
+/**
+ * Pop the innermost call frame and free its locals
+ * @param shell Shell structure
+ */
+void	pop_frame(t_shell *shell)
+{
+	t_frame	*frame;
+
+	frame = shell->frames;
+	if (!frame)
+		return ;
+	shell->frames = frame->prev;
+	shell->func_depth--;
+	free_string_array(frame->argv);
+	free_env(frame->locals);
+	ft_free(frame);
+}
+
+/**
+ * Call a shell function in the current process
+ * @param func Function to call
+ * @param cmd Calling command, its expanded args become $0..$n
+ * @param shell Shell structure
+ * @return Exit status of the function
+ */
+int	call_function(t_func *func, t_command *cmd, t_shell *shell)
+{
+	int	status;
+
+	if (shell->func_depth >= FUNC_MAX_DEPTH)
+	{
+		print_error(func->name, NULL, "maximum function nesting level exceeded");
+		return (ERROR);
+	}
+	if (push_frame(shell, cmd->args) != SUCCESS)
+	{
+		print_error(func->name, NULL, "memory allocation failed");
+		return (ERROR);
+	}
+	func->refs++;
+	status = execute_commands(func->body, shell);
+	func->refs--;
+	
+	// A return only unwinds the innermost function
+	shell->func_return = 0;
+	pop_frame(shell);
+	if (func->defunct && func->refs == 0)
+		free_function(func);
+	return (status);
+}
+
+/**
+ * Look up a variable, honouring positional parameters and locals
+ * @param shell Shell structure
+ * @param name Variable name (a single digit selects a positional parameter)
+ * @return Variable value or NULL if not set
+ */
+char	*lookup_variable(t_shell *shell, char *name)
+{
+	t_frame	*frame;
+	t_env	*local;
+	int		index;
+
+	if (!shell || !name)
+		return (NULL);
+	if (ft_isdigit(name[0]) && !name[1])
+	{
+		index = name[0] - '0';
+		if (index == 0)
+			return ("minishell");
+		if (!shell->frames || index >= shell->frames->argc)
+			return (NULL);
+		return (shell->frames->argv[index]);
+	}
+	
+	// Locals are dynamically scoped: the innermost declaration wins
+	frame = shell->frames;
+	while (frame)
+	{
+		local = frame->locals;
+		while (local)
+		{
+			if (ft_strcmp(local->key, name) == 0)
+				return (local->value);
+			local = local->next;
+		}
+		frame = frame->prev;
+	}
+	return (get_env_value(shell->env_list, name));
+}
+
+/**
+ * Declare or assign a local variable in the innermost frame
+ * @param shell Shell structure
+ * @param key Variable name
+ * @param value Value to assign, or NULL to only declare the variable
+ * @return SUCCESS or ERROR
+ */
+int	set_local_variable(t_shell *shell, char *key, char *value)
+{
+	t_env	*local;
+
+	if (!shell || !shell->frames || !key)
+		return (ERROR);
+	local = shell->frames->locals;
+	while (local && ft_strcmp(local->key, key) != 0)
+		local = local->next;
+	if (!local)
+	{
+		local = (t_env *)ft_malloc(sizeof(t_env));
+		if (!local)
+			return (ERROR);
+		local->key = ft_strdup(key);
+		if (!local->key)
+		{
+			ft_free(local);
+			return (ERROR);
+		}
+		local->value = NULL;
+		local->next = shell->frames->locals;
+		shell->frames->locals = local;
+	}
+	if (!value)
+		return (SUCCESS);
+	ft_free(local->value);
+	local->value = ft_strdup(value);
+	if (!local->value)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Assign a variable the way lookup_variable finds it
+ * A local declared in any active frame is updated in place, anything
+ * else goes to the environment
+ * @param shell Shell structure
+ * @param key Variable name
+ * @param value Value to assign
+ * @return SUCCESS or ERROR
+ */
+int	assign_variable(t_shell *shell, char *key, char *value)
+{
+	t_frame	*frame;
+	t_env	*local;
+
+	frame = shell->frames;
+	while (frame)
+	{
+		local = frame->locals;
+		while (local && ft_strcmp(local->key, key) != 0)
+			local = local->next;
+		if (local)
+		{
+			ft_free(local->value);
+			local->value = ft_strdup(value);
+			if (!local->value)
+				return (ERROR);
+			return (SUCCESS);
+		}
+		frame = frame->prev;
+	}
+	return (set_env_value(shell->env_list, key, value));
+}
+
+/**
+ * Assign element NAME_index of a list variable
+ * @param shell Shell structure
+ * @param name List name
+ * @param index Element index, -1 for NAME_COUNT
+ * @param value Value, NULL unsets the element
+ * @return SUCCESS or ERROR
+ */
+static int	assign_element(t_shell *shell, char *name, int index, char *value)
+{
+	char	*prefix;
+	char	*suffix;
+	char	*key;
+	int		status;
+
+	prefix = ft_strjoin(name, "_");
+	if (index < 0)
+		suffix = ft_strdup("COUNT");
+	else
+		suffix = ft_itoa(index);
+	key = NULL;
+	if (prefix && suffix)
+		key = ft_strjoin(prefix, suffix);
+	ft_free(prefix);
+	ft_free(suffix);
+	status = ERROR;
+	if (key && value)
+		status = assign_variable(shell, key, value);
+	else if (key)
+		status = unset_env_value(&shell->env_list, key);
+	ft_free(key);
+	return (status);
+}
+
+/**
+ * Assign a list to NAME_0 ... NAME_{count-1} and NAME_COUNT
+ * The shell has no arrays; elements left over from a longer earlier
+ * list are removed
+ * @param shell Shell structure
+ * @param name List name
+ * @param items Elements
+ * @param count Number of elements
+ * @return SUCCESS or ERROR
+ */
+int	assign_list(t_shell *shell, char *name, char **items, int count)
+{
+	char	*key;
+	char	*value;
+	int		previous;
+	int		i;
+
+	key = ft_strjoin(name, "_COUNT");
+	if (!key)
+		return (ERROR);
+	previous = 0;
+	if (lookup_variable(shell, key))
+		previous = ft_atoi(lookup_variable(shell, key));
+	ft_free(key);
+	i = 0;
+	while (i < count)
+	{
+		if (assign_element(shell, name, i, items[i]) != SUCCESS)
+			return (ERROR);
+		i++;
+	}
+	value = ft_itoa(count);
+	if (!value || assign_element(shell, name, -1, value) != SUCCESS)
+	{
+		ft_free(value);
+		return (ERROR);
+	}
+	ft_free(value);
+	while (i < previous)
+		assign_element(shell, name, i++, NULL);
+	return (SUCCESS);
+}
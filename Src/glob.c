@@ -0,0 +1,580 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   glob.c                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/09 14:12:37 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/09 14:12:37 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Compile a bracket expression into a character set
+ * @param p Pattern text following the '['
+ * @param tok Token receiving the set
+ * @return Number of bytes consumed after the '[', or 0 if unterminated
+ */
+static int	compile_class(const char *p, t_glob_tok *tok)
+{
+	unsigned char	lo;
+	unsigned char	hi;
+	int				negate;
+	int				first;
+	int				i;
+
+	ft_memset(tok->set, 0, sizeof(tok->set));
+	negate = (p[0] == '!' || p[0] == '^');
+	i = negate;
+	first = i;
+	while (p[i] && (p[i] != ']' || i == first))
+	{
+		if (p[i] == '\\' && p[i + 1])
+			i++;
+		lo = (unsigned char)p[i];
+		hi = lo;
+		if (p[i + 1] == '-' && p[i + 2] && p[i + 2] != ']')
+		{
+			i += 2;
+			if (p[i] == '\\' && p[i + 1])
+				i++;
+			hi = (unsigned char)p[i];
+		}
+		while (lo <= hi)
+		{
+			tok->set[lo >> 3] |= (unsigned char)(1 << (lo & 7));
+			if (lo == 255)
+				break ;
+			lo++;
+		}
+		i++;
+	}
+	if (!p[i])
+		return (0);
+	lo = 0;
+	while (negate && lo < sizeof(tok->set))
+		tok->set[lo++] ^= 0xff;
+	tok->op = GLOB_CLASS;
+	return (i + 1);
+}
+
+/**
+ * Compile one path component of a pattern
+ * Components without magic characters keep only their unescaped text
+ * @param text Component text (NUL-terminated, may contain '\\' escapes)
+ * @param comp Component to fill
+ * @return SUCCESS or ERROR
+ */
+static int	compile_component(const char *text, t_glob_comp *comp)
+{
+	int	magic;
+	int	i;
+	int	used;
+
+	comp->count = 0;
+	comp->literal = NULL;
+	comp->toks = (t_glob_tok *)ft_malloc(sizeof(t_glob_tok)
+			* (ft_strlen(text) + 1));
+	if (!comp->toks)
+		return (ERROR);
+	magic = 0;
+	i = 0;
+	while (text[i])
+	{
+		used = 0;
+		if (text[i] == '[')
+			used = compile_class(text + i + 1, &comp->toks[comp->count]);
+		if (used)
+			i += used + 1;
+		else if (text[i] == '?' || text[i] == '*')
+		{
+			used = 1;
+			// Consecutive stars are the same as one
+			if (text[i++] == '*' && comp->count
+				&& comp->toks[comp->count - 1].op == GLOB_STAR)
+				continue ;
+			comp->toks[comp->count].op = GLOB_ANY;
+			if (text[i - 1] == '*')
+				comp->toks[comp->count].op = GLOB_STAR;
+		}
+		else
+		{
+			if (text[i] == '\\' && text[i + 1])
+				i++;
+			comp->toks[comp->count].op = GLOB_CHAR;
+			comp->toks[comp->count].c = (unsigned char)text[i++];
+		}
+		magic |= used;
+		comp->count++;
+	}
+	if (magic)
+		return (SUCCESS);
+	comp->literal = (char *)ft_malloc(comp->count + 1);
+	if (!comp->literal)
+		return (ERROR);
+	i = -1;
+	while (++i < comp->count)
+		comp->literal[i] = (char)comp->toks[i].c;
+	comp->literal[i] = '\0';
+	return (SUCCESS);
+}
+
+/**
+ * Check whether a single token matches a character
+ * @param tok Pattern token
+ * @param c Character
+ * @return 1 on match, 0 otherwise
+ */
+static int	tok_matches(t_glob_tok *tok, unsigned char c)
+{
+	if (tok->op == GLOB_ANY)
+		return (1);
+	if (tok->op == GLOB_CHAR)
+		return (tok->c == c);
+	return ((tok->set[c >> 3] >> (c & 7)) & 1);
+}
+
+/**
+ * Match a name against a compiled component
+ * Backtracks only to the most recent '*', so matching is linear in practice
+ * @param toks Compiled tokens
+ * @param count Number of tokens
+ * @param name Name to match
+ * @return 1 on match, 0 otherwise
+ */
+int	glob_match(t_glob_tok *toks, int count, const char *name)
+{
+	size_t	n;
+	size_t	star_n;
+	int		t;
+	int		star_t;
+
+	n = 0;
+	t = 0;
+	star_t = -1;
+	star_n = 0;
+	while (name[n])
+	{
+		if (t < count && toks[t].op == GLOB_STAR)
+		{
+			star_t = t++;
+			star_n = n;
+		}
+		else if (t < count && tok_matches(&toks[t], (unsigned char)name[n]))
+		{
+			t++;
+			n++;
+		}
+		else if (star_t < 0)
+			return (0);
+		else
+		{
+			t = star_t + 1;
+			n = ++star_n;
+		}
+	}
+	while (t < count && toks[t].op == GLOB_STAR)
+		t++;
+	return (t == count);
+}
+
+/**
+ * Compare two directory entries by name
+ * @param a First entry
+ * @param b Second entry
+ * @return strcmp-style ordering
+ */
+static int	compare_entries(const void *a, const void *b)
+{
+	return (ft_strcmp(((t_dir_entry *)a)->name, ((t_dir_entry *)b)->name));
+}
+
+/**
+ * Append one readdir entry to a listing being built
+ * Names go into a single growing pool instead of one allocation each
+ * @param listing Listing being built
+ * @param ent Directory entry
+ * @param pool_cap Current pool capacity
+ * @param cap Current entry capacity
+ * @return SUCCESS or ERROR
+ */
+static int	add_entry(t_dir_listing *listing, struct dirent *ent,
+	size_t *pool_cap, int *cap)
+{
+	size_t	len;
+	void	*grown;
+
+	len = ft_strlen(ent->d_name) + 1;
+	if (listing->count == *cap || listing->pool_len + len > *pool_cap)
+	{
+		*cap = *cap * 2 + 16;
+		*pool_cap = (*pool_cap + len) * 2;
+		grown = ft_malloc(sizeof(t_dir_entry) * *cap);
+		if (grown && listing->entries)
+			ft_memcpy(grown, listing->entries,
+				sizeof(t_dir_entry) * listing->count);
+		ft_free(listing->entries);
+		listing->entries = (t_dir_entry *)grown;
+		grown = ft_malloc(*pool_cap);
+		if (grown && listing->pool)
+			ft_memcpy(grown, listing->pool, listing->pool_len);
+		ft_free(listing->pool);
+		listing->pool = (char *)grown;
+		if (!listing->entries || !listing->pool)
+			return (ERROR);
+	}
+	ft_memcpy(listing->pool + listing->pool_len, ent->d_name, len);
+	listing->entries[listing->count].off = listing->pool_len;
+	listing->entries[listing->count++].type = ent->d_type;
+	listing->pool_len += len;
+	return (SUCCESS);
+}
+
+/**
+ * Read and sort a directory listing
+ * A directory that cannot be opened yields an empty listing so that it
+ * is not retried for the rest of the command line
+ * @param path Directory path
+ * @return New listing or NULL on allocation failure
+ */
+static t_dir_listing	*read_listing(const char *path)
+{
+	t_dir_listing	*listing;
+	struct dirent	*ent;
+	DIR				*dir;
+	size_t			pool_cap;
+	int				cap;
+
+	listing = (t_dir_listing *)ft_malloc(sizeof(t_dir_listing));
+	if (!listing)
+		return (NULL);
+	ft_memset(listing, 0, sizeof(t_dir_listing));
+	pool_cap = 0;
+	cap = 0;
+	dir = opendir(path);
+	while (dir)
+	{
+		ent = readdir(dir);
+		if (!ent)
+			break ;
+		if (ft_strcmp(ent->d_name, ".") == 0 || ft_strcmp(ent->d_name, "..") == 0)
+			continue ;
+		if (add_entry(listing, ent, &pool_cap, &cap) != SUCCESS)
+		{
+			closedir(dir);
+			ft_free(listing->entries);
+			ft_free(listing->pool);
+			ft_free(listing);
+			return (NULL);
+		}
+	}
+	if (dir)
+		closedir(dir);
+	cap = -1;
+	while (++cap < listing->count)
+		listing->entries[cap].name = listing->pool + listing->entries[cap].off;
+	if (listing->count > 1)
+		qsort(listing->entries, listing->count, sizeof(t_dir_entry),
+			compare_entries);
+	return (listing);
+}
+
+/**
+ * Get the listing of a directory, reading it only on first use
+ * @param cache Directory cache
+ * @param path Directory path
+ * @return Listing or NULL on allocation failure
+ */
+static t_dir_listing	*get_listing(t_glob_cache *cache, char *path)
+{
+	t_dir_listing	*listing;
+	unsigned long	hash;
+
+	hash = hash_line(path);
+	listing = cache->buckets[hash % GLOB_CACHE_BUCKETS];
+	while (listing)
+	{
+		if (listing->hash == hash && ft_strcmp(listing->path, path) == 0)
+		{
+			cache->hits++;
+			return (listing);
+		}
+		listing = listing->next;
+	}
+	listing = read_listing(path);
+	if (!listing)
+		return (NULL);
+	listing->path = ft_strdup(path);
+	if (!listing->path)
+	{
+		ft_free(listing->entries);
+		ft_free(listing->pool);
+		ft_free(listing);
+		return (NULL);
+	}
+	cache->reads++;
+	listing->hash = hash;
+	listing->next = cache->buckets[hash % GLOB_CACHE_BUCKETS];
+	cache->buckets[hash % GLOB_CACHE_BUCKETS] = listing;
+	return (listing);
+}
+
+/**
+ * Free every cached listing
+ * @param cache Directory cache
+ */
+void	glob_cache_clear(t_glob_cache *cache)
+{
+	t_dir_listing	*listing;
+	t_dir_listing	*next;
+	int				i;
+
+	i = 0;
+	while (i < GLOB_CACHE_BUCKETS)
+	{
+		listing = cache->buckets[i];
+		while (listing)
+		{
+			next = listing->next;
+			ft_free(listing->path);
+			ft_free(listing->pool);
+			ft_free(listing->entries);
+			ft_free(listing);
+			listing = next;
+		}
+		cache->buckets[i++] = NULL;
+	}
+}
+
+/**
+ * Check whether the path in the walk buffer is a directory
+ * d_type answers without a stat call except for symlinks and file
+ * systems that do not report it
+ * @param walk Walk state, path holding the full candidate path
+ * @param type d_type of the entry, DT_UNKNOWN to force a stat
+ * @return 1 if it is a directory, 0 otherwise
+ */
+static int	is_directory(t_glob_walk *walk, unsigned char type)
+{
+	struct stat	st;
+
+	if (type == DT_DIR)
+		return (1);
+	if (type != DT_UNKNOWN && type != DT_LNK)
+		return (0);
+	return (stat(walk->path, &st) == 0 && S_ISDIR(st.st_mode));
+}
+
+/**
+ * Record the path in the walk buffer as a match
+ * @param walk Walk state
+ * @param len Length of the path
+ * @return SUCCESS or ERROR
+ */
+static int	add_match(t_glob_walk *walk, size_t len)
+{
+	if (walk->dir_only)
+	{
+		walk->path[len++] = '/';
+		walk->path[len] = '\0';
+	}
+	walk->matches++;
+	return (fields_push(walk->out, ft_strdup(walk->path)));
+}
+
+static int	walk_component(t_glob_walk *walk, int idx, size_t len);
+
+/**
+ * Append a name to the walk buffer and continue with the next component
+ * @param walk Walk state
+ * @param idx Index of the component the name matched
+ * @param len Length of the current prefix
+ * @param ent Matched entry (type DT_UNKNOWN when not from a listing)
+ * @return SUCCESS or ERROR
+ */
+static int	descend(t_glob_walk *walk, int idx, size_t len, t_dir_entry *ent)
+{
+	struct stat	st;
+	size_t		nlen;
+	int			last;
+
+	nlen = ft_strlen(ent->name);
+	if (len + nlen + 2 > GLOB_PATH_MAX)
+		return (SUCCESS);
+	ft_memcpy(walk->path + len, ent->name, nlen + 1);
+	last = (idx + 1 == walk->ncomp);
+	if ((!last || walk->dir_only) && !is_directory(walk, ent->type))
+		return (SUCCESS);
+	// Literal names do not come from a listing, so check they exist
+	if (last && walk->comps[idx].literal && lstat(walk->path, &st) != 0)
+		return (SUCCESS);
+	if (last)
+		return (add_match(walk, len + nlen));
+	walk->path[len + nlen] = '/';
+	walk->path[len + nlen + 1] = '\0';
+	return (walk_component(walk, idx + 1, len + nlen + 1));
+}
+
+/**
+ * Match one component against the directory held in the walk buffer
+ * @param walk Walk state
+ * @param idx Component index
+ * @param len Length of the current prefix (ends with '/' unless empty)
+ * @return SUCCESS or ERROR
+ */
+static int	walk_component(t_glob_walk *walk, int idx, size_t len)
+{
+	t_glob_comp		*comp;
+	t_dir_listing	*listing;
+	t_dir_entry		lit;
+	int				i;
+
+	comp = &walk->comps[idx];
+	if (comp->literal)
+	{
+		lit.name = comp->literal;
+		lit.type = DT_UNKNOWN;
+		return (descend(walk, idx, len, &lit));
+	}
+	walk->path[len] = '\0';
+	if (len)
+		listing = get_listing(walk->cache, walk->path);
+	else
+		listing = get_listing(walk->cache, ".");
+	if (!listing)
+		return (ERROR);
+	i = -1;
+	while (++i < listing->count)
+	{
+		// A leading '.' must be matched explicitly
+		if (listing->entries[i].name[0] == '.' && (comp->toks[0].op != GLOB_CHAR
+				|| comp->toks[0].c != '.'))
+			continue ;
+		if (!glob_match(comp->toks, comp->count, listing->entries[i].name))
+			continue ;
+		if (descend(walk, idx, len, &listing->entries[i]) != SUCCESS)
+			return (ERROR);
+		walk->path[len] = '\0';
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Free compiled pattern components
+ * @param comps Component array
+ * @param count Number of compiled components
+ */
+static void	free_components(t_glob_comp *comps, int count)
+{
+	while (count-- > 0)
+	{
+		ft_free(comps[count].toks);
+		ft_free(comps[count].literal);
+	}
+	ft_free(comps);
+}
+
+/**
+ * Split a pattern on '/' and compile each non-empty component
+ * @param pattern Pattern text
+ * @param walk Walk state receiving comps and ncomp
+ * @return Number of components with magic characters, or -1 on error
+ */
+static int	compile_pattern(char *pattern, t_glob_walk *walk)
+{
+	char	*text;
+	int		magic;
+	int		start;
+	int		i;
+
+	walk->comps = (t_glob_comp *)ft_malloc(sizeof(t_glob_comp)
+			* (ft_strlen(pattern) / 2 + 1));
+	if (!walk->comps)
+		return (-1);
+	magic = 0;
+	i = 0;
+	while (pattern[i])
+	{
+		start = i;
+		while (pattern[i] && pattern[i] != '/')
+			i++;
+		text = ft_substr(pattern, start, i - start);
+		if (!text || (i > start && compile_component(text,
+					&walk->comps[walk->ncomp++]) != SUCCESS))
+		{
+			ft_free(text);
+			return (-1);
+		}
+		ft_free(text);
+		magic += (i > start && !walk->comps[walk->ncomp - 1].literal);
+		while (pattern[i] == '/')
+			i++;
+	}
+	return (magic);
+}
+
+/**
+ * Expand a pattern into the sorted list of matching paths
+ * Each directory is read at most once per command line through the cache,
+ * and candidate paths are built in a single fixed buffer
+ * @param cache Directory cache
+ * @param pattern Pattern with quoted characters escaped by '\\'
+ * @param out Field list receiving the matches
+ * @return Number of matches, or -1 on error
+ */
+int	glob_expand(t_glob_cache *cache, char *pattern, t_fields *out)
+{
+	t_glob_walk	*walk;
+	int			status;
+
+	walk = (t_glob_walk *)ft_malloc(sizeof(t_glob_walk));
+	if (!walk)
+		return (-1);
+	ft_memset(walk, 0, sizeof(t_glob_walk) - GLOB_PATH_MAX);
+	walk->cache = cache;
+	walk->out = out;
+	walk->dir_only = (*pattern && pattern[ft_strlen(pattern) - 1] == '/');
+	status = compile_pattern(pattern, walk);
+	if (status > 0)
+	{
+		walk->path[0] = '\0';
+		if (*pattern == '/')
+			walk->path[0] = '/';
+		walk->path[1] = '\0';
+		status = walk_component(walk, 0, *pattern == '/');
+		if (status == SUCCESS)
+			status = walk->matches;
+		else
+			status = -1;
+	}
+	free_components(walk->comps, walk->ncomp);
+	ft_free(walk);
+	return (status);
+}
+
+/**
+ * Match a string against a whole pattern, as case and [[ == do
+ * Unlike pathname expansion, '/' and a leading '.' are ordinary
+ * characters
+ * @param pattern Pattern with quoted characters escaped by '\\'
+ * @param text String to match
+ * @return 1 on match, 0 otherwise, -1 on error
+ */
+int	glob_pattern_match(char *pattern, char *text)
+{
+	t_glob_comp	comp;
+	int			match;
+
+	if (compile_component(pattern, &comp) != SUCCESS)
+	{
+		ft_free(comp.toks);
+		return (-1);
+	}
+	match = glob_match(comp.toks, comp.count, text);
+	ft_free(comp.toks);
+	ft_free(comp.literal);
+	return (match);
+}
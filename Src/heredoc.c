@@ -14,30 +14,37 @@
 
 /**
  * Create a temporary file for heredoc content
+ * Names carry the pid and a per-shell counter; O_EXCL skips names taken
+ * by other shells, including other instances in the same process
+ * @param shell Shell structure
  * @return Path to the temporary file or NULL on error
  */
-char	*create_heredoc_file(void)
+char	*create_heredoc_file(t_shell *shell)
 {
 	char	*filename;
 	int		fd;
-	static int	heredoc_count = 0;
 
 	// Create a unique filename for the heredoc
-	filename = ft_malloc(sizeof(char) * 20);
+	filename = ft_malloc(sizeof(char) * 48);
 	if (!filename)
 		return (NULL);
 	
-	sprintf(filename, "/tmp/heredoc_%d", heredoc_count++);
-	
 	// Create and close the file
-	fd = open(filename, O_CREAT | O_WRONLY | O_TRUNC, 0644);
-	if (fd == -1)
+	fd = -1;
+	while (fd == -1)
 	{
-		free(filename);
-		return (NULL);
+		snprintf(filename, 48, "/tmp/heredoc_%d_%d", (int)getpid(),
+			shell->heredoc_count++);
+		fd = open(filename, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+		if (fd == -1 && errno != EEXIST)
+		{
+			ft_free(filename);
+			return (NULL);
+		}
 	}
 	
 	close(fd);
+	stats_add(STAT_HEREDOCS, 1);
 	return (filename);
 }
 
@@ -54,6 +61,42 @@ int cleanup_heredoc(char *filename)
 	return SUCCESS;
 }
 
+/**
+ * Copy a heredoc body into a new temporary file
+ * @param shell Shell structure
+ * @param path Heredoc file to copy
+ * @return Path to the new file or NULL on error
+ */
+char	*copy_heredoc_file(t_shell *shell, char *path)
+{
+	char	buf[4096];
+	char	*copy;
+	ssize_t	n;
+	int		fds[2];
+
+	copy = create_heredoc_file(shell);
+	if (!copy)
+		return (NULL);
+	fds[0] = open(path, O_RDONLY | O_CLOEXEC);
+	fds[1] = open(copy, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	n = -1;
+	if (fds[0] >= 0 && fds[1] >= 0)
+		n = read(fds[0], buf, sizeof(buf));
+	while (n > 0 && write(fds[1], buf, n) == n)
+		n = read(fds[0], buf, sizeof(buf));
+	if (fds[0] >= 0)
+		close(fds[0]);
+	if (fds[1] >= 0 && close(fds[1]) != 0)
+		n = -1;
+	if (n != 0)
+	{
+		cleanup_heredoc(copy);
+		ft_free(copy);
+		return (NULL);
+	}
+	return (copy);
+}
+
 /**
  * Expand variables in a heredoc line
  * @param line Line to expand variables in
@@ -101,7 +144,7 @@ char	*expand_heredoc(char *line, t_env *env_list, int exit_status)
 				var_name = ft_substr(result, i + 1, j - i - 1);
 				if (!var_name)
 				{
-					free(result);
+					ft_free(result);
 					return (NULL);
 				}
 				
@@ -111,7 +154,7 @@ char	*expand_heredoc(char *line, t_env *env_list, int exit_status)
 				else
 					var_value = ft_strdup("");
 				
-				free(var_name);
+				ft_free(var_name);
 			}
 			else
 			{
@@ -122,7 +165,7 @@ char	*expand_heredoc(char *line, t_env *env_list, int exit_status)
 			
 			if (!var_value)
 			{
-				free(result);
+				ft_free(result);
 				return (NULL);
 			}
 			
@@ -131,33 +174,33 @@ char	*expand_heredoc(char *line, t_env *env_list, int exit_status)
 			char *after = ft_strdup(result + j);
 			if (!before || !after)
 			{
-				free(result);
-				free(var_value);
+				ft_free(result);
+				ft_free(var_value);
 				if (before)
-					free(before);
+					ft_free(before);
 				return (NULL);
 			}
 			
 			char *temp1 = ft_strjoin(before, var_value);
-			free(before);
-			free(var_value);
+			ft_free(before);
+			ft_free(var_value);
 			if (!temp1)
 			{
-				free(result);
-				free(after);
+				ft_free(result);
+				ft_free(after);
 				return (NULL);
 			}
 			
 			char *temp2 = ft_strjoin(temp1, after);
-			free(temp1);
-			free(after);
+			ft_free(temp1);
+			ft_free(after);
 			if (!temp2)
 			{
-				free(result);
+				ft_free(result);
 				return (NULL);
 			}
 			
-			free(result);
+			ft_free(result);
 			result = temp2;
 			i = 0;  // Start over with the new string
 			continue;
@@ -168,15 +211,39 @@ char	*expand_heredoc(char *line, t_env *env_list, int exit_status)
 	return (result);
 }
 
+/**
+ * Read one line of a heredoc body
+ * A script being sourced supplies its own lines; otherwise scripts read
+ * the body from the same descriptor as their commands
+ * @param src Line source of the running script, NULL for stdin
+ * @return Tracked line without its newline or NULL at EOF
+ */
+static char	*read_body_line(t_line_source *src)
+{
+	char	*raw;
+	char	*line;
+
+	if (src)
+		return (src->next(src->ctx));
+	if (!isatty(STDIN_FILENO))
+		return (read_line_fd(STDIN_FILENO));
+	raw = readline("> ");
+	if (!raw)
+		return (NULL);
+	line = ft_strdup(raw);
+	free(raw);
+	return (line);
+}
+
 /**
  * Read heredoc input until delimiter is encountered
+ * @param shell Shell structure (environment, $? and line source)
  * @param delimiter Delimiter string to end heredoc
  * @param fd File descriptor to write heredoc content to
- * @param env_list Environment variable list
- * @param exit_status Last command exit status
+ * @param expand Whether to expand variables (delimiter was unquoted)
  * @return Success or error code
  */
-int	read_heredoc(char *delimiter, int fd, t_env *env_list, int exit_status)
+static int	read_heredoc(t_shell *shell, char *delimiter, int fd, int expand)
 {
 	char	*line;
 	char	*expanded;
@@ -190,19 +257,25 @@ int	read_heredoc(char *delimiter, int fd, t_env *env_list, int exit_status)
 	// Read lines until delimiter is encountered
 	while (1)
 	{
-		line = readline("> ");
+		line = read_body_line(shell->line_source);
 		
 		// Check for EOF or delimiter
 		if (!line || ft_strcmp(line, delimiter) == 0)
 		{
 			if (line)
-				free(line);
+				ft_free(line);
 			break;
 		}
 		
-		// Expand variables in the line
-		expanded = expand_heredoc(line, env_list, exit_status);
-		free(line);
+		// Expand variables in the line unless the delimiter was quoted
+		if (expand)
+		{
+			expanded = expand_heredoc(line, shell->env_list,
+					shell->exit_status);
+			ft_free(line);
+		}
+		else
+			expanded = line;
 		
 		if (!expanded)
 		{
@@ -213,7 +286,7 @@ int	read_heredoc(char *delimiter, int fd, t_env *env_list, int exit_status)
 		// Write the line to the file
 		ft_putstr_fd(expanded, fd);
 		ft_putstr_fd("\n", fd);
-		free(expanded);
+		ft_free(expanded);
 	}
 	
 	// Restore signal handling
@@ -223,13 +296,13 @@ int	read_heredoc(char *delimiter, int fd, t_env *env_list, int exit_status)
 }
 
 /**
- * Handle heredoc input processing
+ * Write a heredoc body to a new temporary file
+ * @param shell Shell structure
  * @param delimiter Delimiter string to end heredoc
- * @param env_list Environment variable list
- * @param exit_status Last command exit status
+ * @param expand Whether to expand variables in the heredoc body
  * @return Path to the temporary file containing heredoc content or NULL on error
  */
-char	*handle_heredoc(char *delimiter, t_env *env_list, int exit_status)
+static char	*fill_heredoc(t_shell *shell, char *delimiter, int expand)
 {
 	char	*filename;
 	int		fd;
@@ -237,14 +310,14 @@ char	*handle_heredoc(char *delimiter, t_env *env_list, int exit_status)
 	int		status;
 
 	// Create a temporary file for heredoc content
-	filename = create_heredoc_file();
+	filename = create_heredoc_file(shell);
 	if (!filename)
 		return (NULL);
 	
 	fd = open(filename, O_WRONLY | O_APPEND, 0644);
 	if (fd == -1)
 	{
-		free(filename);
+		ft_free(filename);
 		return (NULL);
 	}
 	
@@ -254,12 +327,12 @@ char	*handle_heredoc(char *delimiter, t_env *env_list, int exit_status)
 	{
 		close(fd);
 		cleanup_heredoc(filename);
-		free(filename);
+		ft_free(filename);
 		return (NULL);
 	}
 	
 	// Process heredoc input
-	status = read_heredoc(delimiter, fd, env_list, exit_status);
+	status = read_heredoc(shell, delimiter, fd, expand);
 	
 	// Restore stdin
 	dup2(prev_stdin, STDIN_FILENO);
@@ -269,10 +342,28 @@ char	*handle_heredoc(char *delimiter, t_env *env_list, int exit_status)
 	if (status == ERROR)
 	{
 		cleanup_heredoc(filename);
-		free(filename);
+		ft_free(filename);
 		return (NULL);
 	}
 	
 	return (filename);
 }
 
+
+/**
+ * Handle heredoc input processing, charged to the heredoc subsystem
+ * @param shell Shell structure
+ * @param delimiter Delimiter string to end heredoc
+ * @param expand Whether to expand variables in the heredoc body
+ * @return Path to the temporary file containing heredoc content or NULL on error
+ */
+char	*handle_heredoc(t_shell *shell, char *delimiter, int expand)
+{
+	t_mem_tag	previous;
+	char		*filename;
+
+	previous = mem_scope(MEM_HEREDOC);
+	filename = fill_heredoc(shell, delimiter, expand);
+	mem_scope(previous);
+	return (filename);
+}
@@ -0,0 +1,334 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   history.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/11 13:05:18 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/11 13:05:18 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+#define SEARCH_QUERY_SIZE 256
+
+/**
+ * Get the history file path from HISTFILE or ~/.minishell_history
+ * @param shell Shell structure
+ * @return Newly allocated path, or NULL when there is no history file
+ */
+static char	*history_path(t_shell *shell)
+{
+	char	*path;
+
+	path = get_env_value(shell->env_list, "HISTFILE");
+	if (path)
+	{
+		if (!*path)
+			return (NULL);
+		return (ft_strdup(path));
+	}
+	path = get_env_value(shell->env_list, "HOME");
+	if (!path || !*path)
+		return (NULL);
+	return (ft_strjoin(path, "/.minishell_history"));
+}
+
+/**
+ * Remember the newest entry for duplicate detection
+ * @param shell Shell structure
+ * @param line Entry text
+ * @param len Length of the entry
+ */
+static void	set_last(t_shell *shell, const char *line, size_t len)
+{
+	char	*copy;
+
+	// line may point into the mapped file, which is not NUL-terminated
+	copy = (char *)ft_malloc(len + 1);
+	if (!copy)
+		return ;
+	ft_memcpy(copy, line, len);
+	copy[len] = '\0';
+	ft_free(shell->history.last);
+	shell->history.last = copy;
+}
+
+/**
+ * Check if an entry repeats the newest one
+ * @param shell Shell structure
+ * @param line Entry text
+ * @param len Length of the entry
+ * @return 1 if it is a duplicate, 0 otherwise
+ */
+static int	is_duplicate(t_shell *shell, const char *line, size_t len)
+{
+	return (shell->history.last && ft_strlen(shell->history.last) == len
+		&& ft_strncmp(shell->history.last, line, len) == 0);
+}
+
+/**
+ * Load the last entries of a mapped history file
+ * Only the tail is touched: the file is scanned backwards for the
+ * start of the last size lines, so load time does not grow with the file
+ * @param shell Shell structure
+ * @param map Mapped file contents
+ * @param len File size
+ */
+static void	load_tail(t_shell *shell, const char *map, size_t len)
+{
+	size_t	start;
+	size_t	end;
+	int		lines;
+
+	end = len;
+	if (end && map[end - 1] == '\n')
+		end--;
+	start = end;
+	lines = 0;
+	while (start > 0 && lines < shell->history.size)
+	{
+		start--;
+		if (map[start] == '\n' && ++lines == shell->history.size)
+		{
+			start++;
+			break ;
+		}
+	}
+	while (start < end)
+	{
+		len = start;
+		while (len < end && map[len] != '\n')
+			len++;
+		if (len > start && !is_duplicate(shell, map + start, len - start))
+		{
+			set_last(shell, map + start, len - start);
+			if (shell->history.last)
+			{
+				add_history(shell->history.last);
+				hist_index_add(&shell->history.index, shell->history.size,
+					shell->history.last);
+			}
+		}
+		start = len + 1;
+	}
+}
+
+/**
+ * Get or set the history searched by the readline widget
+ * Readline key handlers take no context, so the shell registers its
+ * history here when binding the widget
+ * @param history History to register, or NULL to only read
+ * @return Registered history
+ */
+static t_history	*widget_history(t_history *history)
+{
+	static t_history	*registered;
+
+	if (history)
+		registered = history;
+	return (registered);
+}
+
+/**
+ * Show the search state and the current match
+ * An empty query has not failed yet and shows the plain search prompt
+ * @param query Search text
+ * @param match Matching entry or NULL
+ * @param line Line to show when there is no match
+ */
+static void	show_search(char *query, char *match, char *line)
+{
+	if (match || !*query)
+		rl_message("(reverse-i-search)`%s': ", query);
+	else
+		rl_message("(failed reverse-i-search)`%s': ", query);
+	if (match)
+		line = match;
+	rl_replace_line(line, 0);
+	rl_point = 0;
+	if (match && ft_strstr(match, query))
+		rl_point = ft_strstr(match, query) - match;
+	rl_redisplay();
+}
+
+/**
+ * Apply a key that edits the query
+ * @param query Search text, SEARCH_QUERY_SIZE bytes
+ * @param len Length of the query, updated
+ * @param key Key read
+ * @return 1 if the key edited the query, 0 if it ends the search
+ */
+static int	edit_query(char *query, size_t *len, int key)
+{
+	if (key == 127 || key == 8)
+	{
+		if (*len)
+			query[--(*len)] = '\0';
+		return (1);
+	}
+	if (key < 32 || key >= 127)
+		return (0);
+	if (*len + 1 < SEARCH_QUERY_SIZE)
+	{
+		query[(*len)++] = (char)key;
+		query[*len] = '\0';
+	}
+	return (1);
+}
+
+/**
+ * Incremental reverse search over the trigram index, bound to C-r
+ * Typed characters refine the query, C-r steps to an older match,
+ * C-g or Escape restores the original line; any other key ends the
+ * search on the current match and is then handled by readline as usual
+ * @param count Readline repeat count (unused)
+ * @param key Key that invoked the widget (unused)
+ * @return 0
+ */
+static int	search_widget(int count, int key)
+{
+	t_hist_index	*index;
+	char			*original;
+	char			query[SEARCH_QUERY_SIZE];
+	size_t			len;
+	int				match;
+
+	(void)count;
+	if (!widget_history(NULL))
+		return (0);
+	index = &widget_history(NULL)->index;
+	original = ft_strdup(rl_line_buffer);
+	if (!original)
+		return (0);
+	len = 0;
+	query[0] = '\0';
+	match = -1;
+	rl_save_prompt();
+	while (1)
+	{
+		show_search(query, hist_index_entry(index, match), original);
+		key = rl_read_key();
+		// C-r keeps the current match when there is no older one
+		if (key == 18 && len && match >= 0
+			&& hist_index_search(index, query, match) >= 0)
+			match = hist_index_search(index, query, match);
+		else if (key == 18 && len && match < 0)
+			match = hist_index_search(index, query, index->next);
+		else if (key == 18)
+			continue ;
+		else if (!edit_query(query, &len, key))
+			break ;
+		// A changed query may still match the current entry
+		else if (!len)
+			match = -1;
+		else if (match >= 0)
+			match = hist_index_search(index, query, match + 1);
+		else
+			match = hist_index_search(index, query, index->next);
+	}
+	rl_restore_prompt();
+	rl_clear_message();
+	if (key == 7 || key == 27)
+		rl_replace_line(original, 0);
+	else
+		rl_execute_next(key);
+	ft_free(original);
+	rl_point = rl_end;
+	rl_redisplay();
+	return (0);
+}
+
+/**
+ * Open the history file and load its newest HISTSIZE entries
+ * The file stays open with O_APPEND for the rest of the session
+ * @param shell Shell structure
+ */
+void	history_init(t_shell *shell)
+{
+	struct stat	st;
+	char		*path;
+	char		*size;
+	void		*map;
+
+	shell->history.fd = -1;
+	shell->history.size = HISTSIZE_DEFAULT;
+	size = get_env_value(shell->env_list, "HISTSIZE");
+	if (size && *size && ft_atoi(size) >= 0)
+		shell->history.size = ft_atoi(size);
+	stifle_history(shell->history.size);
+	shell->history.loaded = 1;
+	widget_history(&shell->history);
+	rl_bind_key(18, search_widget);
+	path = history_path(shell);
+	if (!path)
+		return ;
+	shell->history.fd = open(path, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC,
+			0600);
+	ft_free(path);
+	if (shell->history.fd < 0 || fstat(shell->history.fd, &st) != 0
+		|| st.st_size == 0 || shell->history.size == 0)
+		return ;
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, shell->history.fd, 0);
+	if (map == MAP_FAILED)
+		return ;
+	load_tail(shell, (const char *)map, st.st_size);
+	munmap(map, st.st_size);
+}
+
+/**
+ * Add a line to the history and append it to the history file
+ * Blank lines and repeats of the previous entry are skipped. Each entry
+ * is written with a single write on an O_APPEND descriptor, so lines
+ * from concurrent shells never interleave inside an entry
+ * @param shell Shell structure
+ * @param line Line to add
+ * @return SUCCESS or ERROR
+ */
+int	history_add(t_shell *shell, char *line)
+{
+	char	*entry;
+	size_t	len;
+
+	if (!line || is_whitespace_only(line))
+		return (SUCCESS);
+	if (!shell->history.loaded)
+		history_init(shell);
+	len = ft_strlen(line);
+	if (is_duplicate(shell, line, len))
+		return (SUCCESS);
+	add_history(line);
+	hist_index_add(&shell->history.index, shell->history.size, line);
+	set_last(shell, line, len);
+	if (shell->history.fd < 0 || ft_strchr(line, '\n'))
+		return (SUCCESS);
+	entry = (char *)ft_malloc(len + 1);
+	if (!entry)
+		return (ERROR);
+	ft_memcpy(entry, line, len);
+	entry[len] = '\n';
+	if (write(shell->history.fd, entry, len + 1) != (ssize_t)(len + 1))
+	{
+		ft_free(entry);
+		return (ERROR);
+	}
+	ft_free(entry);
+	return (SUCCESS);
+}
+
+/**
+ * Close the history file and forget the newest entry
+ * @param shell Shell structure
+ */
+void	history_close(t_shell *shell)
+{
+	if (shell->history.loaded && shell->history.fd >= 0)
+		close(shell->history.fd);
+	shell->history.fd = -1;
+	ft_free(shell->history.last);
+	shell->history.last = NULL;
+	hist_index_clear(&shell->history.index);
+	shell->history.loaded = 0;
+}
@@ -0,0 +1,325 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   history_index.c                                    :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/12 10:37:52 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/12 10:37:52 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Build the key of the trigram starting at s
+ * @param s At least three bytes of text
+ * @return Trigram key
+ */
+static unsigned int	trigram_key(const char *s)
+{
+	return (((unsigned int)(unsigned char)s[0] << 16)
+		| ((unsigned int)(unsigned char)s[1] << 8)
+		| (unsigned int)(unsigned char)s[2]);
+}
+
+/**
+ * Find a trigram's posting list, optionally creating it
+ * @param index History index
+ * @param key Trigram key
+ * @param create 1 to create a missing list
+ * @return Posting list, or NULL if missing (or on allocation failure)
+ */
+static t_trigram	*find_trigram(t_hist_index *index, unsigned int key,
+	int create)
+{
+	t_trigram		*tri;
+	unsigned int	bucket;
+
+	bucket = (key * 2654435761U) % HIST_INDEX_BUCKETS;
+	tri = index->buckets[bucket];
+	while (tri && tri->key != key)
+		tri = tri->next;
+	if (tri || !create)
+		return (tri);
+	tri = (t_trigram *)ft_malloc(sizeof(t_trigram));
+	if (!tri)
+		return (NULL);
+	ft_memset(tri, 0, sizeof(t_trigram));
+	tri->key = key;
+	tri->next = index->buckets[bucket];
+	index->buckets[bucket] = tri;
+	return (tri);
+}
+
+/**
+ * Find the position of the first id >= id in a posting list
+ * @param tri Posting list
+ * @param id Id to look for
+ * @return Insertion position
+ */
+static int	lower_bound(t_trigram *tri, int id)
+{
+	int	lo;
+	int	hi;
+	int	mid;
+
+	lo = 0;
+	hi = tri->count;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if (tri->ids[mid] < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
+
+/**
+ * Append an id to a posting list
+ * @param tri Posting list
+ * @param id Entry id (never smaller than ids already present)
+ * @return SUCCESS or ERROR
+ */
+static int	posting_append(t_trigram *tri, int id)
+{
+	int		*grown;
+
+	if (tri->count && tri->ids[tri->count - 1] == id)
+		return (SUCCESS);
+	if (tri->count == tri->cap)
+	{
+		grown = (int *)ft_malloc(sizeof(int) * (tri->cap * 2 + 4));
+		if (!grown)
+			return (ERROR);
+		if (tri->ids)
+			ft_memcpy(grown, tri->ids, sizeof(int) * tri->count);
+		ft_free(tri->ids);
+		tri->ids = grown;
+		tri->cap = tri->cap * 2 + 4;
+	}
+	tri->ids[tri->count++] = id;
+	return (SUCCESS);
+}
+
+/**
+ * Remove the oldest entry's id from a trigram's posting list,
+ * freeing the list once it is empty
+ * @param index History index
+ * @param key Trigram key
+ * @param id Id of the evicted entry
+ */
+static void	posting_remove(t_hist_index *index, unsigned int key, int id)
+{
+	t_trigram	**link;
+	t_trigram	*tri;
+
+	link = &index->buckets[(key * 2654435761U) % HIST_INDEX_BUCKETS];
+	while (*link && (*link)->key != key)
+		link = &(*link)->next;
+	tri = *link;
+	// The evicted entry is the oldest, so its id can only be first
+	if (!tri || !tri->count || tri->ids[0] != id)
+		return ;
+	tri->count--;
+	ft_memcpy(tri->ids, tri->ids + 1, sizeof(int) * tri->count);
+	if (tri->count)
+		return ;
+	*link = tri->next;
+	ft_free(tri->ids);
+	ft_free(tri);
+}
+
+/**
+ * Drop the oldest entry and its postings
+ * @param index History index
+ */
+static void	evict_oldest(t_hist_index *index)
+{
+	char	*line;
+	size_t	i;
+
+	line = index->entries[index->first % index->cap];
+	i = 0;
+	while (line[i] && line[i + 1] && line[i + 2])
+	{
+		posting_remove(index, trigram_key(line + i), index->first);
+		i++;
+	}
+	ft_free(line);
+	index->first++;
+}
+
+/**
+ * Grow the entry ring, keeping every live id at id % cap
+ * @param index History index
+ * @param limit Maximum number of live entries
+ * @return SUCCESS or ERROR
+ */
+static int	grow_ring(t_hist_index *index, int limit)
+{
+	char	**grown;
+	int		cap;
+	int		id;
+
+	cap = index->cap * 2 + 64;
+	if (cap > limit)
+		cap = limit;
+	grown = (char **)ft_malloc(sizeof(char *) * cap);
+	if (!grown)
+		return (ERROR);
+	id = index->first;
+	while (id < index->next)
+	{
+		grown[id % cap] = index->entries[id % index->cap];
+		id++;
+	}
+	ft_free(index->entries);
+	index->entries = grown;
+	index->cap = cap;
+	return (SUCCESS);
+}
+
+/**
+ * Add an entry to the index, evicting the oldest one beyond limit
+ * @param index History index
+ * @param limit Maximum number of entries (HISTSIZE)
+ * @param line Entry text
+ * @return SUCCESS or ERROR
+ */
+int	hist_index_add(t_hist_index *index, int limit, char *line)
+{
+	t_trigram	*tri;
+	char		*copy;
+	size_t		i;
+
+	if (limit <= 0)
+		return (SUCCESS);
+	if (index->next - index->first == index->cap && index->cap < limit
+		&& grow_ring(index, limit) != SUCCESS)
+		return (ERROR);
+	copy = ft_strdup(line);
+	if (!copy)
+		return (ERROR);
+	if (index->next - index->first == index->cap)
+		evict_oldest(index);
+	index->entries[index->next % index->cap] = copy;
+	i = 0;
+	while (copy[i] && copy[i + 1] && copy[i + 2])
+	{
+		tri = find_trigram(index, trigram_key(copy + i), 1);
+		if (!tri || posting_append(tri, index->next) != SUCCESS)
+			return (ERROR);
+		i++;
+	}
+	index->next++;
+	return (SUCCESS);
+}
+
+/**
+ * Get the text of a live entry
+ * @param index History index
+ * @param id Entry id
+ * @return Entry text or NULL if the id is not live
+ */
+char	*hist_index_entry(t_hist_index *index, int id)
+{
+	if (id < index->first || id >= index->next)
+		return (NULL);
+	return (index->entries[id % index->cap]);
+}
+
+/**
+ * Pick the shortest posting list among the pattern's trigrams
+ * @param index History index
+ * @param pattern Search text of at least three bytes
+ * @return Posting list, or NULL if some trigram never occurs
+ */
+static t_trigram	*rarest_trigram(t_hist_index *index, char *pattern)
+{
+	t_trigram	*best;
+	t_trigram	*tri;
+	size_t		i;
+
+	best = NULL;
+	i = 0;
+	while (pattern[i + 2])
+	{
+		tri = find_trigram(index, trigram_key(pattern + i), 0);
+		if (!tri || !tri->count)
+			return (NULL);
+		if (!best || tri->count < best->count)
+			best = tri;
+		i++;
+	}
+	return (best);
+}
+
+/**
+ * Find the newest entry older than before that contains pattern
+ * Patterns of three bytes or more only look at entries in the shortest
+ * posting list of their trigrams; shorter patterns scan the entries
+ * @param index History index
+ * @param pattern Text to search for
+ * @param before Only ids smaller than this are considered
+ * @return Matching id, or -1 if there is none
+ */
+int	hist_index_search(t_hist_index *index, char *pattern, int before)
+{
+	t_trigram	*tri;
+	int			pos;
+	int			id;
+
+	if (before > index->next)
+		before = index->next;
+	if (ft_strlen(pattern) < 3)
+	{
+		while (--before >= index->first)
+		{
+			if (ft_strstr(index->entries[before % index->cap], pattern))
+				return (before);
+		}
+		return (-1);
+	}
+	tri = rarest_trigram(index, pattern);
+	if (!tri)
+		return (-1);
+	pos = lower_bound(tri, before);
+	while (--pos >= 0 && tri->ids[pos] >= index->first)
+	{
+		id = tri->ids[pos];
+		if (ft_strstr(index->entries[id % index->cap], pattern))
+			return (id);
+	}
+	return (-1);
+}
+
+/**
+ * Free all entries and posting lists
+ * @param index History index
+ */
+void	hist_index_clear(t_hist_index *index)
+{
+	t_trigram	*next;
+	int			i;
+
+	while (index->first < index->next)
+		ft_free(index->entries[index->first++ % index->cap]);
+	ft_free(index->entries);
+	i = 0;
+	while (i < HIST_INDEX_BUCKETS)
+	{
+		while (index->buckets[i])
+		{
+			next = index->buckets[i]->next;
+			ft_free(index->buckets[i]->ids);
+			ft_free(index->buckets[i]);
+			index->buckets[i] = next;
+		}
+		i++;
+	}
+	ft_memset(index, 0, sizeof(t_hist_index));
+}
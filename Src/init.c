@@ -68,33 +68,63 @@ int	verify_shell_state(t_shell *shell)
 
 /**
  * Initialize the shell structure with default values
+ * Only what every command needs is set up here, the prompt machinery is
+ * left to init_interactive so one-shot commands do not pay for it
  * @param envp Environment variables array
+ * @param profile Whether to time each init step
  * @return Initialized shell structure or NULL on error
  */
-t_shell	*init_shell(char **envp)
+t_shell	*init_shell(char **envp, int profile)
 {
 	t_shell	*shell;
 
-	shell = (t_shell *)malloc(sizeof(t_shell));
+	shell = (t_shell *)ft_malloc(sizeof(t_shell));
 	if (!shell)
 		return (NULL);
 	ft_memset(shell, 0, sizeof(t_shell));
+	profile_start(&shell->profile, profile);
 	shell->exit_status = 0;
 	shell->running = 1;
+	shell->events.fd = -1;
+	shell->signal_fd = -1;
+	signal_bind(shell);
 	if (init_shell_env(shell, envp) != SUCCESS)
 	{
-		free(shell);
+		ft_free(shell);
 		return (NULL);
 	}
-	if (init_shell_terminal(shell) != SUCCESS)
-	{
-		if (recover_terminal_error(shell) != SUCCESS)
-		{
-			free_env(shell->env_list);
-			free(shell);
-			return (NULL);
-		}
-	}
+	profile_step(&shell->profile, "env");
+	// A missing current directory is reported by pwd, not fatal here
+	cwd_init(shell);
+	profile_step(&shell->profile, "cwd");
 	return (shell);
 }
 
+/**
+ * Set up history, readline, the terminal and signal handlers the first
+ * time an interactive prompt is needed
+ * @param shell Shell structure
+ * @return SUCCESS or ERROR
+ */
+int	init_interactive(t_shell *shell)
+{
+	if (!shell)
+		return (ERROR);
+	if (shell->interactive)
+		return (SUCCESS);
+	shell->interactive = 1;
+	rl_initialize();
+	profile_step(&shell->profile, "readline");
+	history_init(shell);
+	profile_step(&shell->profile, "history");
+	if (init_shell_terminal(shell) != SUCCESS
+		&& recover_terminal_error(shell) != SUCCESS)
+		return (ERROR);
+	profile_step(&shell->profile, "terminal");
+	set_signal_mode(shell, 0);
+	profile_step(&shell->profile, "signals");
+	if (verify_shell_state(shell) != SUCCESS)
+		return (ERROR);
+	profile_step(&shell->profile, "verify");
+	return (SUCCESS);
+}
@@ -18,7 +18,7 @@
  * @return 1 if whitespace only, 0 otherwise
  */
 
-static int	is_whitespace_only(char *str)
+int	is_whitespace_only(char *str)
 {
 	int	i;
 	size_t len;
@@ -85,6 +85,8 @@ void	handle_parse_error(t_shell *shell, int error_type)
  */
 int	parse_input(char *input, t_shell *shell)
 {
+	t_mem_tag	previous;
+
 	// Validate shell state
 	if (!shell || !shell->env_list)
 	{
@@ -93,27 +95,41 @@ int	parse_input(char *input, t_shell *shell)
 		return (ERROR);
 	}
 	
+	// Reuse the parsed AST of a line we have seen before
+	shell->cached_entry = parse_cache_lookup(&shell->parse_cache, input);
+	if (shell->cached_entry)
+	{
+		shell->commands = shell->cached_entry->commands;
+		return (SUCCESS);
+	}
+	
 	// Tokenize input
+	previous = mem_scope(MEM_LEXER);
 	shell->tokens = tokenize_input(input);
+	mem_scope(previous);
 	if (!shell->tokens)
 		return (ERROR);
-		
-	// Expand variables
-	if (expand_variables(shell->tokens, shell->env_list,
-			shell->exit_status) != SUCCESS)
-	{
-		handle_parse_error(shell, ERROR);
-		return (ERROR);
-	}
 	
-	// Parse tokens into commands
+	// Parse tokens into commands, expansion happens per command at
+	// execution time so function bodies see their own positional parameters
+	previous = mem_scope(MEM_PARSER);
 	shell->commands = parse_tokens(shell->tokens, shell);
+	mem_scope(previous);
 	if (!shell->commands)
 	{
 		handle_parse_error(shell, SYNTAX_ERROR);
 		return (SYNTAX_ERROR);
 	}
 	
+	// The unexpanded AST does not depend on the environment, keep it
+	if (is_cacheable_line(shell->tokens))
+	{
+		previous = mem_scope(MEM_PARSER);
+		shell->cached_entry = parse_cache_insert(&shell->parse_cache, input,
+				shell->commands);
+		mem_scope(previous);
+	}
+	
 	return (SUCCESS);
 }
 
@@ -129,8 +145,10 @@ int	parse_input(char *input, t_shell *shell)
  */
 int	execute_input(t_shell *shell)
 {
-	int	status;
-	int	signal_status;
+	int				status;
+	int				signal_status;
+	t_parse_entry	*entry;
+	t_mem_tag		previous;
 
 	if (!shell)
 		return (ERROR);
@@ -143,8 +161,15 @@ int	execute_input(t_shell *shell)
 		write(STDERR_FILENO, "minishell: warning: signal setup error\n", 38);
 	}
 	
-	// Execute commands
+	// Execute commands, pinning a cached AST so it cannot be evicted
+	entry = shell->cached_entry;
+	if (entry)
+		entry->busy++;
+	previous = mem_scope(MEM_EXECUTOR);
 	status = execute_commands(shell->commands, shell);
+	mem_scope(previous);
+	if (entry)
+		entry->busy--;
 	
 	// Always restore signals to interactive mode, regardless of execution result
 	if (set_signal_mode(shell, 0) != SUCCESS)
@@ -153,7 +178,8 @@ int	execute_input(t_shell *shell)
 		write(STDERR_FILENO, "minishell: warning: signal restore error\n", 40);
 	}
 	
-	// Clean up command resources
+	// Clean up command resources, the line's heredoc files included
+	cleanup_all_heredocs(shell->commands);
 	cleanup_command_resources(shell);
 	
 	return (status);
@@ -180,13 +206,6 @@ int	process_input(char *input, t_shell *shell)
 		return (ERROR);
 	}
 	
-	// Add to history with error checking
-	if (handle_history(input) != SUCCESS)
-	{
-		// Non-critical error, continue processing
-		write(STDERR_FILENO, "minishell: history error\n", 25);
-	}
-	
 	// Parse and execute input
 	status = parse_input(input, shell);
 	if (status != SUCCESS)
@@ -196,3 +215,20 @@ int	process_input(char *input, t_shell *shell)
 	return (SUCCESS);
 }
 
+/**
+ * Parse and run one command line, recording its status
+ * @param shell Shell structure
+ * @param input Command line
+ * @return Status of processing the line
+ */
+int	run_command_string(t_shell *shell, char *input)
+{
+	int	status;
+
+	status = process_input(input, shell);
+	if (status == SYNTAX_ERROR)
+		shell->exit_status = 2; /* Standard syntax error exit code */
+	else if (status != SUCCESS)
+		handle_interrupted_execution(shell);
+	return (status);
+}
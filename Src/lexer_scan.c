@@ -0,0 +1,296 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   lexer_scan.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/07 11:20:44 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/07 11:20:44 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+# include <immintrin.h>
+# define SCAN_SIMD 1
+#else
+# define SCAN_SIMD 0
+#endif
+
+/* Character class table, filled on first use */
+static unsigned char	g_char_class[256];
+static int				g_char_class_ready = 0;
+
+/**
+ * Build the character class lookup table
+ */
+static void	init_char_class(void)
+{
+	int	c;
+
+	c = 0;
+	while (c < 256)
+	{
+		g_char_class[c] = 0;
+		if (c == ' ' || (c >= '\t' && c <= '\r'))
+			g_char_class[c] |= CHAR_SPACE;
+		if (c == '|' || c == '<' || c == '>' || c == ';' || c == '('
+			|| c == ')')
+			g_char_class[c] |= CHAR_OPERATOR;
+		if (c == '\'' || c == '"')
+			g_char_class[c] |= CHAR_QUOTE;
+		if (c == '$')
+			g_char_class[c] |= CHAR_DOLLAR;
+		c++;
+	}
+	g_char_class_ready = 1;
+}
+
+/**
+ * Get the lexer classes of a character
+ * @param c Character to classify
+ * @return Bitwise OR of CHAR_* classes
+ */
+int	char_class(char c)
+{
+	if (!g_char_class_ready)
+		init_char_class();
+	return (g_char_class[(unsigned char)c]);
+}
+
+/**
+ * Select the requested classes from a classified block
+ * @param block Classified block
+ * @param classes Bitwise OR of CHAR_* classes
+ * @return Bitmask of positions belonging to any requested class
+ */
+static unsigned int	select_classes(t_scan_block *block, int classes)
+{
+	unsigned int	mask;
+
+	mask = 0;
+	if (classes & CHAR_SPACE)
+		mask |= block->space;
+	if (classes & CHAR_OPERATOR)
+		mask |= block->oper;
+	if (classes & CHAR_QUOTE)
+		mask |= block->quote;
+	if (classes & CHAR_DOLLAR)
+		mask |= block->dollar;
+	return (mask);
+}
+
+#if SCAN_SIMD
+
+/**
+ * Classify 16 bytes with SSE2
+ * @param v Bytes to classify
+ * @param block Output masks, filled at bit offset shift
+ * @param shift 0 for the low half of the block, 16 for the high half
+ */
+static void	classify_sse2(__m128i v, t_scan_block *block, int shift)
+{
+	__m128i	rel;
+	__m128i	space;
+	__m128i	oper;
+	__m128i	quote;
+
+	// Whitespace is ' ' or '\t'..'\r': (c - 9) <= 4 as unsigned bytes
+	rel = _mm_sub_epi8(v, _mm_set1_epi8(9));
+	space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+			_mm_cmpeq_epi8(_mm_min_epu8(rel, _mm_set1_epi8(4)), rel));
+	oper = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('|')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8(';'))));
+	oper = _mm_or_si128(oper,
+			_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('(')),
+				_mm_cmpeq_epi8(v, _mm_set1_epi8(')'))));
+	quote = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\'')),
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+	block->space |= (unsigned int)_mm_movemask_epi8(space) << shift;
+	block->oper |= (unsigned int)_mm_movemask_epi8(oper) << shift;
+	block->quote |= (unsigned int)_mm_movemask_epi8(quote) << shift;
+	block->dollar |= (unsigned int)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(v, _mm_set1_epi8('$'))) << shift;
+	block->nul |= (unsigned int)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(v, _mm_setzero_si128())) << shift;
+}
+
+/**
+ * Classify a 32-byte block with two SSE2 loads
+ * @param p Pointer to 32 readable bytes
+ * @param block Output masks
+ */
+static void	classify_block_sse2(const char *p, t_scan_block *block)
+{
+	ft_memset(block, 0, sizeof(t_scan_block));
+	classify_sse2(_mm_loadu_si128((const __m128i *)p), block, 0);
+	classify_sse2(_mm_loadu_si128((const __m128i *)(p + 16)), block, 16);
+}
+
+/**
+ * Classify a 32-byte block with one AVX2 load
+ * @param p Pointer to 32 readable bytes
+ * @param block Output masks
+ */
+__attribute__((target("avx2")))
+static void	classify_block_avx2(const char *p, t_scan_block *block)
+{
+	__m256i	v;
+	__m256i	rel;
+	__m256i	oper;
+
+	v = _mm256_loadu_si256((const __m256i *)p);
+	rel = _mm256_sub_epi8(v, _mm256_set1_epi8(9));
+	block->space = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+				_mm256_cmpeq_epi8(_mm256_min_epu8(rel, _mm256_set1_epi8(4)),
+					rel)));
+	oper = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('|')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('<'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('>')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8(';'))));
+	oper = _mm256_or_si256(oper,
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('(')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8(')'))));
+	block->oper = (unsigned int)_mm256_movemask_epi8(oper);
+	block->quote = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\'')),
+				_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+	block->dollar = (unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')));
+	block->nul = (unsigned int)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+}
+
+/* Block classifier chosen once from the CPU features */
+static void	(*g_classify_block)(const char *, t_scan_block *) = NULL;
+
+/**
+ * Classify a 32-byte block, picking AVX2 when the CPU has it
+ * @param p Pointer to 32 readable bytes
+ * @param block Output masks, one bit per byte
+ */
+void	classify_block(const char *p, t_scan_block *block)
+{
+	if (!g_classify_block)
+	{
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			g_classify_block = classify_block_avx2;
+		else
+			g_classify_block = classify_block_sse2;
+	}
+	g_classify_block(p, block);
+}
+
+#else
+
+/**
+ * Classify 32 bytes one at a time through the class table
+ * @param p Pointer to 32 readable bytes
+ * @param block Output masks, one bit per byte
+ */
+void	classify_block(const char *p, t_scan_block *block)
+{
+	int	i;
+	int	cls;
+
+	ft_memset(block, 0, sizeof(t_scan_block));
+	i = 0;
+	while (i < 32)
+	{
+		cls = char_class(p[i]);
+		block->space |= (unsigned int)((cls & CHAR_SPACE) != 0) << i;
+		block->oper |= (unsigned int)((cls & CHAR_OPERATOR) != 0) << i;
+		block->quote |= (unsigned int)((cls & CHAR_QUOTE) != 0) << i;
+		block->dollar |= (unsigned int)((cls & CHAR_DOLLAR) != 0) << i;
+		block->nul |= (unsigned int)(p[i] == '\0') << i;
+		i++;
+	}
+}
+
+#endif
+
+/**
+ * Scan byte by byte up to the end of the string
+ * @param s String to scan
+ * @param i Start index
+ * @param len Length of the string
+ * @param classes Bitwise OR of CHAR_* classes
+ * @param negate 1 to skip over the classes instead of searching for them
+ * @return Index of the first matching position, or len
+ */
+static size_t	scan_bytes(const char *s, size_t i, size_t len, int classes,
+	int negate)
+{
+	while (i < len)
+	{
+		if (((char_class(s[i]) & classes) != 0) != negate)
+			return (i);
+		i++;
+	}
+	return (len);
+}
+
+/**
+ * Find the first position at or after i that is (or, when negate is set,
+ * is not) in one of the given classes
+ * Whole blocks are classified while they lie inside the string, the
+ * rest is scanned byte by byte, so nothing past the end is read
+ * @param s String to scan
+ * @param i Start index
+ * @param len Length of the string
+ * @param classes Bitwise OR of CHAR_* classes
+ * @param negate 1 to skip over the classes instead of searching for them
+ * @return Index of the first matching position, or len
+ */
+static size_t	scan(const char *s, size_t i, size_t len, int classes,
+	int negate)
+{
+	t_scan_block	block;
+	unsigned int	mask;
+
+	while (SCAN_SIMD && len - i >= 32)
+	{
+		classify_block(s + i, &block);
+		mask = select_classes(&block, classes);
+		if (negate)
+			mask = ~mask;
+		if (mask)
+			return (i + __builtin_ctz(mask));
+		i += 32;
+	}
+	return (scan_bytes(s, i, len, classes, negate));
+}
+
+/**
+ * Find the next character in one of the given classes
+ * @param s String to scan
+ * @param i Start index, at most len
+ * @param len Length of the string
+ * @param classes Bitwise OR of CHAR_* classes
+ * @return Index of the first such character, or of the terminating NUL
+ */
+size_t	scan_until(const char *s, size_t i, size_t len, int classes)
+{
+	return (scan(s, i, len, classes, 0));
+}
+
+/**
+ * Skip over characters in the given classes
+ * @param s String to scan
+ * @param i Start index, at most len
+ * @param len Length of the string
+ * @param classes Bitwise OR of CHAR_* classes
+ * @return Index of the first character outside the classes (or the NUL)
+ */
+size_t	scan_skip(const char *s, size_t i, size_t len, int classes)
+{
+	return (scan(s, i, len, classes, 1));
+}
@@ -0,0 +1,166 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   memory.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/02 18:17:20 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/02 18:17:20 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+#include <stddef.h>
+
+/*
+ * Every shell allocation goes through ft_malloc and ft_free. A small
+ * header in front of each block records its size and the subsystem that
+ * was active when it was allocated, so a free is charged back to the
+ * subsystem that owns the block no matter where it happens.
+ */
+
+typedef union u_mem_header
+{
+	struct
+	{
+		size_t		size;
+		t_mem_tag	tag;
+	}			info;
+	max_align_t	align;
+}	t_mem_header;
+
+typedef struct s_mem_state
+{
+	t_mem_tag	current;
+	t_mem_stats	stats[MEM_TAGS];
+	size_t		live;
+	size_t		peak;
+}	t_mem_state;
+
+/**
+ * Get the process-wide allocator state
+ * @return Allocator state
+ */
+static t_mem_state	*mem_state(void)
+{
+	static t_mem_state	state;
+
+	return (&state);
+}
+
+/**
+ * Make a subsystem the owner of the following allocations
+ * @param tag Subsystem to charge
+ * @return The previous subsystem, to be restored with mem_scope
+ */
+t_mem_tag	mem_scope(t_mem_tag tag)
+{
+	t_mem_tag	previous;
+
+	previous = mem_state()->current;
+	mem_state()->current = tag;
+	return (previous);
+}
+
+/**
+ * Allocate memory charged to the current subsystem
+ * @param size Size of memory to allocate
+ * @return Allocated memory pointer or NULL on failure
+ */
+void	*ft_malloc(size_t size)
+{
+	t_mem_state		*state;
+	t_mem_header	*header;
+	t_mem_stats		*stats;
+
+	header = NULL;
+	if (size <= (size_t)-1 - sizeof(t_mem_header))
+		header = malloc(sizeof(t_mem_header) + size);
+	if (!header)
+	{
+		perror("minishell: malloc");
+		return (NULL);
+	}
+	state = mem_state();
+	header->info.size = size;
+	header->info.tag = state->current;
+	stats = &state->stats[state->current];
+	stats->live += size;
+	stats->allocs++;
+	if (stats->live > stats->peak)
+		stats->peak = stats->live;
+	state->live += size;
+	if (state->live > state->peak)
+		state->peak = state->live;
+	return (header + 1);
+}
+
+/**
+ * Free memory from ft_malloc, charging the subsystem that allocated it
+ * @param ptr Memory to free, may be NULL
+ */
+void	ft_free(void *ptr)
+{
+	t_mem_state		*state;
+	t_mem_header	*header;
+	t_mem_stats		*stats;
+
+	if (!ptr)
+		return ;
+	state = mem_state();
+	header = (t_mem_header *)ptr - 1;
+	stats = &state->stats[header->info.tag];
+	stats->live -= header->info.size;
+	stats->frees++;
+	state->live -= header->info.size;
+	free(header);
+}
+
+/**
+ * Get the counters of one subsystem
+ * @param tag Subsystem, or MEM_TAGS for the totals
+ * @param out Counters to fill
+ */
+void	mem_stats(t_mem_tag tag, t_mem_stats *out)
+{
+	t_mem_state	*state;
+	int			i;
+
+	state = mem_state();
+	if (tag != MEM_TAGS)
+	{
+		*out = state->stats[tag];
+		return ;
+	}
+	ft_memset(out, 0, sizeof(t_mem_stats));
+	i = 0;
+	while (i < MEM_TAGS)
+	{
+		out->allocs += state->stats[i].allocs;
+		out->frees += state->stats[i].frees;
+		i++;
+	}
+	out->live = state->live;
+	out->peak = state->peak;
+}
+
+/**
+ * Reset the counters, peaks restart from the bytes still live
+ */
+void	mem_stats_reset(void)
+{
+	t_mem_state	*state;
+	int			i;
+
+	state = mem_state();
+	i = 0;
+	while (i < MEM_TAGS)
+	{
+		state->stats[i].allocs = 0;
+		state->stats[i].frees = 0;
+		state->stats[i].peak = state->stats[i].live;
+		i++;
+	}
+	state->peak = state->live;
+}
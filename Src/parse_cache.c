@@ -0,0 +1,223 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   parse_cache.c                                      :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Hash a command line (FNV-1a)
+ * @param line Line to hash
+ * @return Hash value
+ */
+unsigned long	hash_line(char *line)
+{
+	unsigned long	hash;
+
+	hash = 14695981039346656037UL;
+	while (*line)
+	{
+		hash ^= (unsigned char)*line++;
+		hash *= 1099511628211UL;
+	}
+	return (hash);
+}
+
+/**
+ * Hash a byte range (FNV-1a), as hash_line does for strings
+ * @param data Bytes to hash
+ * @param len Number of bytes
+ * @return Hash value
+ */
+unsigned long	hash_bytes(const char *data, size_t len)
+{
+	unsigned long	hash;
+
+	hash = 14695981039346656037UL;
+	while (len-- > 0)
+	{
+		hash ^= (unsigned char)*data++;
+		hash *= 1099511628211UL;
+	}
+	return (hash);
+}
+
+/**
+ * Unlink an entry from the LRU list
+ * @param cache Parse cache
+ * @param entry Entry to unlink
+ */
+static void	lru_unlink(t_parse_cache *cache, t_parse_entry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+	entry->prev = NULL;
+	entry->next = NULL;
+}
+
+/**
+ * Put an entry at the most recently used end of the LRU list
+ * @param cache Parse cache
+ * @param entry Entry to insert
+ */
+static void	lru_push_front(t_parse_cache *cache, t_parse_entry *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if (cache->head)
+		cache->head->prev = entry;
+	cache->head = entry;
+	if (!cache->tail)
+		cache->tail = entry;
+}
+
+/**
+ * Remove an entry from the cache and free it
+ * @param cache Parse cache
+ * @param entry Entry to remove
+ */
+static void	remove_entry(t_parse_cache *cache, t_parse_entry *entry)
+{
+	t_parse_entry	**link;
+
+	link = &cache->buckets[entry->hash % PARSE_CACHE_BUCKETS];
+	while (*link && *link != entry)
+		link = &(*link)->hnext;
+	if (*link)
+		*link = entry->hnext;
+	lru_unlink(cache, entry);
+	ft_free(entry->line);
+	free_commands(entry->commands);
+	ft_free(entry);
+	cache->count--;
+}
+
+/**
+ * Look up a line in the parse cache
+ * A hit moves the entry to the front of the LRU list
+ * @param cache Parse cache
+ * @param line Raw command line
+ * @return Cache entry or NULL on a miss
+ */
+t_parse_entry	*parse_cache_lookup(t_parse_cache *cache, char *line)
+{
+	t_parse_entry	*entry;
+	unsigned long	hash;
+
+	if (!cache || !line)
+		return (NULL);
+	hash = hash_line(line);
+	entry = cache->buckets[hash % PARSE_CACHE_BUCKETS];
+	while (entry)
+	{
+		if (entry->hash == hash && ft_strcmp(entry->line, line) == 0)
+		{
+			cache->hits++;
+			lru_unlink(cache, entry);
+			lru_push_front(cache, entry);
+			return (entry);
+		}
+		entry = entry->hnext;
+	}
+	cache->misses++;
+	return (NULL);
+}
+
+/**
+ * Insert a parsed line into the cache, evicting the least recently
+ * used entry that is not currently executing when the cache is full
+ * @param cache Parse cache
+ * @param line Raw command line
+ * @param commands Parsed AST, owned by the cache on success
+ * @return New cache entry or NULL if the line was not cached
+ */
+t_parse_entry	*parse_cache_insert(t_parse_cache *cache, char *line,
+	t_command *commands)
+{
+	t_parse_entry	*entry;
+	t_parse_entry	*victim;
+
+	if (!cache || !line || !commands)
+		return (NULL);
+	victim = cache->tail;
+	while (cache->count >= PARSE_CACHE_SIZE && victim)
+	{
+		if (!victim->busy)
+		{
+			remove_entry(cache, victim);
+			victim = cache->tail;
+		}
+		else
+			victim = victim->prev;
+	}
+	if (cache->count >= PARSE_CACHE_SIZE)
+		return (NULL);
+	entry = (t_parse_entry *)ft_malloc(sizeof(t_parse_entry));
+	if (!entry)
+		return (NULL);
+	entry->line = ft_strdup(line);
+	if (!entry->line)
+	{
+		ft_free(entry);
+		return (NULL);
+	}
+	entry->hash = hash_line(line);
+	entry->commands = commands;
+	entry->busy = 0;
+	entry->hnext = cache->buckets[entry->hash % PARSE_CACHE_BUCKETS];
+	cache->buckets[entry->hash % PARSE_CACHE_BUCKETS] = entry;
+	lru_push_front(cache, entry);
+	cache->count++;
+	return (entry);
+}
+
+/**
+ * Drop every cache entry that is not executing
+ * @param cache Parse cache
+ */
+void	parse_cache_clear(t_parse_cache *cache)
+{
+	t_parse_entry	*entry;
+	t_parse_entry	*prev;
+
+	if (!cache)
+		return ;
+	entry = cache->tail;
+	while (entry)
+	{
+		prev = entry->prev;
+		if (!entry->busy)
+			remove_entry(cache, entry);
+		entry = prev;
+	}
+}
+
+/**
+ * Check if a tokenized line may be cached
+ * Heredocs are read while parsing, so their lines are always re-parsed
+ * @param tokens Token list of the line
+ * @return 1 if the line can be cached, 0 otherwise
+ */
+int	is_cacheable_line(t_token *tokens)
+{
+	while (tokens)
+	{
+		if (tokens->type == TOKEN_HEREDOC)
+			return (0);
+		tokens = tokens->next;
+	}
+	return (1);
+}
@@ -23,11 +23,12 @@ static t_token	*create_token(t_token_type type, char *value)
 {
 	t_token	*token;
 
-	token = (t_token *)malloc(sizeof(t_token));
+	token = (t_token *)ft_malloc(sizeof(t_token));
 	if (!token)
 		return (NULL);
 		
 	token->type = type;
+	token->word = NULL;
 	token->next = NULL;
 	
 	// Handle value separately
@@ -36,7 +37,7 @@ static t_token	*create_token(t_token_type type, char *value)
 		token->value = ft_strdup(value);
 		if (!token->value)
 		{
-			free(token);
+			ft_free(token);
 			return (NULL);
 		}
 	}
@@ -82,8 +83,9 @@ void	free_tokens(t_token *tokens)
 	{
 		next = current->next;
 		if (current->value)
-			free(current->value);
-		free(current);
+			ft_free(current->value);
+		free_words(current->word);
+		ft_free(current);
 		current = next;
 	}
 }
@@ -95,124 +97,203 @@ void	free_tokens(t_token *tokens)
  */
 int	is_delimiter(char c)
 {
-	return (is_whitespace(c) || c == '|' || c == '<' || c == '>' || c == '\0');
+	return (c == '\0' || (char_class(c) & (CHAR_SPACE | CHAR_OPERATOR)));
 }
 
 /**
- * Parse a quoted string
+ * Check if a character starts an operator token
+ * @param c Character to check
+ * @return 1 if the character starts an operator, 0 otherwise
+ */
+static int	is_operator_char(char c)
+{
+	return ((char_class(c) & CHAR_OPERATOR) != 0);
+}
+
+/**
+ * Check if a character is a special parameter name ($?, $#, $@, $*)
+ * @param c Character to check
+ * @return 1 if special, 0 otherwise
+ */
+static int	is_special_param(char c)
+{
+	return (c == '?' || c == '#' || c == '@' || c == '*');
+}
+
+/**
+ * Check if a character can follow '$' to start a parameter
+ * @param c Character after the '$'
+ * @return 1 if it starts a parameter, 0 if the '$' is literal
+ */
+static int	is_param_start(char c)
+{
+	return (ft_isalnum(c) || c == '_' || is_special_param(c));
+}
+
+/**
+ * Parse a parameter reference starting at '$'
+ * Names are either a run of [A-Za-z0-9_] starting with a letter or '_',
+ * or a single digit or special character
+ * @param word Word to extend
  * @param input Input string
- * @param i Pointer to the current position in the input
- * @param quote Quote character (' or ")
- * @return Parsed quoted string or NULL on error
+ * @param i Pointer to the '$' in the input
+ * @param quoted Whether the parameter is inside double quotes
+ * @return SUCCESS or ERROR
  */
-static char	*parse_quoted_string(char *input, int *i, char quote)
+static int	parse_param(t_word *word, char *input, int *i, int quoted)
 {
-	char	*value;
-	int		start;
-	int		len;
+	int	start;
+	int	len;
 
-	if (!input || !i)
-		return (NULL);
-		
-	(*i)++;
-	start = *i;
-	while (input[*i] && input[*i] != quote)
-		(*i)++;
-		
-	if (!input[*i])
+	start = *i + 1;
+	len = 1;
+	if (ft_isalpha(input[start]) || input[start] == '_')
 	{
-		ft_putstr_fd("minishell: syntax error: unclosed ", STDERR_FILENO);
-		ft_putchar_fd(quote, STDERR_FILENO);
-		ft_putstr_fd(" quote\n", STDERR_FILENO);
-		return (NULL);
+		while (ft_isalnum(input[start + len]) || input[start + len] == '_')
+			len++;
 	}
-	
-	len = *i - start;
-	if (len > 4096) // Reasonable maximum for quoted string
-	{
-		ft_putstr_fd("minishell: quoted string too long\n", STDERR_FILENO);
-		return (NULL);
-	}
-	
-	value = ft_substr(input, start, len);
-	if (!value)
+	if (word_add_segment(word, SEG_PARAM, input + start, len) != SUCCESS)
+		return (ERROR);
+	word->last->quoted = quoted;
+	*i = start + len;
+	return (SUCCESS);
+}
+
+/**
+ * Report an unclosed quote
+ * @param quote Quote character
+ * @return Always ERROR
+ */
+static int	unclosed_quote(char quote)
+{
+	ft_putstr_fd("minishell: syntax error: unclosed ", STDERR_FILENO);
+	ft_putchar_fd(quote, STDERR_FILENO);
+	ft_putstr_fd(" quote\n", STDERR_FILENO);
+	return (ERROR);
+}
+
+/**
+ * Parse a single-quoted string into one SEG_SQUOTE segment
+ * @param word Word to extend
+ * @param input Input string
+ * @param i Pointer to the opening quote in the input
+ * @return SUCCESS or ERROR
+ */
+static int	parse_single_quoted(t_word *word, char *input, int *i)
+{
+	char	*end;
+	int		start;
+
+	start = *i + 1;
+	end = ft_strchr(input + start, '\'');
+	if (!end)
+		return (unclosed_quote('\''));
+	if (word_add_segment(word, SEG_SQUOTE, input + start,
+			end - (input + start)) != SUCCESS)
+		return (ERROR);
+	*i = end - input + 1;
+	return (SUCCESS);
+}
+
+/**
+ * Parse a double-quoted string into SEG_DQUOTE and quoted SEG_PARAM segments
+ * @param word Word to extend
+ * @param input Input string
+ * @param len Length of the input
+ * @param i Pointer to the opening quote in the input
+ * @return SUCCESS or ERROR
+ */
+static int	parse_double_quoted(t_word *word, char *input, int len, int *i)
+{
+	t_segment	*before;
+	int			start;
+
+	before = word->last;
+	start = ++(*i);
+	while (1)
 	{
-		ft_putstr_fd("minishell: memory allocation failed\n", STDERR_FILENO);
-		return (NULL);
+		*i = scan_until(input, *i, len, CHAR_QUOTE | CHAR_DOLLAR);
+		if (input[*i] == '\'' || (input[*i] == '$'
+				&& !is_param_start(input[*i + 1])))
+		{
+			(*i)++;
+			continue ;
+		}
+		if (input[*i] != '$')
+			break ;
+		if (*i > start && word_add_segment(word, SEG_DQUOTE, input + start,
+				*i - start) != SUCCESS)
+			return (ERROR);
+		if (parse_param(word, input, i, 1) != SUCCESS)
+			return (ERROR);
+		start = *i;
 	}
-	
+	if (!input[*i])
+		return (unclosed_quote('"'));
+	// Keep "" as an empty segment so the word still counts as quoted
+	if ((*i > start || word->last == before) && word_add_segment(word,
+			SEG_DQUOTE, input + start, *i - start) != SUCCESS)
+		return (ERROR);
 	(*i)++;
-	return (value);
+	return (SUCCESS);
 }
 
 /**
- * Parse a word token
+ * Parse a word token into segments
+ * Unquoted runs are skipped in one jump to the next delimiter, quote or '$'
  * @param input Input string
+ * @param len Length of the input
  * @param i Pointer to the current position in the input
- * @return Parsed word token or NULL on error
+ * @return Parsed word or NULL on error
  */
-static char	*parse_word(char *input, int *i)
+static t_word	*parse_word(char *input, int len, int *i)
 {
-	char	*value;
+	t_word	*word;
 	int		start;
-	int		len;
+	int		status;
 
+	word = new_word();
+	if (!word)
+		return (NULL);
+	status = SUCCESS;
 	start = *i;
-	value = NULL;
-	while (input[*i] && !is_delimiter(input[*i]))
+	while (status == SUCCESS)
 	{
-		if (input[*i] == '\'' || input[*i] == '\"')
+		*i = scan_until(input, *i, len,
+				CHAR_SPACE | CHAR_OPERATOR | CHAR_QUOTE | CHAR_DOLLAR);
+		if (input[*i] == '$' && !is_param_start(input[*i + 1]))
 		{
-			char	*quoted;
-			char	*tmp;
-			
-			len = *i - start;
-			value = ft_substr(input, start, len);
-			if (!value)
-				return (NULL);
-			
-			quoted = parse_quoted_string(input, i, input[*i - 1]);
-			if (!quoted)
-			{
-				free(value);
-				return (NULL);
-			}
-			
-			tmp = ft_strjoin(value, quoted);
-			free(value);
-			free(quoted);
-			
-			if (!tmp)
-				return (NULL);
-			
-			start = *i;
-			value = tmp;
+			(*i)++;
+			continue ;
 		}
+		if (*i > start)
+			status = word_add_segment(word, SEG_LITERAL, input + start,
+					*i - start);
+		if (status != SUCCESS)
+			break ;
+		if (input[*i] == '$')
+			status = parse_param(word, input, i, 0);
+		else if (input[*i] == '\'')
+			status = parse_single_quoted(word, input, i);
+		else if (input[*i] == '"')
+			status = parse_double_quoted(word, input, len, i);
 		else
-			(*i)++;
+			break ;
+		start = *i;
 	}
-	
-	if (*i == start)
-		return (ft_strdup(""));
-	
-	len = *i - start;
-	if (value)
+	if (status != SUCCESS)
 	{
-		char *tmp = ft_substr(input, start, len);
-		char *result = ft_strjoin(value, tmp);
-		free(value);
-		free(tmp);
-		return (result);
+		free_words(word);
+		return (NULL);
 	}
-	
-	return (ft_substr(input, start, len));
+	return (word);
 }
 
 /**
- * Parse a redirection token
+ * Parse an operator token (redirection, pipe, separator or parenthesis)
  * @param input Input string
  * @param i Pointer to the current position in the input
- * @return Token type of the redirection
+ * @return Token type of the operator
  */
 static t_token_type	parse_redirection(char *input, int *i)
 {
@@ -242,7 +323,14 @@ static t_token_type	parse_redirection(char *input, int *i)
 	}
 	else
 	{
-		type = TOKEN_PIPE;
+		if (input[*i] == ';')
+			type = TOKEN_SEMI;
+		else if (input[*i] == '(')
+			type = TOKEN_LPAREN;
+		else if (input[*i] == ')')
+			type = TOKEN_RPAREN;
+		else
+			type = TOKEN_PIPE;
 		(*i)++;
 	}
 	return (type);
@@ -258,7 +346,8 @@ t_token	*tokenize_input(char *input)
 	t_token		*tokens;
 	t_token		*new_token;
 	int			i;
-	char		*value;
+	int			len;
+	t_word		*word;
 	t_token_type	type;
 
 	if (!input)
@@ -273,29 +362,33 @@ t_token	*tokenize_input(char *input)
 	}
 	
 	tokens = NULL;
+	len = ft_strlen(input);
 	i = 0;
 	while (input[i])
 	{
-		if (is_whitespace(input[i]))
+		if (char_class(input[i]) & CHAR_SPACE)
 		{
-			i++;
+			i = scan_skip(input, i, len, CHAR_SPACE);
 			continue ;
 		}
-		else if (input[i] == '|' || input[i] == '<' || input[i] == '>')
+		else if (is_operator_char(input[i]))
 		{
 			type = parse_redirection(input, &i);
 			new_token = create_token(type, NULL);
 		}
 		else
 		{
-			value = parse_word(input, &i);
-			if (!value)
+			word = parse_word(input, len, &i);
+			if (!word)
 			{
 				free_tokens(tokens);
 				return (NULL);
 			}
-			new_token = create_token(TOKEN_WORD, value);
-			free(value);
+			new_token = create_token(TOKEN_WORD, word->text);
+			if (new_token)
+				new_token->word = word;
+			else
+				free_words(word);
 		}
 		
 		if (!new_token)
@@ -308,61 +401,138 @@ t_token	*tokenize_input(char *input)
 	return (tokens);
 }
 
+/**
+ * Get the printable form of a token for error messages
+ * @param token Token to describe
+ * @return Token text or NULL for end of input
+ */
+static char	*token_symbol(t_token *token)
+{
+	if (!token)
+		return (NULL);
+	if (token->type == TOKEN_WORD)
+		return (token->value);
+	if (token->type == TOKEN_PIPE)
+		return ("|");
+	if (token->type == TOKEN_SEMI)
+		return (";");
+	if (token->type == TOKEN_LPAREN)
+		return ("(");
+	if (token->type == TOKEN_RPAREN)
+		return (")");
+	if (token->type == TOKEN_REDIRECT_IN)
+		return ("<");
+	if (token->type == TOKEN_HEREDOC)
+		return ("<<");
+	if (token->type == TOKEN_REDIRECT_OUT)
+		return (">");
+	if (token->type == TOKEN_REDIRECT_APPEND)
+		return (">>");
+	return (NULL);
+}
+
+/**
+ * Check if a token type is a redirection operator
+ * @param type Token type to check
+ * @return 1 if it is a redirection, 0 otherwise
+ */
+static int	is_redirect_type(t_token_type type)
+{
+	return (type == TOKEN_REDIRECT_IN || type == TOKEN_REDIRECT_OUT
+		|| type == TOKEN_REDIRECT_APPEND || type == TOKEN_HEREDOC);
+}
+
+/**
+ * Check if a token is a word with the given text
+ * @param token Token to check
+ * @param value Expected word text
+ * @return 1 if the token matches, 0 otherwise
+ */
+static int	is_word(t_token *token, char *value)
+{
+	return (token && token->type == TOKEN_WORD && token->word
+		&& !token->word->quoted && ft_strcmp(token->value, value) == 0);
+}
+
 /**
  * Create a new redirection
+ * The file starts out as the unexpanded word text
  * @param type Type of the redirection
- * @param file File for the redirection
+ * @param word Target word, owned by the redirection (freed on error)
  * @return Newly created redirection
  */
-static t_redirection	*create_redirection(t_token_type type, char *file)
+t_redirection	*create_redirection(t_token_type type, t_word *word)
 {
 	t_redirection	*redirection;
 
-	redirection = (t_redirection *)malloc(sizeof(t_redirection));
+	redirection = (t_redirection *)ft_malloc(sizeof(t_redirection));
 	if (!redirection)
+	{
+		free_words(word);
 		return (NULL);
+	}
 	redirection->type = type;
-	redirection->file = ft_strdup(file);
+	redirection->word = word;
+	redirection->file = ft_strdup(word->text);
 	if (!redirection->file)
 	{
-		free(redirection);
+		free_words(word);
+		ft_free(redirection);
 		return (NULL);
 	}
 	redirection->next = NULL;
 	return (redirection);
 }
 
+/**
+ * Free a single redirection node
+ * @param redirection Redirection to free
+ */
+static void	free_redirection(t_redirection *redirection)
+{
+	if (!redirection)
+		return ;
+	free_words(redirection->word);
+	ft_free(redirection->file);
+	ft_free(redirection);
+}
+
 /**
  * Add a redirection to a command
  * @param cmd Command to add the redirection to
  * @param type Type of the redirection
- * @param file File for the redirection
+ * @param word Target word, owned by the command (freed on error)
  * @return Success or error code
  */
-static int	add_redirection(t_command *cmd, t_token_type type, char *file)
+static int	add_redirection(t_command *cmd, t_token_type type, t_word *word)
 {
 	t_redirection	*redirection;
 	t_redirection	*current;
 	int				redir_count = 0;
 
-	if (!cmd || !file)
+	if (!cmd || !word)
+	{
+		free_words(word);
 		return (ERROR);
+	}
 		
 	// Check filename length
-	if (ft_strlen(file) > 255)
+	if (ft_strlen(word->text) > 255)
 	{
 		ft_putstr_fd("minishell: filename too long\n", STDERR_FILENO);
+		free_words(word);
 		return (ERROR);
 	}
 	
 	// Check for pipe character in filename (basic validation)
-	if (ft_strchr(file, '|'))
+	if (ft_strchr(word->text, '|'))
 	{
 		ft_putstr_fd("minishell: invalid character in redirection filename\n", STDERR_FILENO);
+		free_words(word);
 		return (ERROR);
 	}
 	
-	redirection = create_redirection(type, file);
+	redirection = create_redirection(type, word);
 	if (!redirection)
 		return (ERROR);
 	
@@ -384,8 +554,7 @@ static int	add_redirection(t_command *cmd, t_token_type type, char *file)
 		if (redir_count > 16)
 		{
 			ft_putstr_fd("minishell: too many redirections\n", STDERR_FILENO);
-			free(redirection->file);
-			free(redirection);
+			free_redirection(redirection);
 			return (ERROR);
 		}
 	}
@@ -398,97 +567,70 @@ static int	add_redirection(t_command *cmd, t_token_type type, char *file)
  * Create a new command
  * @return Newly created command
  */
-static t_command	*create_command(void)
+t_command	*create_command(void)
 {
 	t_command	*cmd;
 
-	cmd = (t_command *)malloc(sizeof(t_command));
+	cmd = (t_command *)ft_malloc(sizeof(t_command));
 	if (!cmd)
 		return (NULL);
+	cmd->type = CMD_SIMPLE;
+	cmd->words = NULL;
 	cmd->args = NULL;
 	cmd->redirections = NULL;
+	cmd->func_name = NULL;
+	cmd->body = NULL;
 	cmd->next = NULL;
 	cmd->pipe_out = 0;
 	return (cmd);
 }
 
 /**
- * Add an argument to a command
+ * Add an argument word to a command
+ * The word is moved out of the token into the command
  * @param cmd Command to add the argument to
- * @param arg Argument to add
+ * @param token Word token holding the argument
  * @return Success or error code
  */
-static int	add_argument(t_command *cmd, char *arg)
+static int	add_argument(t_command *cmd, t_token *token)
 {
-	char	**new_args;
-	int		i;
+	t_word	*last;
+	int		count;
 
-	if (!cmd || !arg || !*arg)
+	if (!cmd || !token->word)
 		return (SUCCESS);
 	
 	// Check for maximum argument length
-	if (ft_strlen(arg) > 4096)
+	if (ft_strlen(token->word->text) > 4096)
 	{
 		ft_putstr_fd("minishell: argument too long\n", STDERR_FILENO);
 		return (ERROR);
 	}
 	
-	if (!cmd->args)
+	if (!cmd->words)
 	{
-		cmd->args = (char **)malloc(sizeof(char *) * 2);
-		if (!cmd->args)
-			return (ERROR);
-		cmd->args[0] = ft_strdup(arg);
-		if (!cmd->args[0])
-		{
-			free(cmd->args);
-			cmd->args = NULL;
-			return (ERROR);
-		}
-		cmd->args[1] = NULL;
+		cmd->words = token->word;
+		token->word = NULL;
 		return (SUCCESS);
 	}
 	
-	i = 0;
-	while (cmd->args[i])
-		i++;
-	
-	// Check for maximum arguments
-	if (i >= 1024)
-	{
-		ft_putstr_fd("minishell: too many arguments\n", STDERR_FILENO);
-		return (ERROR);
-	}
-	
-	new_args = (char **)malloc(sizeof(char *) * (i + 2));
-	if (!new_args)
-		return (ERROR);
-	
-	i = 0;
-	while (cmd->args[i])
+	count = 1;
+	last = cmd->words;
+	while (last->next)
 	{
-		new_args[i] = cmd->args[i];
-		i++;
+		last = last->next;
+		count++;
 	}
 	
-	new_args[i] = ft_strdup(arg);
-	if (!new_args[i])
+	// Check for maximum arguments
+	if (count >= 1024)
 	{
-		// Clean up on error
-		int j = 0;
-		while (j < i)
-		{
-			new_args[j] = NULL; // Don't free these - they're still in cmd->args
-			j++;
-		}
-		free(new_args);
+		ft_putstr_fd("minishell: too many arguments\n", STDERR_FILENO);
 		return (ERROR);
 	}
 	
-	new_args[i + 1] = NULL;
-	free(cmd->args);
-	cmd->args = new_args;
-	
+	last->next = token->word;
+	token->word = NULL;
 	return (SUCCESS);
 }
 
@@ -500,36 +642,26 @@ static int	add_argument(t_command *cmd, char *arg)
 static int	validate_syntax(t_token *tokens)
 {
 	t_token	*current;
-	int		expecting_word;
+	t_token	*prev;
 	int		pipe_count;
 
 	if (!tokens)
 		return (ERROR);
 	
 	current = tokens;
-	expecting_word = 0;
+	prev = NULL;
 	pipe_count = 0;
 	
-	// Check if first token is a pipe
-	if (current->type == TOKEN_PIPE)
-	{
-		syntax_error("|");
-		return (ERROR);
-	}
-	
 	while (current)
 	{
-		if (current->type != TOKEN_WORD && expecting_word)
+		// Pipes and separators must follow a complete command
+		if ((current->type == TOKEN_PIPE || current->type == TOKEN_SEMI)
+			&& (!prev || prev->type != TOKEN_WORD))
 		{
-			syntax_error(current->value);
+			syntax_error(token_symbol(current));
 			return (ERROR);
 		}
 		
-		if (current->type != TOKEN_WORD)
-			expecting_word = 1;
-		else if (expecting_word)
-			expecting_word = 0;
-		
 		// Validate pipe syntax
 		if (current->type == TOKEN_PIPE)
 		{
@@ -540,33 +672,36 @@ static int	validate_syntax(t_token *tokens)
 				return (ERROR);
 			}
 			
-			if (!current->next || current->next->type == TOKEN_PIPE)
+			if (!current->next || current->next->type == TOKEN_PIPE
+				|| current->next->type == TOKEN_SEMI)
 			{
-				syntax_error("|");
+				syntax_error(current->next ? token_symbol(current->next) : "|");
 				return (ERROR);
 			}
 		}
 		
-		// Additional syntax validation for redirections
-		if ((current->type == TOKEN_REDIRECT_IN || 
-			 current->type == TOKEN_REDIRECT_OUT || 
-			 current->type == TOKEN_REDIRECT_APPEND || 
-			 current->type == TOKEN_HEREDOC) && 
-			(!current->next || current->next->type != TOKEN_WORD))
+		// Redirections need a target word
+		if (is_redirect_type(current->type)
+			&& (!current->next || current->next->type != TOKEN_WORD))
+		{
+			syntax_error(token_symbol(current->next));
+			return (ERROR);
+		}
+		
+		// Parentheses only appear in function definitions: name ( )
+		if ((current->type == TOKEN_LPAREN && (!prev || prev->type != TOKEN_WORD
+				|| !current->next || current->next->type != TOKEN_RPAREN))
+			|| (current->type == TOKEN_RPAREN
+				&& (!prev || prev->type != TOKEN_LPAREN)))
 		{
-			syntax_error("newline");
+			syntax_error(token_symbol(current));
 			return (ERROR);
 		}
 		
+		prev = current;
 		current = current->next;
 	}
 	
-	if (expecting_word)
-	{
-		syntax_error(NULL);
-		return (ERROR);
-	}
-	
 	return (SUCCESS);
 }
 
@@ -578,33 +713,24 @@ static void	free_command(t_command *cmd)
 {
 	t_redirection	*current_redir;
 	t_redirection	*next_redir;
-	int				i;
 
 	if (!cmd)
 		return ;
 	
-	if (cmd->args)
-	{
-		i = 0;
-		while (cmd->args[i])
-		{
-			free(cmd->args[i]);
-			i++;
-		}
-		free(cmd->args);
-	}
+	free_words(cmd->words);
+	free_string_array(cmd->args);
 	
 	current_redir = cmd->redirections;
 	while (current_redir)
 	{
 		next_redir = current_redir->next;
-		if (current_redir->file)
-			free(current_redir->file);
-		free(current_redir);
+		free_redirection(current_redir);
 		current_redir = next_redir;
 	}
 	
-	free(cmd);
+	ft_free(cmd->func_name);
+	free_commands(cmd->body);
+	ft_free(cmd);
 }
 
 /**
@@ -626,325 +752,374 @@ void	free_commands(t_command *commands)
 }
 
 /**
- * Parse tokens into commands
- * @param tokens Token list to parse
- * @param shell Shell structure containing environment and state
- * @return Command list or NULL on error
+ * Deep copy a redirection list (word and current file)
+ * @param redirections Redirection list to copy
+ * @return Copied list, NULL for an empty list, or NULL with *error set
  */
-t_command	*parse_tokens(t_token *tokens, t_shell *shell)
+static t_redirection	*copy_redirections(t_redirection *redirections,
+	int *error)
 {
-	t_command	*commands;
-	t_command	*current_cmd;
-	t_token		*current_token;
+	t_redirection	*head;
+	t_redirection	*last;
+	t_redirection	*copy;
+	t_word			*word;
 
-	if (!tokens || validate_syntax(tokens) != SUCCESS)
-		return (NULL);
-	
-	commands = NULL;
-	current_cmd = NULL;
-	current_token = tokens;
-	
-	while (current_token)
+	head = NULL;
+	last = NULL;
+	while (redirections)
 	{
-		if (!current_cmd)
+		copy = NULL;
+		word = copy_word(redirections->word);
+		if (word)
+			copy = create_redirection(redirections->type, word);
+		if (!copy)
 		{
-			current_cmd = create_command();
-			if (!current_cmd)
-			{
-				free_commands(commands);
-				return (NULL);
-			}
-			
-			if (!commands)
-				commands = current_cmd;
-			else
-			{
-				t_command *tmp = commands;
-				while (tmp->next)
-					tmp = tmp->next;
-				tmp->next = current_cmd;
-				tmp->pipe_out = 1;
-			}
-		}
-		
-		if (current_token->type == TOKEN_WORD)
-		{
-			if (add_argument(current_cmd, current_token->value) != SUCCESS)
-			{
-				free_commands(commands);
-				return (NULL);
-			}
-		}
-		else if (current_token->type == TOKEN_PIPE)
-		{
-			current_cmd = NULL;
+			*error = 1;
+			break ;
 		}
+		if (!head)
+			head = copy;
 		else
-		{
-			t_token_type redir_type = current_token->type;
-			current_token = current_token->next;
-			
-			if (!current_token || current_token->type != TOKEN_WORD)
-			{
-				free_commands(commands);
-				return (NULL);
-			}
-			
-			// Handle heredoc specially
-			if (redir_type == TOKEN_HEREDOC)
-			{
-				// Set up heredoc signal handling
-				setup_heredoc_signals();
-				
-				char *heredoc_file = handle_heredoc(current_token->value, 
-					shell->env_list, shell->exit_status);
-				
-				// Reset signal handling for interactive mode
-				// Always restore signals, regardless of heredoc success
-				setup_signals();
-				
-				// Check if heredoc was interrupted by signal
-				if (g_received_signal)
-				{
-					shell->exit_status = 128 + g_received_signal;
-					g_received_signal = 0;
-					free_commands(commands);
-					return (NULL);
-				}
-				
-				if (!heredoc_file)
-				{
-					free_commands(commands);
-					return (NULL);
-				}
-				
-				// Add as a regular input redirection but with the temp file
-				if (add_redirection(current_cmd, TOKEN_REDIRECT_IN, heredoc_file) != SUCCESS)
-				{
-					// Always cleanup the heredoc file on error
-					cleanup_heredoc(heredoc_file);
-					free(heredoc_file);
-					free_commands(commands);
-					// Ensure signals are reset (redundant but safe)
-					setup_signals();
-					return (NULL);
-				}
-				
-				// We need to free the filename but the file itself will be cleaned up
-				// after command execution or on error
-				free(heredoc_file);
-			}
-			else if (add_redirection(current_cmd, redir_type, current_token->value) != SUCCESS)
-			{
-				free_commands(commands);
-				return (NULL);
-			}
-		}
-		
-		current_token = current_token->next;
+			last->next = copy;
+		last = copy;
+		redirections = redirections->next;
 	}
-	
-	// Basic validation of commands
-	if (commands)
+	if (*error)
 	{
-		t_command *cmd = commands;
-		while (cmd)
+		while (head)
 		{
-			// Check if any command has empty arguments after redirections
-			if (!cmd->args || !cmd->args[0])
-			{
-				if (cmd->redirections)
-				{
-					// If it has redirections, add a dummy command
-					if (add_argument(cmd, "") != SUCCESS)
-					{
-						free_commands(commands);
-						return (NULL);
-					}
-				}
-			}
-			cmd = cmd->next;
+			last = head->next;
+			free_redirection(head);
+			head = last;
 		}
 	}
-	
-	return (commands);
+	return (head);
 }
 
 /**
- * Check if a character is valid in a variable name
- * @param c Character to check
- * @return 1 if the character is valid, 0 otherwise
+ * Deep copy a command list without its expanded arguments
+ * Used to give the function table its own copy of a function body
+ * @param commands Command list to copy
+ * @return Copied command list or NULL on error
  */
-static int	is_valid_var_char(char c)
+t_command	*copy_commands(t_command *commands)
 {
-	return (ft_isalnum(c) || c == '_');
-}
+	t_command	*head;
+	t_command	*last;
+	t_command	*copy;
+	int			error;
 
-/**
- * Extract a variable name from a string
- * @param str String containing the variable name
- * @return Variable name or NULL on error
- */
-static char	*extract_var_name(char *str)
-{
-	int		i;
-	char	*var_name;
-
-	if (!str)
-		return (NULL);
-		
-	i = 0;
-	while (str[i] && is_valid_var_char(str[i]))
-		i++;
-	
-	// Limit variable name length to avoid excessive memory usage
-	if (i > 256)
+	head = NULL;
+	last = NULL;
+	error = 0;
+	while (commands && !error)
 	{
-		ft_putstr_fd("minishell: variable name too long\n", STDERR_FILENO);
-		return (NULL);
+		copy = create_command();
+		if (!copy)
+			break ;
+		if (!head)
+			head = copy;
+		else
+			last->next = copy;
+		last = copy;
+		copy->type = commands->type;
+		copy->pipe_out = commands->pipe_out;
+		copy->words = copy_words(commands->words);
+		copy->redirections = copy_redirections(commands->redirections, &error);
+		if (commands->func_name)
+			copy->func_name = ft_strdup(commands->func_name);
+		if (commands->body)
+			copy->body = copy_commands(commands->body);
+		if ((commands->words && !copy->words)
+			|| (commands->func_name && !copy->func_name)
+			|| (commands->body && !copy->body))
+			error = 1;
+		commands = commands->next;
 	}
-	
-	var_name = ft_substr(str, 0, i);
-	if (!var_name)
+	if (error || commands)
+	{
+		free_commands(head);
 		return (NULL);
-	
-	return (var_name);
+	}
+	return (head);
 }
 
 /**
- * Expand a variable in a token value
- * @param token Token to expand
- * @param var_pos Position of the variable in the token value
- * @param env_list Environment variable list
- * @param exit_status Last command exit status
+ * Handle a redirection token and its target word
+ * @param cmd Command the redirection belongs to
+ * @param cur Pointer to the current token, left on the target word
+ * @param shell Shell structure containing environment and state
  * @return Success or error code
  */
-static int	expand_var(t_token *token, int var_pos, t_env *env_list, int exit_status)
+static int	parse_redirect(t_command *cmd, t_token **cur, t_shell *shell)
 {
-	char	*before = NULL;
-	char	*var_name = NULL;
-	char	*var_value = NULL;
-	char	*after = NULL;
-	char	*result = NULL;
-	int		i;
+	t_token_type	redir_type;
+	t_word			*word;
+	char			*heredoc_file;
 
-	// Extract the part before the variable
-	before = ft_substr(token->value, 0, var_pos);
-	if (!before)
+	redir_type = (*cur)->type;
+	*cur = (*cur)->next;
+	if (!*cur || (*cur)->type != TOKEN_WORD || !(*cur)->word)
 		return (ERROR);
-	
-	// Handle special case for $?
-	if (token->value[var_pos + 1] == '?')
+	if (redir_type != TOKEN_HEREDOC)
 	{
-		var_value = ft_itoa(exit_status);
-		i = 2;
+		word = (*cur)->word;
+		(*cur)->word = NULL;
+		return (add_redirection(cmd, redir_type, word));
 	}
-	else
+	
+	// Set up heredoc signal handling
+	setup_heredoc_signals();
+	
+	// A quoted delimiter disables expansion in the heredoc body
+	heredoc_file = handle_heredoc(shell, (*cur)->value,
+		!(*cur)->word->quoted);
+	
+	// Reset signal handling for interactive mode
+	// Always restore signals, regardless of heredoc success
+	setup_signals();
+	
+	// Check if heredoc was interrupted by signal
+	if (shell->received_signal)
 	{
-		// Extract variable name
-		var_name = extract_var_name(token->value + var_pos + 1);
-		if (!var_name)
+		shell->exit_status = 128 + shell->received_signal;
+		shell->received_signal = 0;
+		if (heredoc_file)
 		{
-			free(before);
-			return (ERROR);
+			cleanup_heredoc(heredoc_file);
+			ft_free(heredoc_file);
 		}
-		
-		// Get variable value or empty string if not found
-		char *env_value = get_env_value(env_list, var_name);
-		if (!env_value)
-			var_value = ft_strdup("");
-		else
-			var_value = ft_strdup(env_value);
-		
-		i = ft_strlen(var_name) + 1;
-		free(var_name);
-		var_name = NULL;
+		return (ERROR);
 	}
 	
-	// Check if variable value retrieval failed
-	if (!var_value)
+	if (!heredoc_file)
+		return (ERROR);
+	
+	// Add as a regular input redirection but with the temp file
+	if (add_redirection(cmd, TOKEN_REDIRECT_IN,
+			word_from_text(heredoc_file)) != SUCCESS)
 	{
-		free(before);
+		// Always cleanup the heredoc file on error
+		cleanup_heredoc(heredoc_file);
+		ft_free(heredoc_file);
 		return (ERROR);
 	}
 	
-	// Extract the part after the variable
-	after = ft_strdup(token->value + var_pos + i);
-	if (!after)
+	// We need to free the filename but the file itself will be cleaned up
+	// after command execution or on error
+	ft_free(heredoc_file);
+	return (SUCCESS);
+}
+
+static t_command	*parse_list(t_token **cur, t_shell *shell, int in_group);
+
+/**
+ * Parse a function definition of the form name ( ) { list; }
+ * @param cur Pointer to the current token (the function name)
+ * @param cmd Command node to turn into a definition
+ * @param shell Shell structure containing environment and state
+ * @return Success or error code
+ */
+static int	parse_function_definition(t_token **cur, t_command *cmd,
+	t_shell *shell)
+{
+	t_token	*name;
+
+	name = *cur;
+	if (!is_valid_variable_name(name->value))
 	{
-		free(before);
-		free(var_value);
+		print_error(NULL, name->value, "not a valid identifier");
 		return (ERROR);
 	}
 	
-	// Join the parts
-	result = ft_strjoin(before, var_value);
-	free(before);
-	before = NULL;
-	free(var_value);
-	var_value = NULL;
-	
-	if (!result)
+	// validate_syntax already guaranteed the "( )" pair after the name
+	*cur = name->next->next->next;
+	if (!is_word(*cur, "{"))
 	{
-		free(after);
+		syntax_error(token_symbol(*cur));
 		return (ERROR);
 	}
+	*cur = (*cur)->next;
 	
-	// Join with the part after
-	before = ft_strjoin(result, after);
-	free(result);
-	result = NULL;
-	free(after);
-	after = NULL;
-	
-	if (!before)
+	cmd->type = CMD_FUNCDEF;
+	cmd->func_name = ft_strdup(name->value);
+	if (!cmd->func_name)
+		return (ERROR);
+	cmd->body = parse_list(cur, shell, 1);
+	if (!cmd->body)
 		return (ERROR);
 	
-	// Replace token value with expanded string
-	free(token->value);
-	token->value = before;
-	
+	// Only a separator, a pipe or the end of input may follow the body
+	if (*cur && (*cur)->type != TOKEN_SEMI && (*cur)->type != TOKEN_PIPE)
+	{
+		syntax_error(token_symbol(*cur));
+		return (ERROR);
+	}
 	return (SUCCESS);
 }
 
 /**
- * Expand variables in token values
- * @param tokens Token list to expand
- * @param env_list Environment variable list
- * @param exit_status Last command exit status
- * @return Success or error code
+ * Parse a list of pipelines separated by ';'
+ * @param cur Pointer to the current token, advanced past the list
+ * @param shell Shell structure containing environment and state
+ * @param in_group 1 when parsing a { ... } body that must end with '}'
+ * @return Command list or NULL on error
  */
-int	expand_variables(t_token *tokens, t_env *env_list, int exit_status)
+static t_command	*parse_list(t_token **cur, t_shell *shell, int in_group)
 {
-	t_token	*current;
-	int		i;
-	int		in_single_quotes;
+	t_command	*commands;
+	t_command	*current_cmd;
+	t_command	*last;
+	int			status;
 
-	current = tokens;
-	while (current)
+	commands = NULL;
+	current_cmd = NULL;
+	last = NULL;
+	while (*cur)
 	{
-		if (current->type == TOKEN_WORD)
+		if (!current_cmd)
 		{
-			i = 0;
-			in_single_quotes = 0;
+			// A closing brace in command position ends the group
+			if (in_group && is_word(*cur, "}"))
+				break ;
+			current_cmd = create_command();
+			if (!current_cmd)
+			{
+				free_commands(commands);
+				return (NULL);
+			}
+			if (!commands)
+				commands = current_cmd;
+			else
+				last->next = current_cmd;
+			last = current_cmd;
 			
-			while (current->value && current->value[i])
+			if ((*cur)->type == TOKEN_WORD && (*cur)->next
+				&& (*cur)->next->type == TOKEN_LPAREN)
 			{
-				if (current->value[i] == '\'')
-					in_single_quotes = !in_single_quotes;
-				else if (current->value[i] == '$' && !in_single_quotes
-					&& current->value[i + 1] && (is_valid_var_char(current->value[i + 1])
-					|| current->value[i + 1] == '?'))
+				if (parse_function_definition(cur, current_cmd, shell) != SUCCESS)
 				{
-					if (expand_var(current, i, env_list, exit_status) != SUCCESS)
-						return (ERROR);
-					i = -1;  // Start over since the string has changed
+					free_commands(commands);
+					return (NULL);
 				}
-				i++;
+				continue ;
 			}
 		}
-		current = current->next;
+		
+		status = SUCCESS;
+		if ((*cur)->type == TOKEN_WORD)
+			status = add_argument(current_cmd, *cur);
+		else if ((*cur)->type == TOKEN_PIPE)
+		{
+			current_cmd->pipe_out = 1;
+			current_cmd = NULL;
+		}
+		else if ((*cur)->type == TOKEN_SEMI)
+			current_cmd = NULL;
+		else if ((*cur)->type == TOKEN_LPAREN || (*cur)->type == TOKEN_RPAREN)
+		{
+			syntax_error(token_symbol(*cur));
+			status = ERROR;
+		}
+		else
+			status = parse_redirect(current_cmd, cur, shell);
+		
+		if (status != SUCCESS)
+		{
+			free_commands(commands);
+			return (NULL);
+		}
+		*cur = (*cur)->next;
 	}
 	
+	if (in_group)
+	{
+		// The group must be non-empty and properly closed
+		if (!is_word(*cur, "}") || !commands || last->pipe_out)
+		{
+			syntax_error(token_symbol(*cur));
+			free_commands(commands);
+			return (NULL);
+		}
+		*cur = (*cur)->next;
+	}
+	
+	return (commands);
+}
+
+/**
+ * Check whether a token starts a command
+ * @param prev Token before it
+ * @param before Token before prev
+ * @return 1 at the start of input, after | or ; and after a function's {
+ */
+static int	starts_command(t_token *prev, t_token *before)
+{
+	if (!prev || prev->type == TOKEN_SEMI || prev->type == TOKEN_PIPE)
+		return (1);
+	return (is_word(prev, "{") && before && before->type == TOKEN_RPAREN);
+}
+
+/**
+ * Turn < and > between [[ and ]] back into words
+ * They compare strings there and must not open or truncate files;
+ * << and >> have no meaning inside [[ and are rejected
+ * @param tokens Token list, changed in place
+ * @return Success or error code
+ */
+static int	conditional_words(t_token *tokens)
+{
+	t_token	*prev;
+	t_token	*before;
+	int		inside;
+
+	prev = NULL;
+	before = NULL;
+	inside = 0;
+	while (tokens)
+	{
+		if (!inside && is_word(tokens, "[[") && starts_command(prev, before))
+			inside = 1;
+		else if (inside && is_word(tokens, "]]"))
+			inside = 0;
+		else if (inside && (tokens->type == TOKEN_HEREDOC
+				|| tokens->type == TOKEN_REDIRECT_APPEND))
+		{
+			syntax_error(token_symbol(tokens));
+			return (ERROR);
+		}
+		else if (inside && is_redirect_type(tokens->type))
+		{
+			tokens->value = ft_strdup(token_symbol(tokens));
+			if (tokens->value)
+				tokens->word = word_from_text(tokens->value);
+			if (!tokens->word)
+				return (ERROR);
+			tokens->type = TOKEN_WORD;
+		}
+		else if (tokens->type == TOKEN_SEMI || tokens->type == TOKEN_PIPE)
+			inside = 0;
+		before = prev;
+		prev = tokens;
+		tokens = tokens->next;
+	}
 	return (SUCCESS);
-}
\ No newline at end of file
+}
+
+/**
+ * Parse tokens into commands
+ * @param tokens Token list to parse
+ * @param shell Shell structure containing environment and state
+ * @return Command list or NULL on error
+ */
+t_command	*parse_tokens(t_token *tokens, t_shell *shell)
+{
+	t_token		*current_token;
+
+	if (!tokens || conditional_words(tokens) != SUCCESS
+		|| validate_syntax(tokens) != SUCCESS)
+		return (NULL);
+	
+	current_token = tokens;
+	return (parse_list(&current_token, shell, 0));
+}
@@ -68,13 +68,13 @@ int	handle_quoted_word(char **value, char *input, int *i)
 	quoted = parse_quoted_string(input, i, quote);
 	if (!quoted)
 	{
-		free(*value);
+		ft_free(*value);
 		*value = NULL;
 		return (0);
 	}
 	tmp = ft_strjoin(*value, quoted);
-	free(*value);
-	free(quoted);
+	ft_free(*value);
+	ft_free(quoted);
 	if (!tmp)
 		return (0);
 	*value = tmp;
@@ -106,8 +106,8 @@ char	*finalize_word(char *value, char *input, int start, int end)
 	{
 		tmp = ft_substr(input, start, len);
 		result = ft_strjoin(value, tmp);
-		free(value);
-		free(tmp);
+		ft_free(value);
+		ft_free(tmp);
 		return (result);
 	}
 	return (value);
@@ -22,14 +22,14 @@ t_token	*create_token(t_token_type type, char *value)
 {
 	t_token	*token;
 
-	token = (t_token *)malloc(sizeof(t_token));
+	token = (t_token *)ft_malloc(sizeof(t_token));
 	if (!token)
 		return (NULL);
 	token->type = type;
 	token->value = ft_strdup(value);
 	if (!token->value && value)
 	{
-		free(token);
+		ft_free(token);
 		return (NULL);
 	}
 	token->next = NULL;
@@ -137,7 +137,7 @@ int	handle_word_token(char *input, int *i, t_token **tokens)
 	if (!value)
 		return (0);
 	new_token = create_token(TOKEN_WORD, value);
-	free(value);
+	ft_free(value);
 	if (!new_token || !add_token_safely(tokens, new_token))
 		return (0);
 	return (1);
@@ -0,0 +1,148 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   path_cache.c                                       :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Free every cached path
+ * @param cache Path cache
+ */
+void	path_cache_clear(t_path_cache *cache)
+{
+	t_path_entry	*entry;
+	t_path_entry	*next;
+	int				i;
+
+	i = 0;
+	while (i < PATH_CACHE_BUCKETS)
+	{
+		entry = cache->buckets[i];
+		while (entry)
+		{
+			next = entry->next;
+			ft_free(entry->name);
+			ft_free(entry->path);
+			ft_free(entry);
+			entry = next;
+		}
+		cache->buckets[i] = NULL;
+		i++;
+	}
+	ft_free(cache->path_env);
+	cache->path_env = NULL;
+}
+
+/**
+ * Drop the cache when $PATH no longer has the value it was built for
+ * @param cache Path cache
+ * @param path_env Current value of $PATH
+ * @return SUCCESS or ERROR
+ */
+static int	sync_path_env(t_path_cache *cache, char *path_env)
+{
+	if (cache->path_env && ft_strcmp(cache->path_env, path_env) == 0)
+		return (SUCCESS);
+	path_cache_clear(cache);
+	cache->path_env = ft_strdup(path_env);
+	if (!cache->path_env)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Find a cached entry, removing it if it no longer names an executable
+ * @param cache Path cache
+ * @param name Command name
+ * @return Entry or NULL
+ */
+static t_path_entry	*find_entry(t_path_cache *cache, char *name)
+{
+	t_path_entry	**link;
+	t_path_entry	*entry;
+
+	link = &cache->buckets[hash_line(name) % PATH_CACHE_BUCKETS];
+	while (*link && ft_strcmp((*link)->name, name) != 0)
+		link = &(*link)->next;
+	entry = *link;
+	if (!entry || access(entry->path, X_OK) == 0)
+		return (entry);
+	*link = entry->next;
+	ft_free(entry->name);
+	ft_free(entry->path);
+	ft_free(entry);
+	return (NULL);
+}
+
+/**
+ * Remember where a command was found, failures are not cached
+ * @param cache Path cache
+ * @param name Command name
+ * @param path Full path of the command
+ */
+static void	insert_entry(t_path_cache *cache, char *name, char *path)
+{
+	t_path_entry	*entry;
+	unsigned long	bucket;
+
+	entry = (t_path_entry *)ft_malloc(sizeof(t_path_entry));
+	if (!entry)
+		return ;
+	entry->name = ft_strdup(name);
+	entry->path = ft_strdup(path);
+	if (!entry->name || !entry->path)
+	{
+		ft_free(entry->name);
+		ft_free(entry->path);
+		ft_free(entry);
+		return ;
+	}
+	bucket = hash_line(name) % PATH_CACHE_BUCKETS;
+	entry->next = cache->buckets[bucket];
+	cache->buckets[bucket] = entry;
+}
+
+/**
+ * Resolve a command name to the path to execute
+ * Names containing a slash are used as given; other names are searched
+ * in $PATH once and then served from the cache, with one access() to
+ * confirm the cached file is still executable
+ * @param shell Shell structure
+ * @param name Command name
+ * @param err Set to an errno value when nothing is found
+ * @return Allocated path or NULL
+ */
+char	*path_cache_resolve(t_shell *shell, char *name, int *err)
+{
+	t_path_entry	*entry;
+	char			*path_env;
+	char			*path;
+
+	path_env = get_env_value(shell->env_list, "PATH");
+	if (ft_strchr(name, '/') || !path_env || !*path_env)
+		return (find_command_path(name, path_env, err));
+	stats_add(STAT_PATH_LOOKUPS, 1);
+	if (sync_path_env(&shell->path_cache, path_env) != SUCCESS)
+	{
+		*err = ENOMEM;
+		return (NULL);
+	}
+	entry = find_entry(&shell->path_cache, name);
+	if (entry)
+	{
+		stats_add(STAT_PATH_HITS, 1);
+		return (ft_strdup(entry->path));
+	}
+	path = find_command_path(name, path_env, err);
+	if (path)
+		insert_entry(&shell->path_cache, name, path);
+	return (path);
+}
@@ -0,0 +1,131 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   profile.c                                          :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/02 18:17:20 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/02 18:17:20 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Microseconds elapsed between two monotonic timestamps
+ * @param from Earlier timestamp
+ * @param to Later timestamp
+ * @return Elapsed microseconds
+ */
+static long	elapsed_usec(struct timespec *from, struct timespec *to)
+{
+	return ((to->tv_sec - from->tv_sec) * 1000000L
+		+ (to->tv_nsec - from->tv_nsec) / 1000L);
+}
+
+/**
+ * Begin timing startup, a disabled profile records nothing
+ * @param profile Profile to reset
+ * @param enabled Whether --startup-profile was given
+ */
+void	profile_start(t_profile *profile, int enabled)
+{
+	ft_memset(profile, 0, sizeof(t_profile));
+	profile->enabled = enabled;
+	if (!enabled)
+		return ;
+	clock_gettime(CLOCK_MONOTONIC, &profile->start);
+	profile->since = profile->start;
+}
+
+/**
+ * Record the time spent since the previous step under a name
+ * @param profile Startup profile
+ * @param name Step name, must outlive the profile
+ */
+void	profile_step(t_profile *profile, const char *name)
+{
+	struct timespec	now;
+
+	if (!profile->enabled || profile->count >= PROFILE_MAX_STEPS)
+		return ;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	profile->names[profile->count] = name;
+	profile->usec[profile->count] = elapsed_usec(&profile->since, &now);
+	profile->count++;
+	profile->since = now;
+}
+
+/**
+ * Append a string to a buffer
+ * @param buf Output buffer
+ * @param len Current length of the buffer
+ * @param str String to append
+ * @return New length of the buffer
+ */
+static size_t	append_str(char *buf, size_t len, const char *str)
+{
+	size_t	n;
+
+	n = ft_strlen(str);
+	ft_memcpy(buf + len, str, n);
+	return (len + n);
+}
+
+/**
+ * Append a step line "startup: <name> <ms>.<us> ms" to a buffer
+ * @param buf Output buffer
+ * @param len Current length of the buffer
+ * @param name Step name
+ * @param usec Step duration in microseconds
+ * @return New length of the buffer
+ */
+static size_t	format_step(char *buf, size_t len, const char *name, long usec)
+{
+	char	digits[24];
+	int		i;
+
+	len = append_str(buf, len, "startup: ");
+	len = append_str(buf, len, name);
+	buf[len++] = ' ';
+	i = 0;
+	while (usec > 0 || i < 5)
+	{
+		digits[i++] = '0' + usec % 10;
+		usec /= 10;
+		if (i == 3)
+			digits[i++] = '.';
+	}
+	while (i > 0)
+		buf[len++] = digits[--i];
+	len = append_str(buf, len, " ms\n");
+	return (len);
+}
+
+/**
+ * Print every recorded step and the total to stderr in one write
+ * @param profile Startup profile
+ */
+void	profile_report(t_profile *profile)
+{
+	char			buf[(PROFILE_MAX_STEPS + 1) * 80];
+	size_t			len;
+	int				i;
+	struct timespec	now;
+
+	if (!profile->enabled)
+		return ;
+	len = 0;
+	i = 0;
+	while (i < profile->count)
+	{
+		len = format_step(buf, len, profile->names[i], profile->usec[i]);
+		i++;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	len = format_step(buf, len, "total", elapsed_usec(&profile->start, &now));
+	write(STDERR_FILENO, buf, len);
+	// Report once, a later prompt setup must not print again
+	profile->enabled = 0;
+}
@@ -13,100 +13,339 @@
 #include "../Inc/minishell.h"
 
 /**
- * Get the current directory for display in prompt
- * @return Formatted directory string or NULL on error
+ * Append bytes to a prompt text, used while compiling
+ * @param text Pointer to the text, replaced by the extended text
+ * @param s Bytes to append
+ * @param n Number of bytes
+ * @return SUCCESS or ERROR
  */
-char	*get_current_dir(void)
+static int	text_append(char **text, const char *s, size_t n)
 {
-	char	cwd[4096];
-	char	*dir_name;
-	char	path_sep;
-
-#ifdef _WIN32
-	path_sep = '\\';
-#else
-	path_sep = '/';
-#endif
-
-	if (getcwd(cwd, sizeof(cwd)) == NULL)
-		return (ft_strdup("(unknown)"));
-
-	// Find the last path separator (works for both Windows and Unix)
-#ifdef _WIN32
-	// On Windows, handle both / and \ as path separators
-	dir_name = strrchr(cwd, '\\');
-	if (!dir_name)
-		dir_name = strrchr(cwd, '/');
-#else
-	dir_name = strrchr(cwd, '/');
-#endif
-
-	if (dir_name && *(dir_name + 1) != '\0')
-		return (ft_strdup(dir_name + 1));
-	else if (dir_name && *(dir_name + 1) == '\0')
-		return (ft_strdup(path_sep == '/' ? "/" : "\\"));
-	else
-		return (ft_strdup(cwd));
+	char	*tail;
+	char	*joined;
+
+	tail = ft_substr(s, 0, n);
+	if (!tail)
+		return (ERROR);
+	if (!*text)
+	{
+		*text = tail;
+		return (SUCCESS);
+	}
+	joined = ft_strjoin(*text, tail);
+	ft_free(tail);
+	if (!joined)
+		return (ERROR);
+	ft_free(*text);
+	*text = joined;
+	return (SUCCESS);
 }
 
 /**
- * Format the prompt string with directory and status
- * @param username Username from environment
- * @param dir Current directory name
- * @param status Exit status of last command
- * @return Formatted prompt string or NULL on error
+ * Append a segment to the compiled template
+ * Adjacent text is merged into one segment
+ * @param prompt Prompt state
+ * @param op Segment operation
+ * @param s Text for PROMPT_TEXT segments
+ * @param n Length of the text
+ * @return SUCCESS or ERROR
  */
-char	*format_prompt_string(char *username, char *dir, int status)
+static int	add_segment(t_prompt *prompt, t_prompt_op op, const char *s,
+	size_t n)
 {
-	char	*prompt;
-	char	*status_indicator;
-	size_t	prompt_size;
+	t_prompt_seg	*seg;
+	t_prompt_seg	**link;
 
-	if (!username || !dir)
-		return (NULL);
+	link = &prompt->segs;
+	seg = NULL;
+	while (*link)
+	{
+		seg = *link;
+		link = &(*link)->next;
+	}
+	if (op == PROMPT_TEXT && seg && seg->op == PROMPT_TEXT)
+		return (text_append(&seg->text, s, n));
+	seg = (t_prompt_seg *)ft_malloc(sizeof(t_prompt_seg));
+	if (!seg)
+		return (ERROR);
+	seg->op = op;
+	seg->text = NULL;
+	seg->next = NULL;
+	if (op == PROMPT_TEXT && text_append(&seg->text, s, n) != SUCCESS)
+	{
+		ft_free(seg);
+		return (ERROR);
+	}
+	*link = seg;
+	return (SUCCESS);
+}
 
-	if (status == 0)
-		status_indicator = "\033[32m✓\033[0m";
-	else
-		status_indicator = "\033[31m✗\033[0m";
+/**
+ * Free the compiled template
+ * @param prompt Prompt state
+ */
+static void	free_segments(t_prompt *prompt)
+{
+	t_prompt_seg	*next;
 
-	prompt_size = ft_strlen(username) + ft_strlen(dir) + 
-		ft_strlen(status_indicator) + 40;
-	prompt = ft_malloc(prompt_size);
-	if (!prompt)
-		return (NULL);
+	while (prompt->segs)
+	{
+		next = prompt->segs->next;
+		ft_free(prompt->segs->text);
+		ft_free(prompt->segs);
+		prompt->segs = next;
+	}
+	ft_free(prompt->source);
+	prompt->source = NULL;
+}
+
+/**
+ * Compile one backslash escape of the template
+ * Values that cannot change while the shell runs (\h, \H, \$) are
+ * resolved here once instead of on every render
+ * @param prompt Prompt state
+ * @param c Escape character following the backslash
+ * @return SUCCESS or ERROR
+ */
+static int	compile_escape(t_prompt *prompt, char c)
+{
+	char	host[256];
+	char	*dot;
 
-	if (snprintf(prompt, prompt_size, "\033[36m%s\033[0m:\033[34m%s\033[0m %s $ ", 
-		username, dir, status_indicator) < 0)
+	if (c == 'u')
+		return (add_segment(prompt, PROMPT_USER, NULL, 0));
+	if (c == 'w')
+		return (add_segment(prompt, PROMPT_CWD, NULL, 0));
+	if (c == 'W')
+		return (add_segment(prompt, PROMPT_CWD_BASE, NULL, 0));
+	if (c == '?')
+		return (add_segment(prompt, PROMPT_STATUS, NULL, 0));
+	if (c == 'S')
+		return (add_segment(prompt, PROMPT_STATUS_MARK, NULL, 0));
+	if (c == 'h' || c == 'H')
 	{
-		free(prompt);
-		return (NULL);
+		if (gethostname(host, sizeof(host)) != 0)
+			ft_memcpy(host, "localhost", 10);
+		host[sizeof(host) - 1] = '\0';
+		dot = ft_strchr(host, '.');
+		if (c == 'h' && dot)
+			*dot = '\0';
+		return (add_segment(prompt, PROMPT_TEXT, host, ft_strlen(host)));
+	}
+	if (c == '$' && geteuid() == 0)
+		return (add_segment(prompt, PROMPT_TEXT, "#", 1));
+	if (c == 'n')
+		return (add_segment(prompt, PROMPT_TEXT, "\n", 1));
+	if (c == 'e')
+		return (add_segment(prompt, PROMPT_TEXT, "\033", 1));
+	if (c == '[')
+		return (add_segment(prompt, PROMPT_TEXT, "\001", 1));
+	if (c == ']')
+		return (add_segment(prompt, PROMPT_TEXT, "\002", 1));
+	if (c == '$' || c == '\\')
+		return (add_segment(prompt, PROMPT_TEXT, &c, 1));
+	if (add_segment(prompt, PROMPT_TEXT, "\\", 1) != SUCCESS)
+		return (ERROR);
+	return (add_segment(prompt, PROMPT_TEXT, &c, 1));
+}
+
+/**
+ * Compile a PS1-style template into segments
+ * Supported escapes: \u \h \H \w \W \? \$ \n \e \[ \] \\ and \S, which
+ * shows a green check or a red cross for the last exit status
+ * @param prompt Prompt state
+ * @param source Template text
+ * @return SUCCESS or ERROR
+ */
+static int	compile_prompt(t_prompt *prompt, char *source)
+{
+	size_t	start;
+	size_t	i;
+
+	free_segments(prompt);
+	prompt->source = ft_strdup(source);
+	if (!prompt->source)
+		return (ERROR);
+	i = 0;
+	while (source[i])
+	{
+		start = i;
+		while (source[i] && source[i] != '\\')
+			i++;
+		if (i > start && add_segment(prompt, PROMPT_TEXT, source + start,
+				i - start) != SUCCESS)
+			return (ERROR);
+		if (!source[i])
+			break ;
+		if (!source[i + 1])
+			return (add_segment(prompt, PROMPT_TEXT, "\\", 1));
+		if (compile_escape(prompt, source[i + 1]) != SUCCESS)
+			return (ERROR);
+		i += 2;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Append bytes to the reusable render buffer
+ * @param prompt Prompt state
+ * @param s Bytes to append
+ * @param n Number of bytes
+ * @return SUCCESS or ERROR
+ */
+static int	render_append(t_prompt *prompt, const char *s, size_t n)
+{
+	char	*grown;
+	size_t	cap;
+
+	if (prompt->len + n + 1 > prompt->cap)
+	{
+		cap = prompt->cap * 2 + 64;
+		while (cap < prompt->len + n + 1)
+			cap *= 2;
+		grown = (char *)ft_malloc(cap);
+		if (!grown)
+			return (ERROR);
+		if (prompt->buf)
+			ft_memcpy(grown, prompt->buf, prompt->len);
+		ft_free(prompt->buf);
+		prompt->buf = grown;
+		prompt->cap = cap;
 	}
-	return (prompt);
+	ft_memcpy(prompt->buf + prompt->len, s, n);
+	prompt->len += n;
+	prompt->buf[prompt->len] = '\0';
+	return (SUCCESS);
 }
 
 /**
- * Create a custom prompt with username, directory, and exit status
+ * Render the working directory, abbreviating $HOME to ~ for \w
  * @param shell Shell structure
- * @return Dynamically allocated prompt string, or NULL on error
+ * @param base 1 for the last component only (\W)
+ * @return SUCCESS or ERROR
  */
-char	*create_prompt(t_shell *shell)
+static int	render_cwd(t_shell *shell, int base)
 {
-	char	*username;
-	char	*dir;
-	char	*prompt;
+	char	*cwd;
+	char	*home;
+	char	*name;
+	size_t	home_len;
 
-	username = get_env_value(shell->env_list, "USER");
-	if (!username)
-		username = "user";
-	dir = get_current_dir();
-	if (!dir)
-		return (ft_strdup("minishell$ "));
-	prompt = format_prompt_string(username, dir, shell->exit_status);
-	free(dir);
-	if (!prompt)
-		return (ft_strdup("minishell$ "));
-	return (prompt);
+	cwd = cwd_logical(shell);
+	if (!cwd)
+		return (render_append(&shell->prompt, "(unknown)", 9));
+	home = get_env_value(shell->env_list, "HOME");
+	home_len = 0;
+	if (home && *home && ft_strncmp(cwd, home, ft_strlen(home)) == 0
+		&& (cwd[ft_strlen(home)] == '/' || !cwd[ft_strlen(home)]))
+		home_len = ft_strlen(home);
+	if (base)
+	{
+		name = ft_strrchr(cwd, '/');
+		if (name && name[1])
+			cwd = name + 1;
+		return (render_append(&shell->prompt, cwd, ft_strlen(cwd)));
+	}
+	if (home_len && render_append(&shell->prompt, "~", 1) != SUCCESS)
+		return (ERROR);
+	return (render_append(&shell->prompt, cwd + home_len,
+			ft_strlen(cwd + home_len)));
+}
+
+/**
+ * Render one dynamic segment
+ * @param shell Shell structure
+ * @param seg Segment to render
+ * @return SUCCESS or ERROR
+ */
+static int	render_segment(t_shell *shell, t_prompt_seg *seg)
+{
+	char	status[12];
+	char	*text;
+
+	if (seg->op == PROMPT_TEXT)
+		return (render_append(&shell->prompt, seg->text,
+				ft_strlen(seg->text)));
+	if (seg->op == PROMPT_USER)
+	{
+		text = get_env_value(shell->env_list, "USER");
+		if (!text)
+			text = "user";
+		return (render_append(&shell->prompt, text, ft_strlen(text)));
+	}
+	if (seg->op == PROMPT_STATUS)
+	{
+		snprintf(status, sizeof(status), "%d", shell->exit_status);
+		return (render_append(&shell->prompt, status, ft_strlen(status)));
+	}
+	if (seg->op == PROMPT_STATUS_MARK)
+	{
+		text = "\001\033[31m\002✗\001\033[0m\002";
+		if (shell->exit_status == 0)
+			text = "\001\033[32m\002✓\001\033[0m\002";
+		return (render_append(&shell->prompt, text, ft_strlen(text)));
+	}
+	return (render_cwd(shell, seg->op == PROMPT_CWD_BASE));
+}
+
+/**
+ * Get the prompt, rendering it only when one of its inputs changed
+ * The template comes from $PS1 (DEFAULT_PS1 when unset) and is compiled
+ * again only when $PS1 itself changes
+ * @param shell Shell structure
+ * @return Prompt string owned by the shell (never NULL)
+ */
+char	*prompt_render(t_shell *shell)
+{
+	t_prompt		*prompt;
+	t_prompt_seg	*seg;
+	char			*source;
+
+	prompt = &shell->prompt;
+	if (prompt->valid && prompt->env_gen == env_generation(0)
+		&& prompt->cwd_gen == shell->cwd.generation
+		&& prompt->status == shell->exit_status)
+	{
+		prompt->reuses++;
+		return (prompt->buf);
+	}
+	prompt->valid = 0;
+	source = get_env_value(shell->env_list, "PS1");
+	if (!source)
+		source = DEFAULT_PS1;
+	if ((!prompt->source || ft_strcmp(prompt->source, source) != 0)
+		&& compile_prompt(prompt, source) != SUCCESS)
+	{
+		free_segments(prompt);
+		return ("minishell$ ");
+	}
+	prompt->len = 0;
+	seg = prompt->segs;
+	while (seg)
+	{
+		if (render_segment(shell, seg) != SUCCESS)
+			return ("minishell$ ");
+		seg = seg->next;
+	}
+	if (!prompt->buf && render_append(prompt, "", 0) != SUCCESS)
+		return ("minishell$ ");
+	prompt->env_gen = env_generation(0);
+	prompt->cwd_gen = shell->cwd.generation;
+	prompt->status = shell->exit_status;
+	prompt->valid = 1;
+	prompt->renders++;
+	return (prompt->buf);
+}
+
+/**
+ * Free the compiled template and render buffer
+ * @param prompt Prompt state
+ */
+void	prompt_free(t_prompt *prompt)
+{
+	free_segments(prompt);
+	ft_free(prompt->buf);
+	ft_memset(prompt, 0, sizeof(t_prompt));
 }
 
 /**
@@ -117,39 +356,44 @@ char	*create_prompt(t_shell *shell)
 char	*get_shell_input(t_shell *shell)
 {
 	char	*prompt;
+	char	*line;
 	char	*input;
 
 	if (!shell)
 		return (NULL);
 
-	// Try to create a custom prompt first
-	prompt = create_prompt(shell);
-	
-	// Fall back to default prompt if custom one fails
-	if (!prompt)
-	{
-		prompt = ft_strdup("minishell$ ");
-		if (!prompt)
-			return (NULL);
-	}
+	// Reuses the last rendering unless an input of the prompt changed
+	prompt = prompt_render(shell);
 	
 	// Set up signal handlers for interactive mode
 	set_signal_mode(shell, 0);
 	
+	// The shell is about to idle, write out queued output and events
+	builtin_flush();
+	event_log_flush(shell);
+	
+	// Replace the zygotes used by the last line before the user is back
+	zygote_refill(shell);
+	
 	// Read input from user
-	input = readline(prompt);
-	free(prompt);
+	line = readline(prompt);
 	
 	// Handle EOF (Ctrl+D)
-	if (!input)
+	if (!line)
 	{
 		ft_putendl_fd("exit", STDOUT_FILENO);
 		shell->running = 0;
 		return (NULL);
 	}
 	
+	// Readline allocates with malloc, hand out a tracked copy
+	input = ft_strdup(line);
+	free(line);
+	if (!input)
+		return (NULL);
+	
 	// Add valid input to history
-	handle_history(input);
+	history_add(shell, input);
 	
 	return (input);
 }
@@ -0,0 +1,511 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   rcfile.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * Startup file: $MINISHELLRC, or ~/.minishellrc when that is unset, runs
+ * line by line before the first command. Its parsed AST is kept in
+ * <rcfile>.cache as one record per line:
+ *
+ *   u8 RC_AST   command list (see ast_cache.c)
+ *   u8 RC_TEXT  string, for lines that must be parsed when they run
+ *               (heredocs read their body at parse time, syntax errors
+ *               are reported when reached)
+ *
+ * followed by u32 count and the heredoc body lines the record took from
+ * the rc file, which are handed back to it on replay instead of being
+ * read from stdin.
+ *
+ * A cache is used when its header matches this build and the rc file's
+ * size and mtime; a touched but unchanged file is recognised by its
+ * content hash. Otherwise the rc file is parsed as it runs and the cache
+ * is rewritten through a temporary file and rename().
+ */
+
+#define RC_MAGIC "MSHRCAST"
+#define RC_VERSION 2
+#define RC_ORDER 0x01020304u
+#define RC_AST 0
+#define RC_TEXT 1
+
+typedef struct s_rc_header
+{
+	char			magic[8];
+	unsigned int	version;
+	unsigned int	order;
+	long			mtime_sec;
+	long			mtime_nsec;
+	long			size;
+	unsigned long	hash;
+	unsigned long	body_len;
+	unsigned long	body_hash;
+}	t_rc_header;
+
+/* Rc file being parsed; body lines taken by heredocs are kept in bodies */
+typedef struct s_rc_text
+{
+	char			*data;
+	size_t			pos;
+	size_t			size;
+	t_ast_buf		bodies;
+	unsigned int	count;
+}	t_rc_text;
+
+/* Body lines of one cached record still to be handed out */
+typedef struct s_rc_bodies
+{
+	t_ast_reader	*in;
+	unsigned int	left;
+}	t_rc_bodies;
+
+/**
+ * Get the rc file path from MINISHELLRC or ~/.minishellrc
+ * @param shell Shell structure
+ * @return Newly allocated path, or NULL when there is no rc file
+ */
+static char	*rc_path(t_shell *shell)
+{
+	char	*path;
+
+	path = get_env_value(shell->env_list, "MINISHELLRC");
+	if (path)
+	{
+		if (!*path)
+			return (NULL);
+		return (ft_strdup(path));
+	}
+	path = get_env_value(shell->env_list, "HOME");
+	if (!path || !*path)
+		return (NULL);
+	return (ft_strjoin(path, "/.minishellrc"));
+}
+
+/**
+ * Check whether a line has nothing to run
+ * @param line Line of the rc file
+ * @return 1 for blank lines and lines starting with #
+ */
+static int	is_comment_line(char *line)
+{
+	int	i;
+
+	if (is_whitespace_only(line))
+		return (1);
+	i = 0;
+	while (line[i] == ' ' || line[i] == '\t')
+		i++;
+	return (line[i] == '#');
+}
+
+/**
+ * Read the whole rc file
+ * @param fd Open rc file
+ * @param size Size reported by fstat
+ * @return NUL-terminated contents, NULL on error or if the size changed
+ */
+static char	*rc_read(int fd, size_t size)
+{
+	char	*data;
+	size_t	len;
+	ssize_t	n;
+
+	data = ft_malloc(size + 1);
+	if (!data)
+		return (NULL);
+	len = 0;
+	n = 1;
+	while (len < size && n > 0)
+	{
+		n = pread(fd, data + len, size - len, len);
+		if (n < 0 && errno == EINTR)
+			n = 1;
+		else if (n > 0)
+			len += n;
+	}
+	if (len != size)
+	{
+		ft_free(data);
+		return (NULL);
+	}
+	data[len] = '\0';
+	return (data);
+}
+
+/**
+ * Check a cache header against this build and the rc file
+ * An unchanged file with a new mtime is accepted and the header is
+ * brought up to date, so the hash is only computed once
+ * @param hdr Header of the mapped cache
+ * @param st Status of the rc file
+ * @param fd Open rc file
+ * @param cache Cache path
+ * @return 1 if the cache can be used
+ */
+static int	rc_fresh(t_rc_header *hdr, struct stat *st, int fd, char *cache)
+{
+	char	*data;
+	int		same;
+	int		cfd;
+
+	if (ft_strncmp(hdr->magic, RC_MAGIC, 8) != 0 || hdr->version != RC_VERSION
+		|| hdr->order != RC_ORDER || hdr->size != st->st_size)
+		return (0);
+	if (hdr->mtime_sec == st->st_mtim.tv_sec
+		&& hdr->mtime_nsec == st->st_mtim.tv_nsec)
+		return (1);
+	data = rc_read(fd, st->st_size);
+	same = data && hash_bytes(data, st->st_size) == hdr->hash;
+	ft_free(data);
+	if (!same)
+		return (0);
+	hdr->mtime_sec = st->st_mtim.tv_sec;
+	hdr->mtime_nsec = st->st_mtim.tv_nsec;
+	cfd = open(cache, O_WRONLY | O_NOFOLLOW | O_CLOEXEC);
+	if (cfd >= 0)
+	{
+		pwrite(cfd, hdr, sizeof(t_rc_header), 0);
+		close(cfd);
+	}
+	return (1);
+}
+
+/**
+ * Supply a heredoc body line recorded in the cache
+ * @param ctx Body lines of the running record
+ * @return Tracked line, NULL once the record has none left
+ */
+static char	*rc_cached_body(void *ctx)
+{
+	t_rc_bodies	*bodies;
+
+	bodies = ctx;
+	if (bodies->left == 0)
+		return (NULL);
+	bodies->left--;
+	return (ast_get_string(bodies->in));
+}
+
+/**
+ * Run one record of a cache
+ * The record's body lines follow it, so the reader sits on them while
+ * the record is parsed and runs; any it did not take are skipped
+ * @param shell Shell structure
+ * @param in Reader positioned after the record kind
+ * @param kind Record kind
+ * @param lines Line source heredocs read from while the record runs
+ */
+static void	rc_replay_record(t_shell *shell, t_ast_reader *in,
+	unsigned char kind, t_line_source *lines)
+{
+	t_rc_bodies	bodies;
+	char		*line;
+
+	line = NULL;
+	if (kind == RC_TEXT)
+		line = ast_get_string(in);
+	else if (kind == RC_AST)
+		shell->commands = ast_get_commands(in);
+	else
+		in->failed = 1;
+	bodies.in = in;
+	bodies.left = ast_get_u32(in);
+	lines->ctx = &bodies;
+	if (line && !in->failed)
+		run_command_string(shell, line);
+	else if (shell->commands && !in->failed)
+		shell->exit_status = execute_input(shell);
+	else if (shell->commands)
+		cleanup_command_resources(shell);
+	ft_free(line);
+	while (bodies.left > 0 && !in->failed)
+		ft_free(rc_cached_body(&bodies));
+}
+
+/**
+ * Run the records of a cache
+ * @param shell Shell structure
+ * @param in Reader over the records
+ */
+static void	rc_replay(t_shell *shell, t_ast_reader *in)
+{
+	t_line_source	lines;
+	t_line_source	*outer;
+	unsigned char	kind;
+
+	outer = shell->line_source;
+	lines.next = rc_cached_body;
+	shell->line_source = &lines;
+	while (in->left > 0 && shell->running
+		&& ast_get(in, &kind, 1) == SUCCESS)
+		rc_replay_record(shell, in, kind, &lines);
+	shell->line_source = outer;
+}
+
+/**
+ * Run the rc file from its cache when the cache is fresh
+ * The cache is mapped once and checked against its own hash before any
+ * of it runs
+ * @param shell Shell structure
+ * @param cache Cache path
+ * @param fd Open rc file
+ * @param st Status of the rc file
+ * @return SUCCESS if the rc file ran, ERROR if it must be parsed
+ */
+static int	rc_run_cache(t_shell *shell, char *cache, int fd, struct stat *st)
+{
+	t_rc_header		hdr;
+	t_ast_reader	in;
+	struct stat		cst;
+	char			*map;
+	int				cfd;
+
+	cfd = open(cache, O_RDONLY | O_CLOEXEC);
+	if (cfd < 0)
+		return (ERROR);
+	map = MAP_FAILED;
+	if (fstat(cfd, &cst) == 0 && S_ISREG(cst.st_mode)
+		&& cst.st_size >= (off_t) sizeof(t_rc_header))
+		map = mmap(NULL, cst.st_size, PROT_READ, MAP_PRIVATE, cfd, 0);
+	close(cfd);
+	if (map == MAP_FAILED)
+		return (ERROR);
+	ft_memcpy(&hdr, map, sizeof(t_rc_header));
+	in.p = map + sizeof(t_rc_header);
+	in.left = cst.st_size - sizeof(t_rc_header);
+	in.failed = 0;
+	if (hdr.body_len != in.left || hash_bytes(in.p, in.left) != hdr.body_hash
+		|| !rc_fresh(&hdr, st, fd, cache))
+	{
+		munmap(map, cst.st_size);
+		return (ERROR);
+	}
+	rc_replay(shell, &in);
+	munmap(map, cst.st_size);
+	return (SUCCESS);
+}
+
+/**
+ * Take the next line of the rc file being parsed
+ * @param rc Rc file
+ * @return The line, terminated in place, NULL at the end of the file
+ */
+static char	*rc_next_line(t_rc_text *rc)
+{
+	char	*line;
+	char	*nl;
+
+	if (rc->pos >= rc->size)
+		return (NULL);
+	line = rc->data + rc->pos;
+	nl = ft_memchr(line, '\n', rc->size - rc->pos);
+	if (nl)
+		*nl = '\0';
+	else
+		nl = rc->data + rc->size;
+	rc->pos = nl + 1 - rc->data;
+	return (line);
+}
+
+/**
+ * Supply a heredoc body line from the rc file, recording it for the cache
+ * @param ctx Rc file
+ * @return Tracked copy of the line, NULL at the end of the file
+ */
+static char	*rc_build_body(void *ctx)
+{
+	t_rc_text	*rc;
+	char		*line;
+
+	rc = ctx;
+	line = rc_next_line(rc);
+	if (!line)
+		return (NULL);
+	ast_put_string(&rc->bodies, line);
+	rc->count++;
+	return (ft_strdup(line));
+}
+
+/**
+ * Parse and run one rc line, recording it for the cache
+ * Mirrors run_command_string, with the parsed AST encoded between
+ * parsing and execution
+ * @param shell Shell structure
+ * @param buf Cache being built
+ * @param rc Rc file, collecting the body lines the line takes
+ * @param line Line to run
+ */
+static void	rc_build_line(t_shell *shell, t_ast_buf *buf, t_rc_text *rc,
+	char *line)
+{
+	unsigned char	kind;
+	int				status;
+	int				too_long;
+
+	kind = RC_TEXT;
+	rc->bodies.len = 0;
+	rc->count = 0;
+	too_long = ft_strlen(line) > 10000;
+	status = ERROR;
+	if (!too_long)
+		status = parse_input(line, shell);
+	if (status == SUCCESS
+		&& (!shell->tokens || is_cacheable_line(shell->tokens)))
+		kind = RC_AST;
+	ast_put(buf, &kind, 1);
+	if (kind == RC_AST)
+		ast_put_commands(buf, shell->commands);
+	else
+		ast_put_string(buf, line);
+	if (too_long)
+		run_command_string(shell, line);
+	else if (status == SUCCESS)
+		shell->exit_status = execute_input(shell);
+	else if (status == SYNTAX_ERROR)
+		shell->exit_status = 2;
+	else
+		handle_interrupted_execution(shell);
+	ast_put_u32(buf, rc->count);
+	ast_put(buf, rc->bodies.data, rc->bodies.len);
+	if (rc->bodies.failed)
+		buf->failed = 1;
+}
+
+/**
+ * Write a built cache next to the rc file
+ * @param cache Cache path
+ * @param buf Header followed by the records
+ */
+static void	rc_write_cache(char *cache, t_ast_buf *buf)
+{
+	char	*pid;
+	char	*base;
+	char	*tmp;
+	size_t	off;
+	ssize_t	n;
+	int		fd;
+
+	// The pid suffix keeps concurrent shells off each other's file
+	pid = ft_itoa(getpid());
+	base = ft_strjoin(cache, ".");
+	tmp = NULL;
+	if (pid && base)
+		tmp = ft_strjoin(base, pid);
+	ft_free(pid);
+	ft_free(base);
+	fd = -1;
+	if (tmp)
+	{
+		// A file left by a dead shell with this pid is replaced, but
+		// anything that reappears in its place, or a link, is not used
+		unlink(tmp);
+		fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+				0600);
+	}
+	off = 0;
+	n = 1;
+	while (fd >= 0 && off < buf->len && (n > 0 || errno == EINTR))
+	{
+		n = write(fd, buf->data + off, buf->len - off);
+		if (n > 0)
+			off += n;
+	}
+	if (fd >= 0 && (close(fd) != 0 || off != buf->len
+			|| rename(tmp, cache) != 0))
+		unlink(tmp);
+	ft_free(tmp);
+}
+
+/**
+ * Parse and run the rc file, then save its cache
+ * Nothing is saved when an exit stops the file early, since the rest of
+ * it was never parsed
+ * @param shell Shell structure
+ * @param cache Cache path
+ * @param fd Open rc file
+ * @param st Status of the rc file
+ */
+static void	rc_build(t_shell *shell, char *cache, int fd, struct stat *st)
+{
+	t_rc_header		hdr;
+	t_ast_buf		buf;
+	t_rc_text		rc;
+	t_line_source	lines;
+	t_line_source	*outer;
+	char			*line;
+
+	ft_memset(&rc, 0, sizeof(t_rc_text));
+	rc.data = rc_read(fd, st->st_size);
+	if (!rc.data)
+		return ;
+	rc.size = st->st_size;
+	ft_memset(&hdr, 0, sizeof(t_rc_header));
+	ft_memcpy(hdr.magic, RC_MAGIC, 8);
+	hdr.version = RC_VERSION;
+	hdr.order = RC_ORDER;
+	hdr.mtime_sec = st->st_mtim.tv_sec;
+	hdr.mtime_nsec = st->st_mtim.tv_nsec;
+	hdr.size = st->st_size;
+	hdr.hash = hash_bytes(rc.data, st->st_size);
+	ft_memset(&buf, 0, sizeof(t_ast_buf));
+	ast_put(&buf, &hdr, sizeof(t_rc_header));
+	// Heredocs take their bodies from the rc file, not stdin
+	lines.next = rc_build_body;
+	lines.ctx = &rc;
+	outer = shell->line_source;
+	shell->line_source = &lines;
+	line = rc_next_line(&rc);
+	while (line && shell->running)
+	{
+		if (!is_comment_line(line))
+			rc_build_line(shell, &buf, &rc, line);
+		line = rc_next_line(&rc);
+	}
+	shell->line_source = outer;
+	if (shell->running && !buf.failed)
+	{
+		hdr.body_len = buf.len - sizeof(t_rc_header);
+		hdr.body_hash = hash_bytes(buf.data + sizeof(t_rc_header),
+				hdr.body_len);
+		ft_memcpy(buf.data, &hdr, sizeof(t_rc_header));
+		rc_write_cache(cache, &buf);
+	}
+	ft_free(buf.data);
+	ft_free(rc.bodies.data);
+	ft_free(rc.data);
+}
+
+/**
+ * Run the startup file, from its AST cache when it is fresh
+ * A missing rc file is not an error
+ * @param shell Shell structure
+ */
+void	rc_load(t_shell *shell)
+{
+	struct stat	st;
+	char		*path;
+	char		*cache;
+	int			fd;
+
+	path = rc_path(shell);
+	if (!path)
+		return ;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	cache = ft_strjoin(path, ".cache");
+	ft_free(path);
+	if (fd >= 0 && cache && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+		&& rc_run_cache(shell, cache, fd, &st) != SUCCESS)
+		rc_build(shell, cache, fd, &st);
+	if (fd >= 0)
+		close(fd);
+	ft_free(cache);
+}
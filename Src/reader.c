@@ -0,0 +1,173 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   reader.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/02 18:17:20 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/02 18:17:20 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+#define READ_CHUNK 4096
+
+/*
+ * Line input without readline, used when stdin is not a terminal.
+ *
+ * The descriptor is shared with every command the script runs and with
+ * heredoc bodies, so a line read must never consume bytes past its own
+ * newline. Seekable input is read in chunks and the offset is moved back
+ * to just after the newline; pipes are read one byte at a time.
+ */
+
+/**
+ * Grow a line buffer so it can hold at least need bytes
+ * @param line Line buffer
+ * @param cap Current capacity, updated on growth
+ * @param need Required capacity
+ * @return The possibly moved buffer or NULL on allocation failure
+ */
+static char	*grow_line(char *line, size_t *cap, size_t need)
+{
+	char	*grown;
+	size_t	new_cap;
+
+	if (need <= *cap)
+		return (line);
+	new_cap = *cap * 2;
+	if (new_cap < need)
+		new_cap = need;
+	grown = ft_malloc(new_cap);
+	if (!grown)
+	{
+		ft_free(line);
+		return (NULL);
+	}
+	if (line)
+		ft_memcpy(grown, line, *cap);
+	ft_free(line);
+	*cap = new_cap;
+	return (grown);
+}
+
+/**
+ * Finish a line, a line cut short by EOF is returned as is
+ * @param line Line buffer
+ * @param len Length of the line
+ * @param got Whether anything was read at all
+ * @return The line or NULL at EOF
+ */
+static char	*finish_line(char *line, size_t len, int got)
+{
+	if (!got)
+	{
+		ft_free(line);
+		return (NULL);
+	}
+	line[len] = '\0';
+	return (line);
+}
+
+/**
+ * Read a line from a seekable descriptor in chunks
+ * @param fd File descriptor
+ * @return Line without its newline or NULL at EOF
+ */
+static char	*read_line_seekable(int fd)
+{
+	char	*line;
+	size_t	len;
+	size_t	cap;
+	ssize_t	n;
+	char	*nl;
+
+	line = NULL;
+	len = 0;
+	cap = 0;
+	while (1)
+	{
+		line = grow_line(line, &cap, len + READ_CHUNK + 1);
+		if (!line)
+			return (NULL);
+		n = read(fd, line + len, READ_CHUNK);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			return (finish_line(line, len, len > 0));
+		nl = ft_memchr(line + len, '\n', n);
+		if (nl)
+		{
+			// Give the bytes after the newline back to the descriptor
+			lseek(fd, -(off_t)((line + len + n) - (nl + 1)), SEEK_CUR);
+			return (finish_line(line, nl - line, 1));
+		}
+		len += n;
+	}
+}
+
+/**
+ * Read a line from a pipe one byte at a time
+ * @param fd File descriptor
+ * @return Line without its newline or NULL at EOF
+ */
+static char	*read_line_bytes(int fd)
+{
+	char	*line;
+	size_t	len;
+	size_t	cap;
+	ssize_t	n;
+	int		got;
+
+	line = NULL;
+	len = 0;
+	cap = 0;
+	got = 0;
+	while (1)
+	{
+		line = grow_line(line, &cap, len + 2);
+		if (!line)
+			return (NULL);
+		n = read(fd, line + len, 1);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			return (finish_line(line, len, got));
+		got = 1;
+		if (line[len] == '\n')
+			return (finish_line(line, len, 1));
+		len++;
+	}
+}
+
+/**
+ * Read one line from a descriptor without reading past its newline
+ * @param fd File descriptor
+ * @return Allocated line without its newline or NULL at EOF or error
+ */
+char	*read_line_fd(int fd)
+{
+	if (lseek(fd, 0, SEEK_CUR) >= 0)
+		return (read_line_seekable(fd));
+	return (read_line_bytes(fd));
+}
+
+/**
+ * Run commands read from stdin until EOF, without prompts or history
+ * @param shell Shell structure
+ */
+void	run_noninteractive(t_shell *shell)
+{
+	char	*input;
+
+	while (shell->running)
+	{
+		input = read_line_fd(STDIN_FILENO);
+		if (!input)
+			break ;
+		run_command_string(shell, input);
+		ft_free(input);
+	}
+}
@@ -0,0 +1,463 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   server.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+#include <stdint.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * minishell --serve PATH keeps one initialized shell resident and runs
+ * command lines for clients connecting to the Unix socket at PATH.
+ *
+ * A request is a 4-byte length in host byte order followed by that many
+ * bytes of payload: the command line, then optional KEY=VALUE overlay
+ * assignments, each field terminated by a NUL byte. The message carrying
+ * the length must also carry the client's stdin, stdout and stderr as
+ * SCM_RIGHTS. The reply is the exit status as a 4-byte int.
+ *
+ * A connection may send any number of requests. It works on private
+ * copies of the environment, directory, functions and $?, so exports,
+ * cd and definitions stay visible to its later requests but never to
+ * other connections. Parsed lines and the PATH cache are shared.
+ *
+ * Open connections are polled together and served one request at a
+ * time, so an idle client holds up nobody; a request that has started
+ * must arrive in full within SERVE_REQUEST_TIMEOUT seconds.
+ */
+
+#define SERVE_MAX_REQUEST 65536
+#define SERVE_BACKLOG 16
+#define SERVE_MAX_SESSIONS 64
+#define SERVE_REQUEST_TIMEOUT 5
+
+/* State of one client connection, conn is -1 for a free slot */
+typedef struct s_session
+{
+	int		conn;
+	int		fds[3];
+	t_env	*env;
+	char	*cwd;
+	t_func	*functions;
+	int		status;
+}	t_session;
+
+/* Server-wide state kept while a session's state is swapped in */
+typedef struct s_base
+{
+	t_env	*env;
+	char	*cwd;
+	t_func	*functions;
+}	t_base;
+
+/**
+ * Create the listening socket, replacing a stale socket file
+ * @param path Socket path
+ * @return Listening descriptor or -1 on error
+ */
+static int	serve_listen(char *path)
+{
+	struct sockaddr_un	addr;
+	struct stat			st;
+	mode_t				mask;
+	int					fd;
+
+	if (ft_strlen(path) >= sizeof(addr.sun_path))
+	{
+		print_error("serve", path, "socket path too long");
+		return (-1);
+	}
+	ft_memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	ft_memcpy(addr.sun_path, path, ft_strlen(path) + 1);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return (-1);
+	// A socket nobody accepts on is left over from an earlier server
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)
+		&& connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+		unlink(path);
+	close(fd);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	// Only the owner may connect and run commands as this user
+	mask = umask(077);
+	if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		close(fd);
+		fd = -1;
+	}
+	umask(mask);
+	if (fd < 0 || listen(fd, SERVE_BACKLOG) != 0)
+	{
+		print_error("serve", path, strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+/**
+ * Close the descriptors passed with a rejected request
+ * @param cmsg SCM_RIGHTS control message
+ */
+static void	close_passed_fds(struct cmsghdr *cmsg)
+{
+	int		fd;
+	size_t	count;
+	size_t	i;
+
+	count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+	i = 0;
+	while (i < count)
+	{
+		ft_memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+		close(fd);
+		i++;
+	}
+}
+
+/**
+ * Receive the length of a request together with the client's stdio
+ * @param s Session, fds are filled in
+ * @param len Payload length
+ * @return SUCCESS, or ERROR on EOF or a malformed request
+ */
+static int	recv_header(t_session *s, uint32_t *len)
+{
+	struct msghdr	msg;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	char			control[CMSG_SPACE(sizeof(int) * 3)];
+	ssize_t			n;
+
+	ft_memset(&msg, 0, sizeof(msg));
+	iov.iov_base = len;
+	iov.iov_len = sizeof(*len);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	n = recvmsg(s->conn, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+	cmsg = CMSG_FIRSTHDR(&msg);
+	// More than 3 fds truncate the message; the ones that fit still arrive
+	if (cmsg && cmsg->cmsg_level == SOL_SOCKET
+		&& cmsg->cmsg_type == SCM_RIGHTS && !(msg.msg_flags & MSG_CTRUNC)
+		&& cmsg->cmsg_len == CMSG_LEN(sizeof(int) * 3))
+		ft_memcpy(s->fds, CMSG_DATA(cmsg), sizeof(int) * 3);
+	else if (cmsg && cmsg->cmsg_type == SCM_RIGHTS)
+	{
+		close_passed_fds(cmsg);
+		print_error("serve", NULL, "request must pass exactly 3 fds");
+		return (ERROR);
+	}
+	if (n != sizeof(*len) || s->fds[0] < 0 || *len == 0
+		|| *len > SERVE_MAX_REQUEST)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Read the whole payload of a request
+ * @param conn Connection descriptor
+ * @param len Payload length
+ * @return NUL-terminated payload or NULL on error
+ */
+static char	*recv_payload(int conn, uint32_t len)
+{
+	char	*payload;
+	size_t	got;
+	ssize_t	n;
+
+	payload = ft_malloc(len + 1);
+	if (!payload)
+		return (NULL);
+	got = 0;
+	while (got < len)
+	{
+		n = read(conn, payload + got, len - got);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+		{
+			ft_free(payload);
+			return (NULL);
+		}
+		got += n;
+	}
+	payload[len] = '\0';
+	return (payload);
+}
+
+/**
+ * Apply the KEY=VALUE fields that follow the command line
+ * @param shell Shell structure
+ * @param field First overlay field
+ * @param end End of the payload
+ */
+static void	apply_overlay(t_shell *shell, char *field, char *end)
+{
+	char	*eq;
+
+	while (field < end)
+	{
+		eq = ft_strchr(field, '=');
+		if (eq)
+		{
+			*eq = '\0';
+			if (is_valid_variable_name(field))
+				set_env_value(shell->env_list, field, eq + 1);
+			*eq = '=';
+		}
+		field += ft_strlen(field) + 1;
+	}
+}
+
+/**
+ * Run one command line with the client's stdio
+ * @param shell Shell structure
+ * @param s Session holding the client's fds
+ * @param line Command line
+ * @return Exit status
+ */
+static int	run_request(t_shell *shell, t_session *s, char *line)
+{
+	int	saved[3];
+	int	i;
+
+	i = 0;
+	while (i < 3)
+	{
+		saved[i] = dup(i);
+		dup2(s->fds[i], i);
+		close(s->fds[i]);
+		s->fds[i] = -1;
+		i++;
+	}
+	run_command_string(shell, line);
+	builtin_flush();
+	while (--i >= 0)
+	{
+		dup2(saved[i], i);
+		close(saved[i]);
+	}
+	return (shell->exit_status);
+}
+
+/**
+ * Swap a session's environment, directory, functions and $? in
+ * @param shell Shell structure
+ * @param s Session
+ * @param base Filled with the server's own state
+ */
+static void	enter_session(t_shell *shell, t_session *s, t_base *base)
+{
+	base->env = shell->env_list;
+	base->functions = shell->functions;
+	base->cwd = NULL;
+	if (cwd_logical(shell))
+		base->cwd = ft_strdup(cwd_logical(shell));
+	shell->env_list = s->env;
+	shell->functions = s->functions;
+	shell->exit_status = s->status;
+	env_generation(1);
+	if (s->cwd && (!base->cwd || ft_strcmp(s->cwd, base->cwd) != 0))
+		cwd_change(shell, s->cwd, 0);
+}
+
+/**
+ * Keep the session's state and put the server's back
+ * @param shell Shell structure
+ * @param s Session
+ * @param base Server state from enter_session
+ */
+static void	leave_session(t_shell *shell, t_session *s, t_base *base)
+{
+	s->env = shell->env_list;
+	s->functions = shell->functions;
+	s->status = shell->exit_status;
+	if (cwd_logical(shell) && (!s->cwd
+			|| ft_strcmp(s->cwd, cwd_logical(shell)) != 0))
+	{
+		ft_free(s->cwd);
+		s->cwd = ft_strdup(cwd_logical(shell));
+	}
+	shell->env_list = base->env;
+	shell->functions = base->functions;
+	shell->exit_status = 0;
+	env_generation(1);
+	if (base->cwd && (!cwd_logical(shell)
+			|| ft_strcmp(base->cwd, cwd_logical(shell)) != 0))
+		cwd_change(shell, base->cwd, 0);
+	ft_free(base->cwd);
+}
+
+/**
+ * Serve the request a client has started sending
+ * @param shell Shell structure
+ * @param s Session
+ * @return SUCCESS, or ERROR once the connection should be closed
+ */
+static int	serve_request(t_shell *shell, t_session *s)
+{
+	t_base		base;
+	uint32_t	len;
+	int32_t		status;
+	char		*payload;
+	int			i;
+	int			done;
+
+	ft_memset(s->fds, -1, sizeof(s->fds));
+	payload = NULL;
+	if (recv_header(s, &len) == SUCCESS)
+		payload = recv_payload(s->conn, len);
+	i = 0;
+	while (!payload && i < 3)
+		if (s->fds[i++] >= 0)
+			close(s->fds[i - 1]);
+	if (!payload)
+		return (ERROR);
+	enter_session(shell, s, &base);
+	apply_overlay(shell, payload + ft_strlen(payload) + 1, payload + len);
+	status = run_request(shell, s, payload);
+	ft_free(payload);
+	// exit ends the client's session, not the server
+	done = !shell->running;
+	shell->running = 1;
+	leave_session(shell, s, &base);
+	if (send(s->conn, &status, sizeof(status), MSG_NOSIGNAL) < 0 || done)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Start a session with private copies of the server's state
+ * @param shell Shell structure
+ * @param s Free session slot
+ * @param conn Accepted connection
+ */
+static void	open_session(t_shell *shell, t_session *s, int conn)
+{
+	struct timeval	timeout;
+
+	ft_memset(s, 0, sizeof(t_session));
+	s->env = env_dup(shell->env_list);
+	if (cwd_logical(shell))
+		s->cwd = ft_strdup(cwd_logical(shell));
+	if ((shell->env_list && !s->env) || (cwd_logical(shell) && !s->cwd)
+		|| copy_functions(shell, shell->functions, &s->functions) != SUCCESS)
+	{
+		free_env(s->env);
+		ft_free(s->cwd);
+		close(conn);
+		s->conn = -1;
+		return ;
+	}
+	timeout.tv_sec = SERVE_REQUEST_TIMEOUT;
+	timeout.tv_usec = 0;
+	setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	fcntl(conn, F_SETFD, FD_CLOEXEC);
+	s->conn = conn;
+}
+
+/**
+ * Drop a session and everything it changed
+ * @param s Session
+ */
+static void	close_session(t_session *s)
+{
+	free_env(s->env);
+	free_functions(s->functions);
+	ft_free(s->cwd);
+	close(s->conn);
+	s->conn = -1;
+}
+
+/**
+ * Accept a new client into a free session slot
+ * @param shell Shell structure
+ * @param sessions Session slots
+ * @param listen_fd Listening descriptor
+ * @return SUCCESS, or ERROR if accepting failed for good
+ */
+static int	accept_client(t_shell *shell, t_session *sessions, int listen_fd)
+{
+	int	conn;
+	int	i;
+
+	conn = accept(listen_fd, NULL, NULL);
+	if (conn < 0)
+	{
+		if (errno == EINTR || errno == ECONNABORTED || errno == EMFILE
+			|| errno == ENFILE)
+			return (SUCCESS);
+		print_error("serve", "accept", strerror(errno));
+		return (ERROR);
+	}
+	i = 0;
+	while (i < SERVE_MAX_SESSIONS && sessions[i].conn >= 0)
+		i++;
+	if (i == SERVE_MAX_SESSIONS)
+		close(conn);
+	else
+		open_session(shell, &sessions[i], conn);
+	return (SUCCESS);
+}
+
+/**
+ * Accept clients on a Unix socket forever, serving whichever open
+ * connection has a request ready
+ * @param shell Shell structure
+ * @param path Socket path
+ * @return ERROR if the socket cannot be set up or accepting fails
+ */
+int	serve_run(t_shell *shell, char *path)
+{
+	t_session		sessions[SERVE_MAX_SESSIONS];
+	struct pollfd	pfds[SERVE_MAX_SESSIONS + 1];
+	int				i;
+
+	pfds[0].fd = serve_listen(path);
+	if (pfds[0].fd < 0)
+		return (ERROR);
+	// A client closing its stdout must not kill the server through a
+	// builtin; children restore the default before exec
+	signal(SIGPIPE, SIG_IGN);
+	i = 0;
+	while (i < SERVE_MAX_SESSIONS)
+		sessions[i++].conn = -1;
+	while (1)
+	{
+		i = -1;
+		while (++i <= SERVE_MAX_SESSIONS)
+		{
+			if (i > 0)
+				pfds[i].fd = sessions[i - 1].conn;
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+		}
+		if (poll(pfds, SERVE_MAX_SESSIONS + 1, -1) < 0 && errno != EINTR)
+			break ;
+		i = 0;
+		while (++i <= SERVE_MAX_SESSIONS)
+			if (pfds[i].fd >= 0 && pfds[i].revents
+				&& serve_request(shell, &sessions[i - 1]) != SUCCESS)
+				close_session(&sessions[i - 1]);
+		if ((pfds[0].revents & POLLIN)
+			&& accept_client(shell, sessions, pfds[0].fd) != SUCCESS)
+			break ;
+	}
+	close(pfds[0].fd);
+	return (ERROR);
+}
@@ -13,8 +13,33 @@
 #include "../Inc/minishell.h"
 #include <signal.h>
 
-/* Global variable to store received signal number only */
-volatile sig_atomic_t	g_received_signal = 0;
+/* Handlers store the signal number in the slot of the active shell, or
+ * in a scratch slot while no shell is bound
+ */
+static volatile sig_atomic_t	g_unbound_signal = 0;
+static volatile sig_atomic_t	*g_signal_slot = &g_unbound_signal;
+
+/**
+ * Make a shell the one that receives signal notifications
+ * @param shell Shell to bind, or NULL to unbind
+ */
+void	signal_bind(t_shell *shell)
+{
+	if (shell)
+		g_signal_slot = &shell->received_signal;
+	else
+		g_signal_slot = &g_unbound_signal;
+}
+
+/**
+ * Unbind a shell that is going away, if it is the bound one
+ * @param shell Shell being destroyed
+ */
+void	signal_unbind(t_shell *shell)
+{
+	if (g_signal_slot == &shell->received_signal)
+		g_signal_slot = &g_unbound_signal;
+}
 
 /**
  * Safe write function with error checking
@@ -39,7 +64,7 @@ static ssize_t	safe_write(int fd, const void *buf, size_t count)
  */
 void	handle_sigint_interactive(int sig)
 {
-	g_received_signal = sig;
+	*g_signal_slot = sig;
 	if (safe_write(STDERR_FILENO, "\n", 1) == -1)
 		return;
 	
@@ -55,7 +80,7 @@ void	handle_sigint_interactive(int sig)
  */
 void	handle_sigint_exec(int sig)
 {
-	g_received_signal = sig;
+	*g_signal_slot = sig;
 	safe_write(STDERR_FILENO, "\n", 1);
 }
 
@@ -65,7 +90,7 @@ void	handle_sigint_exec(int sig)
  */
 void	handle_sigint_heredoc(int sig)
 {
-	g_received_signal = sig;
+	*g_signal_slot = sig;
 	safe_write(STDERR_FILENO, "\n", 1);
 	if (close(STDIN_FILENO) == -1)
 		perror("minishell: close");
@@ -77,7 +102,7 @@ void	handle_sigint_heredoc(int sig)
  */
 void	handle_sigquit_interactive(int sig)
 {
-	g_received_signal = sig;
+	*g_signal_slot = sig;
 	/* Do nothing in interactive mode as per requirements */
 }
 
@@ -87,7 +112,7 @@ void	handle_sigquit_interactive(int sig)
  */
 void	handle_sigquit_exec(int sig)
 {
-	g_received_signal = sig;
+	*g_signal_slot = sig;
 	safe_write(STDERR_FILENO, "Quit: 3\n", 8);
 }
 
@@ -99,7 +124,7 @@ void	setup_signals(void)
 	struct sigaction	sa_int;
 	struct sigaction	sa_quit;
 	
-	g_received_signal = 0;
+	*g_signal_slot = 0;
 	sa_int.sa_handler = handle_sigint_interactive;
 	sa_int.sa_flags = SA_RESTART; /* Restart interrupted system calls */
 	sigemptyset(&sa_int.sa_mask);
@@ -130,7 +155,7 @@ void	setup_exec_signals(void)
 	struct sigaction	sa_int;
 	struct sigaction	sa_quit;
 	
-	g_received_signal = 0;
+	*g_signal_slot = 0;
 	sa_int.sa_handler = handle_sigint_exec;
 	sa_int.sa_flags = 0; /* Don't restart system calls during execution */
 	sigemptyset(&sa_int.sa_mask);
@@ -160,7 +185,7 @@ void	setup_heredoc_signals(void)
 	struct sigaction	sa_int;
 	struct sigaction	sa_quit;
 	
-	g_received_signal = 0;
+	*g_signal_slot = 0;
 	sa_int.sa_handler = handle_sigint_heredoc;
 	sa_int.sa_flags = 0; /* Don't restart when reading heredoc */
 	sigemptyset(&sa_int.sa_mask);
@@ -189,7 +214,7 @@ void	reset_signals(void)
 	struct sigaction	sa_int;
 	struct sigaction	sa_quit;
 	
-	g_received_signal = 0;
+	*g_signal_slot = 0;
 	sa_int.sa_handler = SIG_DFL;
 	sa_int.sa_flags = 0;
 	sigemptyset(&sa_int.sa_mask);
@@ -224,7 +249,7 @@ void	disable_signals(void)
 	sigaddset(&block_set, SIGQUIT);
 	sigprocmask(SIG_BLOCK, &block_set, NULL);
 	
-	g_received_signal = 0;
+	*g_signal_slot = 0;
 	sa_int.sa_handler = SIG_IGN;
 	sa_int.sa_flags = 0;
 	sigemptyset(&sa_int.sa_mask);
@@ -0,0 +1,114 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   stats.c                                            :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/*
+ * Process-wide runtime counters. Only the shell process counts, so work
+ * done in a forked child (before exec) is never included.
+ */
+
+/**
+ * Get the counter table
+ * @return Counters indexed by t_stat
+ */
+static unsigned long	*stats_table(void)
+{
+	static unsigned long	table[STAT_COUNT];
+
+	return (table);
+}
+
+/**
+ * Add to a counter
+ * @param stat Counter to bump
+ * @param n Amount to add
+ */
+void	stats_add(t_stat stat, unsigned long n)
+{
+	stats_table()[stat] += n;
+}
+
+/**
+ * Reset every counter to zero
+ */
+void	stats_reset(void)
+{
+	ft_memset(stats_table(), 0, sizeof(unsigned long) * STAT_COUNT);
+}
+
+/**
+ * Print the counters as key=value lines or one JSON object
+ * Output to stdout goes through the builtin buffer, after anything
+ * builtins wrote before
+ * @param fd Descriptor to write to
+ * @param json 1 for JSON, 0 for key=value
+ * @return SUCCESS or ERROR
+ */
+int	stats_print(int fd, int json)
+{
+	static char	*names[STAT_COUNT] = {"commands", "forks", "execs",
+		"builtins", "path_lookups", "path_hits", "env_lookups", "heredocs",
+		"builtin_bytes", "wait_usec", "zygote_launches"};
+	char		buf[STAT_COUNT * 48 + 4];
+	int			len;
+	int			i;
+	ssize_t		written;
+
+	len = 0;
+	if (json)
+		buf[len++] = '{';
+	i = 0;
+	while (i < STAT_COUNT)
+	{
+		if (json)
+			len += snprintf(buf + len, sizeof(buf) - len, "%s\"%s\":%lu",
+					i ? "," : "", names[i], stats_table()[i]);
+		else
+			len += snprintf(buf + len, sizeof(buf) - len, "%s=%lu\n",
+					names[i], stats_table()[i]);
+		i++;
+	}
+	if (json)
+		len += snprintf(buf + len, sizeof(buf) - len, "}\n");
+	if (fd == STDOUT_FILENO)
+		written = builtin_write(fd, buf, len);
+	else
+		written = write(fd, buf, len);
+	if (written != len)
+		return (ERROR);
+	return (SUCCESS);
+}
+
+/**
+ * Write the counters as JSON to $MINISHELL_STATS_FILE, if set
+ * Called once at exit
+ * @param shell Shell structure
+ */
+void	stats_dump(t_shell *shell)
+{
+	char	*path;
+	int		fd;
+
+	path = get_env_value(shell->env_list, "MINISHELL_STATS_FILE");
+	if (!path || !*path)
+		return ;
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+	{
+		print_error("shellstats", path, strerror(errno));
+		return ;
+	}
+	if (stats_print(fd, 1) != SUCCESS)
+		print_error("shellstats", path, "write error");
+	close(fd);
+}
@@ -49,47 +49,6 @@ int	restore_terminal(t_shell *shell)
 	return (SUCCESS);
 }
 
-/**
- * Check if string contains only whitespace
- * @param str String to check
- * @return 1 if only whitespace, 0 otherwise
- */
-static int	is_only_whitespace(const char *str)
-{
-	int	i;
-
-	if (!str)
-		return (1);
-		
-	i = 0;
-	while (str[i])
-	{
-		if (str[i] != ' ' && str[i] != '\t' && str[i] != '\n')
-			return (0);
-		i++;
-	}
-	
-	return (1);
-}
-
-/**
- * Safely add input to command history
- * @param input Input string to add to history
- * @return SUCCESS or ERROR
- */
-int	handle_history(char *input)
-{
-	// Skip empty inputs, NULL or whitespace-only inputs
-	if (!input || !*input || is_only_whitespace(input))
-		return (SUCCESS);
-	
-	// Add to history - readline's add_history doesn't return a value
-	// so we can't check for errors, but we handle input validation above
-	add_history(input);
-	
-	return (SUCCESS);
-}
-
 /**
  * Handle signal state transitions
  * @param shell Shell structure
@@ -125,7 +84,7 @@ void	cleanup_interrupted_heredoc(t_shell *shell)
 	{
 		// Clean up the temporary file
 		cleanup_heredoc(shell->heredoc_file);
-		free(shell->heredoc_file);
+		ft_free(shell->heredoc_file);
 		shell->heredoc_file = NULL;
 		shell->heredoc_active = 0;
 		
@@ -230,7 +189,7 @@ int	end_heredoc(t_shell *shell)
 	shell->heredoc_active = 0;
 	if (shell->heredoc_file)
 	{
-		free(shell->heredoc_file);
+		ft_free(shell->heredoc_file);
 		shell->heredoc_file = NULL;
 	}
 	
@@ -12,24 +12,6 @@
 
 #include "../Inc/minishell.h"
 
-/**
- * Safe malloc wrapper with error checking
- * @param size Size of memory to allocate
- * @return Allocated memory pointer or NULL on failure
- */
-void	*ft_malloc(size_t size)
-{
-	void	*ptr;
-
-	ptr = malloc(size);
-	if (!ptr)
-	{
-		perror("minishell: malloc");
-		return (NULL);
-	}
-	return (ptr);
-}
-
 /**
  * Calculate the length of a string
  * @param s The string to measure
@@ -61,7 +43,7 @@ char	*ft_strdup(const char *s)
 	if (!s)
 		return (NULL);
 	len = ft_strlen(s);
-	dup = (char *)malloc(sizeof(char) * (len + 1));
+	dup = (char *)ft_malloc(sizeof(char) * (len + 1));
 	if (!dup)
 		return (NULL);
 	i = 0;
@@ -94,7 +76,7 @@ char	*ft_substr(char const *s, unsigned int start, size_t len)
 		return (ft_strdup(""));
 	if (len > s_len - start)
 		len = s_len - start;
-	substr = (char *)malloc(sizeof(char) * (len + 1));
+	substr = (char *)ft_malloc(sizeof(char) * (len + 1));
 	if (!substr)
 		return (NULL);
 	i = 0;
@@ -219,7 +201,7 @@ char	*ft_strjoin(char const *s1, char const *s2)
 		return (ft_strdup(s1));
 	len1 = ft_strlen(s1);
 	len2 = ft_strlen(s2);
-	joined = (char *)malloc(sizeof(char) * (len1 + len2 + 1));
+	joined = (char *)ft_malloc(sizeof(char) * (len1 + len2 + 1));
 	if (!joined)
 		return (NULL);
 	i = 0;
@@ -295,10 +277,10 @@ static void	free_split(char **split, size_t i)
 	j = 0;
 	while (j < i)
 	{
-		free(split[j]);
+		ft_free(split[j]);
 		j++;
 	}
-	free(split);
+	ft_free(split);
 }
 
 /**
@@ -317,7 +299,7 @@ char	**ft_split(char const *s, char c)
 	if (!s)
 		return (NULL);
 	word_count = count_words(s, c);
-	split = (char **)malloc(sizeof(char *) * (word_count + 1));
+	split = (char **)ft_malloc(sizeof(char *) * (word_count + 1));
 	if (!split)
 		return (NULL);
 	i = 0;
@@ -426,7 +408,7 @@ char	*ft_itoa(int n)
 	long	num;
 
 	digits = count_digits(n);
-	str = (char *)malloc(sizeof(char) * (digits + 1));
+	str = (char *)ft_malloc(sizeof(char) * (digits + 1));
 	if (!str)
 		return (NULL);
 	str[digits] = '\0';
@@ -486,6 +468,8 @@ int	ft_atoi(const char *str)
  */
 void	print_error(char *cmd, char *arg, char *message)
 {
+	// Keep messages in order with buffered builtin output
+	builtin_flush();
 	ft_putstr_fd("minishell: ", STDERR_FILENO);
 	if (cmd)
 	{
@@ -542,6 +526,32 @@ void	*ft_memset(void *b, int c, size_t len)
 	return (b);
 }
 
+void	*ft_memcpy(void *dst, const void *src, size_t n)
+{
+	unsigned char		*d;
+	const unsigned char	*s;
+
+	d = (unsigned char *)dst;
+	s = (const unsigned char *)src;
+	while (n--)
+		*d++ = *s++;
+	return (dst);
+}
+
+void	*ft_memchr(const void *s, int c, size_t n)
+{
+	const unsigned char	*p;
+
+	p = (const unsigned char *)s;
+	while (n--)
+	{
+		if (*p == (unsigned char)c)
+			return ((void *)p);
+		p++;
+	}
+	return (NULL);
+}
+
 void	ft_putchar_fd(char c, int fd)
 {
 	write(fd, &c, 1);
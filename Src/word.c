@@ -0,0 +1,219 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   word.c                                             :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/08 16:02:51 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/08 16:02:51 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+
+/**
+ * Create an empty word
+ * @return New word or NULL on error
+ */
+t_word	*new_word(void)
+{
+	t_word	*word;
+
+	word = (t_word *)ft_malloc(sizeof(t_word));
+	if (!word)
+		return (NULL);
+	word->text = ft_strdup("");
+	if (!word->text)
+	{
+		ft_free(word);
+		return (NULL);
+	}
+	word->segs = NULL;
+	word->last = NULL;
+	word->quoted = 0;
+	word->has_params = 0;
+	word->next = NULL;
+	return (word);
+}
+
+/**
+ * Append raw text to the quote-removed text of a word
+ * @param word Word to extend
+ * @param prefix Optional prefix (e.g. "$" for parameters) or NULL
+ * @param text Text to append
+ * @param len Number of bytes of text to append
+ * @return SUCCESS or ERROR
+ */
+static int	append_text(t_word *word, char *prefix, char *text, int len)
+{
+	char	*tmp;
+	char	*joined;
+
+	tmp = ft_substr(text, 0, len);
+	if (!tmp)
+		return (ERROR);
+	if (prefix)
+	{
+		joined = ft_strjoin(prefix, tmp);
+		ft_free(tmp);
+		if (!joined)
+			return (ERROR);
+		tmp = joined;
+	}
+	joined = ft_strjoin(word->text, tmp);
+	ft_free(tmp);
+	if (!joined)
+		return (ERROR);
+	ft_free(word->text);
+	word->text = joined;
+	return (SUCCESS);
+}
+
+/**
+ * Append a segment to a word
+ * Quoted segments are kept even when empty so that "" still yields an
+ * (empty) argument after expansion
+ * @param word Word to extend
+ * @param type Segment type
+ * @param text Segment text (parameter name for SEG_PARAM)
+ * @param len Number of bytes of text
+ * @return SUCCESS or ERROR
+ */
+int	word_add_segment(t_word *word, t_seg_type type, char *text, int len)
+{
+	t_segment	*seg;
+
+	seg = (t_segment *)ft_malloc(sizeof(t_segment));
+	if (!seg)
+		return (ERROR);
+	seg->text = ft_substr(text, 0, len);
+	if (!seg->text)
+	{
+		ft_free(seg);
+		return (ERROR);
+	}
+	seg->type = type;
+	seg->quoted = (type == SEG_SQUOTE || type == SEG_DQUOTE);
+	seg->next = NULL;
+	if (word->last)
+		word->last->next = seg;
+	else
+		word->segs = seg;
+	word->last = seg;
+	if (seg->quoted)
+		word->quoted = 1;
+	if (type == SEG_PARAM)
+	{
+		word->has_params = 1;
+		return (append_text(word, "$", text, len));
+	}
+	return (append_text(word, NULL, text, len));
+}
+
+/**
+ * Build an unquoted literal word from plain text
+ * @param text Word text
+ * @return New word or NULL on error
+ */
+t_word	*word_from_text(char *text)
+{
+	t_word	*word;
+
+	word = new_word();
+	if (!word)
+		return (NULL);
+	if (*text && word_add_segment(word, SEG_LITERAL, text,
+			ft_strlen(text)) != SUCCESS)
+	{
+		free_words(word);
+		return (NULL);
+	}
+	return (word);
+}
+
+/**
+ * Deep copy a single word (its next link is not followed)
+ * @param word Word to copy
+ * @return Copied word or NULL on error
+ */
+t_word	*copy_word(t_word *word)
+{
+	t_word		*copy;
+	t_segment	*seg;
+
+	copy = new_word();
+	if (!copy)
+		return (NULL);
+	seg = word->segs;
+	while (seg)
+	{
+		if (word_add_segment(copy, seg->type, seg->text,
+				ft_strlen(seg->text)) != SUCCESS)
+		{
+			free_words(copy);
+			return (NULL);
+		}
+		copy->last->quoted = seg->quoted;
+		seg = seg->next;
+	}
+	return (copy);
+}
+
+/**
+ * Deep copy a list of words
+ * @param words Word list to copy
+ * @return Copied list, or NULL on error or for an empty list
+ */
+t_word	*copy_words(t_word *words)
+{
+	t_word	*head;
+	t_word	*last;
+	t_word	*copy;
+
+	head = NULL;
+	last = NULL;
+	while (words)
+	{
+		copy = copy_word(words);
+		if (!copy)
+		{
+			free_words(head);
+			return (NULL);
+		}
+		if (!head)
+			head = copy;
+		else
+			last->next = copy;
+		last = copy;
+		words = words->next;
+	}
+	return (head);
+}
+
+/**
+ * Free a list of words and their segments
+ * @param words Word list to free
+ */
+void	free_words(t_word *words)
+{
+	t_word		*next;
+	t_segment	*seg;
+	t_segment	*next_seg;
+
+	while (words)
+	{
+		next = words->next;
+		seg = words->segs;
+		while (seg)
+		{
+			next_seg = seg->next;
+			ft_free(seg->text);
+			ft_free(seg);
+			seg = next_seg;
+		}
+		ft_free(words->text);
+		ft_free(words);
+		words = next;
+	}
+}
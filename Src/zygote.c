@@ -0,0 +1,425 @@
+/* ************************************************************************** */
+/*                                                                            */
+/*                                                        :::      ::::::::   */
+/*   zygote.c                                           :+:      :+:    :+:   */
+/*                                                    +:+ +:+         +:+     */
+/*   By: quvan-de <quvan-de@student.42.fr>          +#+  +:+       +#+        */
+/*                                                +#+#+#+#+#+   +#+           */
+/*   Created: 2025/06/06 10:41:09 by quvan-de          #+#    #+#             */
+/*   Updated: 2025/06/06 10:41:09 by quvan-de         ###   ########.fr       */
+/*                                                                            */
+/* ************************************************************************** */
+
+#include "../Inc/minishell.h"
+#include <stdint.h>
+#include <sys/socket.h>
+
+/*
+ * A zygote is a child forked ahead of time that blocks on its end of a
+ * socketpair. To launch a command the shell sends it one request:
+ *
+ *   header   argc and the payload length
+ *   fds      stdin, stdout, stderr and the working directory (SCM_RIGHTS)
+ *   payload  path, argv[0..argc-1], then the environment, each NUL ended
+ *
+ * The zygote installs the fds, enters the directory and execs. It stays
+ * a child of the shell, so it is waited for like any forked command.
+ * Each zygote runs one command; used ones are replaced the next time
+ * the prompt is shown.
+ */
+
+#define ZYGOTE_FDS 4
+
+typedef struct s_zygote_msg
+{
+	uint32_t	argc;
+	uint32_t	len;
+}	t_zygote_msg;
+
+/**
+ * Read exactly len bytes
+ * @param fd Descriptor to read from
+ * @param buf Destination
+ * @param len Number of bytes
+ * @return SUCCESS or ERROR
+ */
+static int	read_full(int fd, char *buf, size_t len)
+{
+	ssize_t	n;
+
+	while (len > 0)
+	{
+		n = read(fd, buf, len);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			return (ERROR);
+		buf += n;
+		len -= n;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Receive the header of a request and its descriptors
+ * @param sock Zygote end of the socketpair
+ * @param msg Header to fill in
+ * @param fds Descriptors to fill in
+ * @return SUCCESS or ERROR
+ */
+static int	recv_request(int sock, t_zygote_msg *msg, int *fds)
+{
+	struct msghdr	hdr;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	char			control[CMSG_SPACE(sizeof(int) * ZYGOTE_FDS)];
+
+	ft_memset(&hdr, 0, sizeof(hdr));
+	iov.iov_base = msg;
+	iov.iov_len = sizeof(*msg);
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	hdr.msg_control = control;
+	hdr.msg_controllen = sizeof(control);
+	if (recvmsg(sock, &hdr, MSG_WAITALL) != sizeof(*msg))
+		return (ERROR);
+	cmsg = CMSG_FIRSTHDR(&hdr);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS
+		|| cmsg->cmsg_len != CMSG_LEN(sizeof(int) * ZYGOTE_FDS))
+		return (ERROR);
+	ft_memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * ZYGOTE_FDS);
+	return (SUCCESS);
+}
+
+/**
+ * Split a payload into the path, argv and envp arrays
+ * @param payload Request payload
+ * @param msg Request header
+ * @param envp Set to the environment array
+ * @return argv array, or NULL on error
+ */
+static char	**split_payload(char *payload, t_zygote_msg *msg, char ***envp)
+{
+	char		**vec;
+	uint32_t	count;
+	uint32_t	i;
+	char		*p;
+
+	count = 0;
+	p = payload;
+	while (p < payload + msg->len)
+	{
+		p += ft_strlen(p) + 1;
+		count++;
+	}
+	// The path comes first and is not part of argv
+	if (count < msg->argc + 1)
+		return (NULL);
+	vec = (char **)ft_malloc(sizeof(char *) * (count + 1));
+	if (!vec)
+		return (NULL);
+	p = payload + ft_strlen(payload) + 1;
+	i = 0;
+	while (i < count - 1)
+	{
+		vec[i + (i >= msg->argc)] = p;
+		p += ft_strlen(p) + 1;
+		i++;
+	}
+	vec[msg->argc] = NULL;
+	vec[count] = NULL;
+	*envp = vec + msg->argc + 1;
+	return (vec);
+}
+
+/**
+ * Body of a zygote: wait for one request and exec it
+ * Idle zygotes ignore the terminal's SIGINT and SIGQUIT, the command
+ * gets the default dispositions back like a freshly forked child
+ * @param sock Zygote end of the socketpair
+ */
+static void	zygote_main(int sock)
+{
+	t_zygote_msg	msg;
+	int				fds[ZYGOTE_FDS];
+	char			*payload;
+	char			**argv;
+	char			**envp;
+	int				i;
+
+	signal(SIGINT, SIG_IGN);
+	signal(SIGQUIT, SIG_IGN);
+	if (recv_request(sock, &msg, fds) != SUCCESS)
+		_exit(SUCCESS);
+	payload = ft_malloc(msg.len + 1);
+	if (!payload || read_full(sock, payload, msg.len) != SUCCESS)
+		_exit(ERROR);
+	payload[msg.len] = '\0';
+	argv = split_payload(payload, &msg, &envp);
+	i = 0;
+	while (i < 3)
+	{
+		dup2(fds[i], i);
+		i++;
+	}
+	if (!argv || fchdir(fds[3]) != 0)
+		_exit(ERROR);
+	i = 0;
+	while (i < ZYGOTE_FDS)
+	{
+		if (fds[i] > STDERR_FILENO)
+			close(fds[i]);
+		i++;
+	}
+	close(sock);
+	signal(SIGINT, SIG_DFL);
+	signal(SIGQUIT, SIG_DFL);
+	signal(SIGPIPE, SIG_DFL);
+	execve(payload, argv, envp);
+	print_error(payload, NULL, NULL);
+	_exit(ERROR);
+}
+
+/**
+ * Fork one zygote and add it to the pool
+ * @param pool Zygote pool
+ * @return SUCCESS or ERROR
+ */
+static int	zygote_fork(t_zygote_pool *pool)
+{
+	int		sv[2];
+	pid_t	pid;
+	int		i;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) != 0)
+		return (ERROR);
+	pid = fork();
+	if (pid == 0)
+	{
+		// Only the shell may hold the other zygotes' sockets open
+		i = 0;
+		while (i < pool->count)
+			close(pool->sock[i++]);
+		close(sv[0]);
+		zygote_main(sv[1]);
+	}
+	close(sv[1]);
+	if (pid < 0)
+	{
+		close(sv[0]);
+		return (ERROR);
+	}
+	pool->pid[pool->count] = pid;
+	pool->sock[pool->count++] = sv[0];
+	return (SUCCESS);
+}
+
+/**
+ * Stop the most recently forked zygote
+ * @param pool Zygote pool
+ */
+static void	zygote_drop(t_zygote_pool *pool)
+{
+	pool->count--;
+	// The zygote exits as soon as its socket is closed
+	close(pool->sock[pool->count]);
+	waitpid(pool->pid[pool->count], NULL, 0);
+}
+
+/**
+ * Follow MINISHELL_ZYGOTES, looked up again only after the environment
+ * changed
+ * @param shell Shell structure
+ */
+static void	zygote_sync(t_shell *shell)
+{
+	t_zygote_pool	*pool;
+	char			*value;
+
+	pool = &shell->zygotes;
+	if (pool->synced && pool->generation == env_generation(0))
+		return ;
+	pool->synced = 1;
+	pool->generation = env_generation(0);
+	value = get_env_value(shell->env_list, "MINISHELL_ZYGOTES");
+	pool->size = 0;
+	if (value)
+		pool->size = ft_atoi(value);
+	if (pool->size < 0)
+		pool->size = 0;
+	if (pool->size > ZYGOTE_MAX)
+		pool->size = ZYGOTE_MAX;
+	while (pool->count > pool->size)
+		zygote_drop(pool);
+}
+
+/**
+ * Fork zygotes until the pool has its configured size
+ * Called while the shell is idle, before the prompt is shown
+ * @param shell Shell structure
+ */
+void	zygote_refill(t_shell *shell)
+{
+	zygote_sync(shell);
+	while (shell->zygotes.count < shell->zygotes.size)
+		if (zygote_fork(&shell->zygotes) != SUCCESS)
+			break ;
+}
+
+/**
+ * Copy a string with its terminating NUL
+ * @param dst Destination
+ * @param src String to copy
+ * @return Number of bytes copied
+ */
+static size_t	put_field(char *dst, char *src)
+{
+	size_t	len;
+
+	len = ft_strlen(src) + 1;
+	ft_memcpy(dst, src, len);
+	return (len);
+}
+
+/**
+ * Build the request payload: path, argv and environment
+ * @param path Resolved command path
+ * @param argv Arguments
+ * @param envp Environment
+ * @param msg Header, argc and len are filled in
+ * @return Allocated payload or NULL
+ */
+static char	*build_payload(char *path, char **argv, char **envp,
+	t_zygote_msg *msg)
+{
+	char	*payload;
+	size_t	len;
+	int		i;
+
+	len = ft_strlen(path) + 1;
+	msg->argc = 0;
+	while (argv[msg->argc])
+		len += ft_strlen(argv[msg->argc++]) + 1;
+	i = 0;
+	while (envp[i])
+		len += ft_strlen(envp[i++]) + 1;
+	payload = ft_malloc(len);
+	if (!payload)
+		return (NULL);
+	msg->len = put_field(payload, path);
+	i = 0;
+	while (argv[i])
+		msg->len += put_field(payload + msg->len, argv[i++]);
+	i = 0;
+	while (envp[i])
+		msg->len += put_field(payload + msg->len, envp[i++]);
+	return (payload);
+}
+
+/**
+ * Send a request to a zygote
+ * @param sock Shell end of the zygote's socketpair
+ * @param msg Request header
+ * @param fds stdin, stdout, stderr and the working directory
+ * @param payload Request payload
+ * @return SUCCESS or ERROR
+ */
+static int	send_request(int sock, t_zygote_msg *msg, int *fds, char *payload)
+{
+	struct msghdr	hdr;
+	struct iovec	iov;
+	struct cmsghdr	*cmsg;
+	char			control[CMSG_SPACE(sizeof(int) * ZYGOTE_FDS)];
+	size_t			off;
+	ssize_t			n;
+
+	ft_memset(&hdr, 0, sizeof(hdr));
+	ft_memset(control, 0, sizeof(control));
+	iov.iov_base = msg;
+	iov.iov_len = sizeof(*msg);
+	hdr.msg_iov = &iov;
+	hdr.msg_iovlen = 1;
+	hdr.msg_control = control;
+	hdr.msg_controllen = sizeof(control);
+	cmsg = CMSG_FIRSTHDR(&hdr);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * ZYGOTE_FDS);
+	ft_memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * ZYGOTE_FDS);
+	if (sendmsg(sock, &hdr, MSG_NOSIGNAL) != sizeof(*msg))
+		return (ERROR);
+	off = 0;
+	while (off < msg->len)
+	{
+		n = send(sock, payload + off, msg->len - off, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue ;
+		if (n <= 0)
+			return (ERROR);
+		off += n;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Launch an external command in a zygote instead of forking
+ * Only commands without redirections qualify; the path must already
+ * be resolved into shell->exec_path
+ * @param shell Shell structure
+ * @param cmd Command to launch
+ * @param in_fd Input file descriptor
+ * @param out_fd Output file descriptor
+ * @return pid of the zygote running the command, or -1 to fork instead
+ */
+pid_t	zygote_launch(t_shell *shell, t_command *cmd, int in_fd, int out_fd)
+{
+	t_zygote_pool	*pool;
+	t_zygote_msg	msg;
+	char			**envp;
+	char			*payload;
+	int				fds[ZYGOTE_FDS];
+
+	pool = &shell->zygotes;
+	if (!pool->count || cmd->redirections || !shell->exec_path)
+		return (-1);
+	envp = env_to_array(shell->env_list);
+	payload = NULL;
+	if (envp)
+		payload = build_payload(shell->exec_path, cmd->args, envp, &msg);
+	free_string_array(envp);
+	fds[0] = in_fd;
+	fds[1] = out_fd;
+	fds[2] = STDERR_FILENO;
+	fds[3] = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	while (payload && fds[3] >= 0 && pool->count)
+	{
+		pool->count--;
+		if (send_request(pool->sock[pool->count], &msg, fds, payload)
+			== SUCCESS)
+		{
+			close(pool->sock[pool->count]);
+			close(fds[3]);
+			ft_free(payload);
+			stats_add(STAT_ZYGOTE_LAUNCHES, 1);
+			return (pool->pid[pool->count]);
+		}
+		// The zygote died while idle, reap it and try the next one
+		pool->count++;
+		zygote_drop(pool);
+	}
+	if (fds[3] >= 0)
+		close(fds[3]);
+	ft_free(payload);
+	return (-1);
+}
+
+/**
+ * Stop every zygote
+ * @param pool Zygote pool
+ */
+void	zygote_pool_clear(t_zygote_pool *pool)
+{
+	while (pool->count > 0)
+		zygote_drop(pool);
+	pool->synced = 0;
+}
@@ -12,27 +12,6 @@
 
 #include "Inc/minishell.h"
 
-/**
- * Check if input is only whitespace
- * @param str The string to check
- * @return 1 if only whitespace, 0 otherwise
- */
-static int	is_only_whitespace(const char *str)
-{
-	int	i;
-
-	if (!str)
-		return (1);
-	i = 0;
-	while (str[i])
-	{
-		if (str[i] != ' ' && str[i] != '\t' && str[i] != '\n')
-			return (0);
-		i++;
-	}
-	return (1);
-}
-
 /**
  * Main shell loop
  * @param shell Shell structure
@@ -40,15 +19,14 @@ static int	is_only_whitespace(const char *str)
 void	shell_loop(t_shell *shell)
 {
 	char	*input;
-	int		status;
 
 	while (shell->running)
 	{
 		/* Check for signals that might have been received */
-		if (g_received_signal)
+		if (shell->received_signal)
 		{
-			shell->exit_status = 128 + g_received_signal;
-			g_received_signal = 0;
+			shell->exit_status = 128 + shell->received_signal;
+			shell->received_signal = 0;
 		}
 
 		/* Handle interrupted heredoc */
@@ -66,24 +44,96 @@ void	shell_loop(t_shell *shell)
 		if (!input)
 			continue;
 		
-		/* Skip empty or whitespace-only commands */
-		if (is_only_whitespace(input))
-		{
-			free(input);
-			continue;
-		}
-			
-		status = process_input(input, shell);
-		if (status == SYNTAX_ERROR)
-			shell->exit_status = 2; /* Standard syntax error exit code */
-		else if (status != SUCCESS)
-			handle_interrupted_execution(shell);
-			
-		free(input);
+		run_command_string(shell, input);
+		ft_free(input);
 		input = NULL; /* Prevent use-after-free */
 	}
 }
 
+/**
+ * Report a bad option and print the usage
+ * @param option Option as given
+ * @param msg What is wrong with it
+ * @return SYNTAX_ERROR
+ */
+static int	usage_error(char *option, char *msg)
+{
+	print_error(option, NULL, msg);
+	ft_putstr_fd("usage: minishell [--startup-profile] [-c command]"
+		" [--serve socket]\n", STDERR_FILENO);
+	return (SYNTAX_ERROR);
+}
+
+/**
+ * Parse command line options
+ * Options end at the first operand, "-" or "--"; operands are ignored,
+ * as they always were, and input is still read from stdin
+ * @param argc Argument count
+ * @param argv Argument vector
+ * @param opts Options to fill in
+ * @return SUCCESS or SYNTAX_ERROR on an unknown or incomplete option
+ */
+static int	parse_options(int argc, char **argv, t_options *opts)
+{
+	int	i;
+
+	i = 1;
+	while (i < argc && argv[i][0] == '-' && argv[i][1]
+		&& ft_strcmp(argv[i], "--") != 0)
+	{
+		if (ft_strcmp(argv[i], "--startup-profile") == 0)
+			opts->profile = 1;
+		else if ((ft_strcmp(argv[i], "-c") == 0
+				|| ft_strcmp(argv[i], "--serve") == 0) && i + 1 >= argc)
+			return (usage_error(argv[i], "option requires an argument"));
+		else if (ft_strcmp(argv[i], "-c") == 0)
+			opts->command = argv[++i];
+		else if (ft_strcmp(argv[i], "--serve") == 0)
+			opts->serve = argv[++i];
+		else
+			return (usage_error(argv[i], "invalid option"));
+		i++;
+	}
+	return (SUCCESS);
+}
+
+/**
+ * Run the shell until input ends
+ * Terminal and prompt setup is only done when a prompt will be shown
+ * @param shell Shell structure
+ * @param opts Command line options
+ * @return SUCCESS or ERROR
+ */
+static int	run_shell(t_shell *shell, t_options *opts)
+{
+	if (opts->serve)
+	{
+		profile_report(&shell->profile);
+		return (serve_run(shell, opts->serve));
+	}
+	if (opts->command)
+	{
+		profile_report(&shell->profile);
+		run_command_string(shell, opts->command);
+		return (SUCCESS);
+	}
+	if (!isatty(STDIN_FILENO))
+	{
+		profile_report(&shell->profile);
+		run_noninteractive(shell);
+		return (SUCCESS);
+	}
+	if (init_interactive(shell) != SUCCESS)
+	{
+		ft_putstr_fd("minishell: Shell state verification failed\n",
+			STDERR_FILENO);
+		return (ERROR);
+	}
+	profile_report(&shell->profile);
+	shell_loop(shell);
+	return (SUCCESS);
+}
+
 /**
  * Main function
  * @param argc Argument count
@@ -94,40 +144,29 @@ void	shell_loop(t_shell *shell)
 
 int	main(int argc, char **argv, char **envp)
 {
-	t_shell	*shell;
-	int		exit_status;
+	t_shell		*shell;
+	t_options	opts;
+	int			exit_status;
 
-	(void)argc;
-	(void)argv;
-	shell = init_shell(envp);
+	ft_memset(&opts, 0, sizeof(opts));
+	if (parse_options(argc, argv, &opts) != SUCCESS)
+		return (SYNTAX_ERROR);
+	shell = init_shell(envp, opts.profile);
 	if (!shell)
 	{
 		ft_putstr_fd("minishell: Failed to initialize shell\n", STDERR_FILENO);
 		return (ERROR);
 	}
 	
-	// Setup terminal with error checking
-	if (setup_terminal(shell) != SUCCESS && recover_terminal_error(shell) != SUCCESS)
+	// An exit in the rc file ends the shell before any input is read
+	rc_load(shell);
+	profile_step(&shell->profile, "rc");
+	if (shell->running && run_shell(shell, &opts) != SUCCESS)
 	{
-		ft_putstr_fd("minishell: Fatal terminal setup error\n", STDERR_FILENO);
 		cleanup_shell(shell);
 		return (ERROR);
 	}
 	
-	// Setup signal handlers
-	set_signal_mode(shell, 0);
-	
-	// Verify shell state
-	if (verify_shell_state(shell) != SUCCESS)
-	{
-		ft_putstr_fd("minishell: Shell state verification failed\n", STDERR_FILENO);
-		cleanup_shell(shell);
-		return (ERROR);
-	}
-	
-	// Main shell loop
-	shell_loop(shell);
-	
 	// Final cleanup of any remaining heredoc files
 	if (shell->heredoc_active)
 	{
@@ -141,7 +180,8 @@ int	main(int argc, char **argv, char **envp)
 	}
 	
 	// Cleanup and return
+	stats_dump(shell);
 	exit_status = shell->exit_status;
 	cleanup_shell(shell);
 	return (exit_status);
-}
\ No newline at end of file
+}
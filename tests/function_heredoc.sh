@@ -0,0 +1,21 @@
+#!/bin/sh
+# A heredoc in a function body must survive every call of the function.
+# Usage: tests/function_heredoc.sh [path/to/minishell]
+
+SHELL_BIN=${1:-./minishell}
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT"' EXIT
+cat > "$SCRIPT" <<'EOF_SCRIPT'
+f() { cat <<E; }
+body
+E
+f
+f
+EOF_SCRIPT
+out=$(timeout 10 "$SHELL_BIN" < "$SCRIPT" 2>&1)
+expected=$(printf 'body\nbody')
+if [ "$out" != "$expected" ]; then
+	echo "FAIL: heredoc in a function called twice (output '$out')"
+	exit 1
+fi
+echo "ok: heredoc in a function called twice"
@@ -0,0 +1,34 @@
+#!/bin/sh
+# The lexer must not read past the end of a line, whatever its length.
+# Meant to run against an AddressSanitizer build (make check-asan).
+# Usage: tests/lexer_scan.sh [path/to/minishell]
+
+SHELL_BIN=${1:-./minishell}
+fail=0
+
+check()
+{
+	# Lines read from stdin live on the heap, where ASan sees overreads
+	out=$(printf '%s\n' "$1" | "$SHELL_BIN" 2>&1)
+	status=$?
+	if [ "$status" -ne 0 ] || [ "$out" != "$2" ]; then
+		echo "FAIL: $1 (status $status, output '$out')"
+		fail=1
+	fi
+}
+
+check 'echo $' '$'
+check 'echo "$"' '$'
+check 'echo   ' ''
+n=0
+word=''
+while [ $n -lt 80 ]; do
+	check "echo $word\$" "$word\$"
+	check "echo \"$word\$\"" "$word\$"
+	check "echo $word'q'" "${word}q"
+	check "echo $word   " "$word"
+	word="${word}a"
+	n=$((n + 1))
+done
+[ $fail -eq 0 ] && echo "ok: lines of 0 to 80 characters"
+exit $fail
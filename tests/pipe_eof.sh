@@ -0,0 +1,27 @@
+#!/bin/sh
+# A builtin stage writing into a pipe must stop once its reader exits.
+# Usage: tests/pipe_eof.sh [path/to/minishell]
+
+SHELL_BIN=${1:-./minishell}
+BIG=$(mktemp)
+trap 'rm -f "$BIG"' EXIT
+seq 1 300000 > "$BIG"
+fail=0
+
+check()
+{
+	out=$(timeout 10 "$SHELL_BIN" -c "$1" </dev/null)
+	status=$?
+	if [ "$status" -eq 124 ] || [ "$out" != "$2" ]; then
+		echo "FAIL: $1 (status $status, output '$out')"
+		fail=1
+	else
+		echo "ok: $1"
+	fi
+}
+
+check "cat $BIG | head -1" "1"
+check "cat /dev/zero | head -c 3 | wc -c" "3"
+check "printf %0200000d 1 | head -c 1" "0"
+check "f() { cat $BIG; }; f | head -1" "1"
+exit $fail